@@ -0,0 +1,65 @@
+#version 150
+
+uniform sampler3D tex_volume;
+uniform sampler1D tex_clut;
+uniform vec3 plane_origin;
+uniform vec3 plane_u;
+uniform vec3 plane_v;
+uniform vec3 plane_n;
+uniform int slab_mode;      // 0 = single plane, 1 = MIP, 2 = MinIP, 3 = mean
+uniform int slab_samples;
+uniform float window_min;
+uniform float window_multiplier;
+uniform bool signed_normalized;
+
+in vec2 fs_texcoord;
+out vec4 display_color;
+
+bool inside(vec3 texcoord)
+{
+    return all(greaterThanEqual(texcoord, vec3(0.0))) && all(lessThanEqual(texcoord, vec3(1.0)));
+}
+
+void main()
+{
+    // position on the slice plane in volume texture coordinates
+    vec3 texcoord = plane_origin + fs_texcoord.x * plane_u + fs_texcoord.y * plane_v;
+    
+    float value;
+    if (slab_mode == 0) {
+        if (!inside(texcoord))
+            discard;
+        value = texture(tex_volume, texcoord).r;
+    } else {
+        // combine the planes of the slab, which starts slab_samples / 2 planes behind this one
+        vec3 p = texcoord - float(slab_samples / 2) * plane_n;
+        float result = (slab_mode == 1) ? -1.0 : ((slab_mode == 2) ? 1.0 : 0.0);
+        int count = 0;
+        for (int i = 0; i < slab_samples; i++, p += plane_n) {
+            if (!inside(p))
+                continue;
+            float s = texture(tex_volume, p).r;
+            if (slab_mode == 1)
+                result = max(result, s);
+            else if (slab_mode == 2)
+                result = min(result, s);
+            else
+                result += s;
+            count++;
+        }
+        if (count == 0)
+            discard;
+        value = (slab_mode == 3) ? result / float(count) : result;
+    }
+    
+    // signed values need to be converted from [-1,1] to [0,1]
+    if (signed_normalized)
+        value = value * 0.5 + 0.5;
+    
+    // apply window transform
+    value = (value - window_min) * window_multiplier;
+    value = max(min(1.0, value), 0.0);
+    
+    // color/opacity from look-up table using windowed data value
+    display_color = texture(tex_clut, value).rgba;
+}
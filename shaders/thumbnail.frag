@@ -0,0 +1,12 @@
+#version 330
+
+uniform sampler2D atlas;
+uniform float alpha;
+in vec2 fs_texcoord;
+out vec4 display_color;
+
+void main()
+{
+    float v = texture(atlas, fs_texcoord).r;
+    display_color = vec4(v, v, v, alpha);
+}
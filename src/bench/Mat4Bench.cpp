@@ -0,0 +1,168 @@
+// Times the Mat4 kernels in gl/math/Simd.h, scalar against SIMD, and checks that the SIMD results
+// match the scalar ones. Exits with 1 if they don't.
+
+#include "gl/math/Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+	const int numMatrices = 1024;
+	const int repeats = 200;
+
+	// sink for the results, so the timed loops aren't optimized away
+	volatile float sink;
+
+	struct Data
+	{
+		vector<float> a;    // numMatrices matrices
+		vector<float> b;    // numMatrices matrices
+		vector<float> v;    // numMatrices vectors
+		vector<float> out;  // numMatrices matrices
+	};
+
+	/** Random matrices with a dominant diagonal, so they are well conditioned for the inverse */
+	Data randomData()
+	{
+		mt19937 rng(42);
+		uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+		Data d;
+		d.a.resize(numMatrices * 16);
+		d.b.resize(numMatrices * 16);
+		d.v.resize(numMatrices * 4);
+		d.out.resize(numMatrices * 16);
+		for (int i = 0; i < numMatrices * 16; i++) {
+			d.a[i] = value(rng) + ((i % 16) % 5 == 0 ? 4.0f : 0.0f);
+			d.b[i] = value(rng);
+		}
+		for (int i = 0; i < numMatrices * 4; i++) {
+			d.v[i] = value(rng);
+		}
+		return d;
+	}
+
+	/** Nanoseconds per call of fn(i) for i in [0, numMatrices) */
+	template <typename F> double nsPerCall(F fn)
+	{
+		auto start = high_resolution_clock::now();
+		for (int r = 0; r < repeats; r++) {
+			for (int i = 0; i < numMatrices; i++) {
+				fn(i);
+			}
+		}
+		double ns = duration_cast<duration<double, nano>>(high_resolution_clock::now() - start).count();
+		return ns / (static_cast<double>(repeats) * numMatrices);
+	}
+
+	/** Largest difference between two arrays relative to the magnitude of the expected values */
+	float compare(const float* expected, const float* actual, int n)
+	{
+		float error = 0.0f;
+		for (int i = 0; i < n; i++) {
+			error = max(error, abs(expected[i] - actual[i]) / max(1.0f, abs(expected[i])));
+		}
+		return error;
+	}
+
+	bool report(const char* name, double scalarNs, double simdNs, float error, float tolerance)
+	{
+		bool ok = error <= tolerance;
+		printf("%-16s scalar %7.2f ns   simd %7.2f ns   speedup %5.2fx   max error %.2e %s\n",
+			name, scalarNs, simdNs, scalarNs / simdNs, error, ok ? "ok" : "MISMATCH");
+		return ok;
+	}
+}
+
+int main()
+{
+	Data d = randomData();
+	float* a = d.a.data();
+	float* b = d.b.data();
+	float* v = d.v.data();
+	float* out = d.out.data();
+	bool ok = true;
+
+#if defined(GL_MATH_SSE)
+	printf("SIMD kernels: SSE\n");
+#elif defined(GL_MATH_NEON)
+	printf("SIMD kernels: NEON (the inverse is scalar)\n");
+#else
+	printf("SIMD kernels: none (both columns are scalar)\n");
+#endif
+
+	// explicit template arguments select the scalar kernels; plain calls pick the float overloads
+	{
+		double scalarNs = nsPerCall([&](int i) {
+			gl::simd::multiply<float>(a + i * 16, b + i * 16, out + i * 16);
+			sink = out[i * 16];
+		});
+		double simdNs = nsPerCall([&](int i) {
+			gl::simd::multiply(a + i * 16, b + i * 16, out + i * 16);
+			sink = out[i * 16];
+		});
+
+		float error = 0.0f;
+		for (int i = 0; i < numMatrices; i++) {
+			float expected[16], actual[16];
+			gl::simd::multiply<float>(a + i * 16, b + i * 16, expected);
+			gl::simd::multiply(a + i * 16, b + i * 16, actual);
+			error = max(error, compare(expected, actual, 16));
+		}
+		ok &= report("Mat4 * Mat4", scalarNs, simdNs, error, 1e-6f);
+	}
+
+	{
+		double scalarNs = nsPerCall([&](int i) {
+			gl::simd::transform<float>(a + i * 16, v + i * 4, out + i * 4);
+			sink = out[i * 4];
+		});
+		double simdNs = nsPerCall([&](int i) {
+			gl::simd::transform(a + i * 16, v + i * 4, out + i * 4);
+			sink = out[i * 4];
+		});
+
+		float error = 0.0f;
+		for (int i = 0; i < numMatrices; i++) {
+			float expected[4], actual[4];
+			gl::simd::transform<float>(a + i * 16, v + i * 4, expected);
+			gl::simd::transform(a + i * 16, v + i * 4, actual);
+			error = max(error, compare(expected, actual, 4));
+		}
+		ok &= report("Mat4 * Vec4", scalarNs, simdNs, error, 1e-6f);
+	}
+
+	{
+		double scalarNs = nsPerCall([&](int i) {
+			gl::simd::inverse<float>(a + i * 16, out + i * 16);
+			sink = out[i * 16];
+		});
+		double simdNs = nsPerCall([&](int i) {
+			gl::simd::inverse(a + i * 16, out + i * 16);
+			sink = out[i * 16];
+		});
+
+		// the kernels expand the cofactors in a different order, so they only agree to rounding
+		float error = 0.0f;
+		for (int i = 0; i < numMatrices; i++) {
+			float expected[16], actual[16];
+			bool expectedOk = gl::simd::inverse<float>(a + i * 16, expected);
+			bool actualOk = gl::simd::inverse(a + i * 16, actual);
+			if (expectedOk != actualOk) {
+				error = INFINITY;
+				break;
+			}
+			error = max(error, compare(expected, actual, 16));
+		}
+		ok &= report("Mat4 inverse", scalarNs, simdNs, error, 1e-4f);
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+#include "CineCache.h"
+#include "util/Profiler.h"
+#include <iostream>
+
+using namespace std;
+
+CineCache::CineCache(unsigned capacity) :
+	capacity_(max(capacity, 2u)),
+	zSpacing_(1.0),
+	current_(0),
+	direction_(1),
+	generation_(0)
+{
+	Slot empty = { -1, nullptr };
+	ring_.assign(capacity_, empty);
+}
+
+CineCache::~CineCache()
+{
+	thread_.cancel();
+}
+
+void CineCache::open(const string& directory)
+{
+	close();
+
+	unsigned generation;
+	{
+		lock_guard<mutex> lock(mutex_);
+		generation = generation_;
+	}
+
+	thread_.post([this, directory, generation](const TaskThread::Cancelled& cancelled) {
+		VolumeLoader loader;
+		vector<VolumeLoader::ID> ids = loader.search(directory);
+		if (ids.empty() || cancelled()) {
+			return;
+		}
+
+		vector<vector<string>> phases;
+		double zSpacing;
+		loader.sortPhases(ids[0], phases, &zSpacing);
+		if (phases.size() < 2) {
+			return;
+		}
+
+		{
+			lock_guard<mutex> lock(mutex_);
+			if (generation != generation_) {
+				return;
+			}
+			series_ = ids[0];
+			phases_.swap(phases);
+			zSpacing_ = zSpacing;
+			current_ = 0;
+			direction_ = 1;
+		}
+		fill(cancelled);
+	});
+}
+
+void CineCache::close()
+{
+	thread_.cancel();
+
+	lock_guard<mutex> lock(mutex_);
+	generation_++;
+	phases_.clear();
+	for (Slot& slot : ring_) {
+		slot.phase = -1;
+		slot.volume = nullptr;
+	}
+}
+
+unsigned CineCache::numPhases() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return static_cast<unsigned>(phases_.size());
+}
+
+void CineCache::seek(unsigned phase, int direction)
+{
+	bool missing;
+	{
+		lock_guard<mutex> lock(mutex_);
+		if (phases_.empty()) {
+			return;
+		}
+		current_ = phase % phases_.size();
+		direction_ = (direction < 0) ? -1 : 1;
+		missing = nextMissing() >= 0;
+	}
+
+	// a running fill() picks up the new position by itself
+	if (missing && !thread_.busy()) {
+		thread_.post([this](const TaskThread::Cancelled& cancelled) { fill(cancelled); });
+	}
+}
+
+shared_ptr<VolumeData> CineCache::get(unsigned phase) const
+{
+	lock_guard<mutex> lock(mutex_);
+	int slot = find(phase);
+	return (slot < 0) ? nullptr : ring_[slot].volume;
+}
+
+void CineCache::fill(const TaskThread::Cancelled& cancelled)
+{
+	VolumeLoader loader;
+	while (!cancelled()) {
+		int phase;
+		vector<string> files;
+		VolumeLoader::ID series;
+		double zSpacing;
+		{
+			lock_guard<mutex> lock(mutex_);
+			phase = nextMissing();
+			if (phase < 0) {
+				return;
+			}
+			files = phases_[phase];
+			series = series_;
+			zSpacing = zSpacing_;
+		}
+
+		// playback may move on while the phase is decoded; it is abandoned once it isn't needed
+		LoadJob job([this, phase, &cancelled] {
+			if (cancelled()) {
+				return true;
+			}
+			lock_guard<mutex> lock(mutex_);
+			return !wanted(phase);
+		});
+
+		Profiler::Scope scope("CineCache::readPhase");
+		shared_ptr<VolumeData> volume(loader.read(series, files, zSpacing, job, false));
+		if (volume) {
+			store(phase, volume);
+		} else if (!job.cancelled()) {
+			// the phases share one format, so the others would most likely fail as well
+			cerr << "ERROR reading phase " << phase << " of series " << series.uid << "; cine playback stopped" << endl;
+			lock_guard<mutex> lock(mutex_);
+			phases_.clear();
+			return;
+		}
+	}
+}
+
+int CineCache::nextMissing() const
+{
+	unsigned n = static_cast<unsigned>(phases_.size());
+	unsigned count = min(capacity_, n);
+	for (unsigned i = 0; i < count; i++) {
+		unsigned phase = (current_ + n + direction_ * static_cast<int>(i)) % n;
+		if (find(phase) < 0) {
+			return static_cast<int>(phase);
+		}
+	}
+	return -1;
+}
+
+bool CineCache::wanted(unsigned phase) const
+{
+	unsigned n = static_cast<unsigned>(phases_.size());
+	unsigned count = min(capacity_, n);
+	for (unsigned i = 0; i < count; i++) {
+		if ((current_ + n + direction_ * static_cast<int>(i)) % n == phase) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int CineCache::find(unsigned phase) const
+{
+	for (size_t i = 0; i < ring_.size(); i++) {
+		if (ring_[i].phase == static_cast<int>(phase)) {
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+void CineCache::store(unsigned phase, shared_ptr<VolumeData> volume)
+{
+	lock_guard<mutex> lock(mutex_);
+	if (!wanted(phase)) {
+		return;
+	}
+
+	// reuse an empty slot or the one of a phase that playback has left behind
+	for (Slot& slot : ring_) {
+		if (slot.phase < 0 || !wanted(static_cast<unsigned>(slot.phase))) {
+			slot.phase = static_cast<int>(phase);
+			slot.volume = volume;
+			return;
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef __MEDLEAP_CINE_CACHE__
+#define __MEDLEAP_CINE_CACHE__
+
+#include "VolumeData.h"
+#include "VolumeLoader.h"
+#include "util/TaskThread.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Host memory cache for the phases of a time-resolved (4D) DICOM series. A ring of slots holds
+ * the current phase and the ones after it in the direction of playback; a background thread
+ * decodes the missing ones nearest to the current phase first and reuses the slots of phases
+ * that fell behind. Phases are read without gradients since they are only shown through the
+ * volume texture.
+ */
+class CineCache
+{
+public:
+	/** capacity is the number of decoded phases kept in memory */
+	explicit CineCache(unsigned capacity);
+
+	~CineCache();
+
+	/** Finds the phases of the first series in a directory in the background; drops the current series */
+	void open(const std::string& directory);
+
+	/** Stops decoding and frees all phases */
+	void close();
+
+	/** Number of phases; 0 until open() has found them, or if the series isn't time-resolved */
+	unsigned numPhases() const;
+
+	/** Sets the phase being shown and the direction of playback (1 or -1). Should be called every frame, since it also restarts decoding when phases are missing. */
+	void seek(unsigned phase, int direction);
+
+	/** Decoded phase, or NULL if it isn't in memory yet */
+	std::shared_ptr<VolumeData> get(unsigned phase) const;
+
+private:
+	struct Slot
+	{
+		int phase;
+		std::shared_ptr<VolumeData> volume;
+	};
+
+	unsigned capacity_;
+	mutable std::mutex mutex_;
+	std::vector<Slot> ring_;
+	std::vector<std::vector<std::string>> phases_;
+	VolumeLoader::ID series_;
+	double zSpacing_;
+	unsigned current_;
+	int direction_;
+	unsigned generation_;  // incremented by open() and close() so a stale search is discarded
+
+	// declared last so the thread stops before the cache is destroyed
+	TaskThread thread_;
+
+	/** Decodes missing phases until the ones ahead of the current phase are all in memory */
+	void fill(const TaskThread::Cancelled& cancelled);
+
+	/** Next phase to decode, or -1 if none is missing; the mutex must be held */
+	int nextMissing() const;
+
+	/** True if phase is among the ones that should be kept; the mutex must be held */
+	bool wanted(unsigned phase) const;
+
+	int find(unsigned phase) const;
+	void store(unsigned phase, std::shared_ptr<VolumeData> volume);
+};
+
+#endif // __MEDLEAP_CINE_CACHE__
@@ -0,0 +1,110 @@
+#include "LoadJob.h"
+#include <chrono>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+	int64_t now()
+	{
+		return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+LoadJob::LoadJob(TaskThread::Cancelled cancelled) :
+	external_(cancelled),
+	phase_(Phase::scanning),
+	cancel_(false),
+	slices_(0),
+	total_slices_(0),
+	bytes_(0),
+	phase_start_(now()),
+	volume_(NULL)
+{
+}
+
+LoadJob::~LoadJob()
+{
+	delete volume_;
+}
+
+void LoadJob::cancel()
+{
+	cancel_ = true;
+
+	lock_guard<mutex> lock(mutex_);
+	if (phase_ == Phase::finished) {
+		delete volume_;
+		volume_ = NULL;
+		phase_ = Phase::cancelled;
+	}
+}
+
+bool LoadJob::cancelled() const
+{
+	return cancel_ || (external_ && external_());
+}
+
+bool LoadJob::done() const
+{
+	Phase p = phase_;
+	return p == Phase::finished || p == Phase::failed || p == Phase::cancelled;
+}
+
+const char* LoadJob::message() const
+{
+	switch (phase_) {
+	case Phase::scanning: return "Scanning Files";
+	case Phase::reading: return "Reading Images";
+	case Phase::transforming: return "Applying Modality Transformation";
+	case Phase::gradients: return "Calculating Gradients";
+	case Phase::finished: return "Finished";
+	case Phase::failed: return "Failed";
+	case Phase::cancelled: return "Cancelled";
+	}
+	return "";
+}
+
+double LoadJob::throughput() const
+{
+	double seconds = (now() - phase_start_) / 1.0e6;
+	return (seconds > 0.0) ? bytes_ / seconds : 0.0;
+}
+
+VolumeData* LoadJob::take()
+{
+	lock_guard<mutex> lock(mutex_);
+	VolumeData* volume = volume_;
+	volume_ = NULL;
+	return volume;
+}
+
+void LoadJob::begin(Phase phase, unsigned totalSlices)
+{
+	slices_ = 0;
+	bytes_ = 0;
+	total_slices_ = totalSlices;
+	phase_start_ = now();
+	phase_ = phase;
+}
+
+void LoadJob::advance(size_t bytes)
+{
+	slices_++;
+	bytes_ += bytes;
+}
+
+void LoadJob::finish(VolumeData* volume)
+{
+	lock_guard<mutex> lock(mutex_);
+	if (cancelled()) {
+		delete volume;
+		phase_ = Phase::cancelled;
+	} else if (!volume) {
+		phase_ = Phase::failed;
+	} else {
+		volume_ = volume;
+		phase_ = Phase::finished;
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef __MEDLEAP_LOAD_JOB__
+#define __MEDLEAP_LOAD_JOB__
+
+#include "VolumeData.h"
+#include "util/TaskThread.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * Shared state of one volume load. The loading thread reports the phase it is in and counts
+ * slices and bytes as it goes; any thread can read the progress or cancel the job, which the
+ * loader notices before the next slice. The finished volume is handed over once with take().
+ */
+class LoadJob
+{
+public:
+	enum class Phase
+	{
+		scanning,      // finding and sorting the files of the series
+		reading,       // decoding slices
+		transforming,  // modality LUT and min/max values
+		gradients,     // gradient vectors
+		finished,
+		failed,
+		cancelled
+	};
+
+	/** cancelled, if set, is polled along with cancel() (ex. the cancellation of a TaskThread task) */
+	explicit LoadJob(TaskThread::Cancelled cancelled = nullptr);
+
+	/** Deletes a finished volume that was never taken */
+	~LoadJob();
+
+	/** Asks the loader to stop; a volume finished anyway is deleted */
+	void cancel();
+
+	bool cancelled() const;
+
+	Phase phase() const { return phase_; }
+
+	/** True once the job finished, failed or was cancelled */
+	bool done() const;
+
+	/** Description of the current phase (ex. "Reading Images") */
+	const char* message() const;
+
+	/** Slices processed in the current phase */
+	unsigned slices() const { return slices_; }
+
+	/** Slices to process in the current phase; 0 if unknown */
+	unsigned totalSlices() const { return total_slices_; }
+
+	/** Bytes processed in the current phase */
+	uint64_t bytes() const { return bytes_; }
+
+	/** Bytes per second since the current phase started */
+	double throughput() const;
+
+	/** Returns the finished volume, once; NULL if not finished. The caller owns the volume. */
+	VolumeData* take();
+
+	/** Starts a phase of totalSlices slices (0 if unknown); called by the loader */
+	void begin(Phase phase, unsigned totalSlices = 0);
+
+	/** Counts one processed slice; called by the loader, from any of its threads */
+	void advance(size_t bytes);
+
+	/** Ends the job with its volume, or NULL if loading failed; called by the loader */
+	void finish(VolumeData* volume);
+
+private:
+	TaskThread::Cancelled external_;
+	std::atomic<Phase> phase_;
+	std::atomic<bool> cancel_;
+	std::atomic<unsigned> slices_;
+	std::atomic<unsigned> total_slices_;
+	std::atomic<uint64_t> bytes_;
+	std::atomic<int64_t> phase_start_;  // steady clock, microseconds
+	std::mutex mutex_;
+	VolumeData* volume_;
+};
+
+#endif // __MEDLEAP_LOAD_JOB__
@@ -0,0 +1,274 @@
+#include "MaskData.h"
+#include <algorithm>
+#include "util/Parallel.h"
+
+using namespace gl;
+using namespace std;
+
+namespace
+{
+	/** Bits of one 16-voxel row inside a brick word (each word stores 4 rows) */
+	uint64_t rowMask(int x0, int x1, int y, int z)
+	{
+		int row = (z * MaskData::brickSize + y) & 3;
+		uint64_t lane = ((1ULL << (x1 - x0)) - 1) << x0;
+		return lane << (row * MaskData::brickSize);
+	}
+}
+
+MaskData::MaskData() : width_(0), height_(0), depth_(0), bricks_(0, 0, 0), version_(0)
+{
+}
+
+const MaskData::BrickPtr& MaskData::empty()
+{
+	static BrickPtr brick = [] {
+		std::shared_ptr<Bits> bits(new Bits());
+		bits->fill(0);
+		return BrickPtr(bits);
+	}();
+	return brick;
+}
+
+const MaskData::BrickPtr& MaskData::full()
+{
+	static BrickPtr brick = [] {
+		std::shared_ptr<Bits> bits(new Bits());
+		bits->fill(~0ULL);
+		return BrickPtr(bits);
+	}();
+	return brick;
+}
+
+void MaskData::resize(int width, int height, int depth)
+{
+	width_ = width;
+	height_ = height;
+	depth_ = depth;
+	bricks_ = Vec3i((width + brickSize - 1) / brickSize, (height + brickSize - 1) / brickSize, (depth + brickSize - 1) / brickSize);
+
+	size_t count = (size_t)bricks_.x * bricks_.y * bricks_.z;
+	data_.assign(count, empty());
+	dirty_.assign(count, false);
+	dirtyList_.clear();
+	version_++;
+}
+
+const MaskData::BrickPtr& MaskData::brick(int bx, int by, int bz) const
+{
+	return data_[(bz * bricks_.y + by) * bricks_.x + bx];
+}
+
+unsigned MaskData::brickIndex(int x, int y, int z) const
+{
+	return ((z / brickSize) * bricks_.y + (y / brickSize)) * bricks_.x + (x / brickSize);
+}
+
+bool MaskData::get(int x, int y, int z) const
+{
+	int b = bit(x, y, z);
+	return ((*data_[brickIndex(x, y, z)])[b >> 6] >> (b & 63)) & 1;
+}
+
+MaskData::BrickPtr MaskData::canonical(std::shared_ptr<Bits> bits) const
+{
+	if (*bits == *empty()) return empty();
+	if (*bits == *full()) return full();
+	return bits;
+}
+
+void MaskData::set(unsigned index, const BrickPtr& brick)
+{
+	data_[index] = brick;
+	if (!dirty_[index]) {
+		dirty_[index] = true;
+		dirtyList_.push_back(index);
+	}
+}
+
+vector<MaskData::BrickDelta> MaskData::fill(const Vec3i& min, const Vec3i& max, bool value)
+{
+	return rasterize(min, max, value, [&](int, int, int& x0, int& x1) {
+		x0 = min.x;
+		x1 = max.x;
+		return true;
+	});
+}
+
+vector<MaskData::BrickDelta> MaskData::rasterize(const Vec3i& min, const Vec3i& max, bool value, const SpanFunction& span)
+{
+	vector<BrickDelta> deltas;
+
+	Vec3i lo(std::max(0, min.x), std::max(0, min.y), std::max(0, min.z));
+	Vec3i hi(std::min(width_, max.x), std::min(height_, max.y), std::min(depth_, max.z));
+	if (lo.x >= hi.x || lo.y >= hi.y || lo.z >= hi.z) {
+		return deltas;
+	}
+
+	const BrickPtr& uniform = value ? full() : empty();
+
+	// bricks that overlap the bounding range and are not already uniformly set to value
+	vector<unsigned> candidates;
+	for (int bz = lo.z / brickSize; bz <= (hi.z - 1) / brickSize; bz++) {
+		for (int by = lo.y / brickSize; by <= (hi.y - 1) / brickSize; by++) {
+			for (int bx = lo.x / brickSize; bx <= (hi.x - 1) / brickSize; bx++) {
+				unsigned index = (bz * bricks_.y + by) * bricks_.x + bx;
+				if (data_[index] != uniform) {
+					candidates.push_back(index);
+				}
+			}
+		}
+	}
+
+	vector<BrickPtr> results(candidates.size());
+
+	auto rasterizeBricks = [&](unsigned, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			unsigned index = candidates[i];
+			int bx = index % bricks_.x;
+			int by = (index / bricks_.x) % bricks_.y;
+			int bz = index / (bricks_.x * bricks_.y);
+			int ox = bx * brickSize;
+			int oy = by * brickSize;
+			int oz = bz * brickSize;
+
+			// local rows of the brick inside the bounding range
+			int y0 = std::max(lo.y - oy, 0);
+			int z0 = std::max(lo.z - oz, 0);
+			int y1 = std::min(hi.y - oy, (int)brickSize);
+			int z1 = std::min(hi.z - oz, (int)brickSize);
+
+			const BrickPtr& before = data_[index];
+			Bits bits = *before;
+			for (int z = z0; z < z1; z++) {
+				for (int y = y0; y < y1; y++) {
+					int sx0, sx1;
+					if (!span(oy + y, oz + z, sx0, sx1)) {
+						continue;
+					}
+					int x0 = std::max(std::max(sx0, lo.x) - ox, 0);
+					int x1 = std::min(std::min(sx1, hi.x) - ox, (int)brickSize);
+					if (x0 >= x1) {
+						continue;
+					}
+					uint64_t mask = rowMask(x0, x1, y, z);
+					uint64_t& word = bits[(z * brickSize + y) >> 2];
+					word = value ? (word | mask) : (word & ~mask);
+				}
+			}
+
+			if (bits != *before) {
+				results[i] = canonical(std::make_shared<Bits>(bits));
+			}
+		}
+	};
+
+	// small edits (a typical Leap stroke step) are not worth starting threads for
+	unsigned numThreads = std::min<unsigned>(workerCount(), (unsigned)(candidates.size() / 64) + 1);
+	parallelFor(0, candidates.size(), numThreads, rasterizeBricks);
+
+	for (size_t i = 0; i < candidates.size(); i++) {
+		if (results[i]) {
+			deltas.push_back({ candidates[i], data_[candidates[i]], results[i] });
+			set(candidates[i], results[i]);
+		}
+	}
+
+	if (!deltas.empty()) {
+		version_++;
+	}
+	return deltas;
+}
+
+vector<MaskData::BrickDelta> MaskData::combine(const vector<pair<unsigned, Bits>>& bricks, bool value)
+{
+	vector<BrickDelta> deltas;
+	for (const pair<unsigned, Bits>& brick : bricks) {
+		// bricks of a mask that has since been resized
+		if (brick.first >= data_.size()) {
+			continue;
+		}
+
+		const BrickPtr& before = data_[brick.first];
+		std::shared_ptr<Bits> bits(new Bits(*before));
+		for (int i = 0; i < wordsPerBrick; i++) {
+			(*bits)[i] = value ? ((*bits)[i] | brick.second[i]) : ((*bits)[i] & ~brick.second[i]);
+		}
+		if (*bits != *before) {
+			BrickPtr after = canonical(bits);
+			deltas.push_back({ brick.first, before, after });
+			set(brick.first, after);
+		}
+	}
+
+	if (!deltas.empty()) {
+		version_++;
+	}
+	return deltas;
+}
+
+void MaskData::apply(const vector<BrickDelta>& deltas, bool undo)
+{
+	for (const BrickDelta& delta : deltas) {
+		set(delta.index, undo ? delta.before : delta.after);
+	}
+	if (!deltas.empty()) {
+		version_++;
+	}
+}
+
+void MaskData::upload(const Texture& texture)
+{
+	if (dirtyList_.empty()) {
+		return;
+	}
+
+	// bricks are stored in x-fastest order, so consecutive indices in the same brick row are
+	// neighbors along X and can be sent with a single call
+	std::sort(dirtyList_.begin(), dirtyList_.end());
+
+	vector<GLubyte> bytes;
+
+	texture.bind();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	size_t i = 0;
+	while (i < dirtyList_.size()) {
+		unsigned first = dirtyList_[i];
+		size_t run = 1;
+		while (i + run < dirtyList_.size() && dirtyList_[i + run] == first + run && (first + run) % bricks_.x != 0) {
+			run++;
+		}
+
+		int bx = first % bricks_.x;
+		int by = (first / bricks_.x) % bricks_.y;
+		int bz = first / (bricks_.x * bricks_.y);
+		int x0 = bx * brickSize;
+		int y0 = by * brickSize;
+		int z0 = bz * brickSize;
+		int w = std::min((int)(run * brickSize), width_ - x0);
+		int h = std::min((int)brickSize, height_ - y0);
+		int d = std::min((int)brickSize, depth_ - z0);
+
+		bytes.resize(w * h * d);
+		GLubyte* out = &bytes[0];
+		for (int z = 0; z < d; z++) {
+			for (int y = 0; y < h; y++) {
+				for (int x = 0; x < w; x++) {
+					const Bits& bits = *data_[first + x / brickSize];
+					int b = bit(x, y, z);
+					*out++ = ((bits[b >> 6] >> (b & 63)) & 1) ? 255 : 0;
+				}
+			}
+		}
+
+		glTexSubImage3D(GL_TEXTURE_3D, 0, x0, y0, z0, w, h, d, GL_RED, GL_UNSIGNED_BYTE, &bytes[0]);
+
+		for (size_t j = 0; j < run; j++) {
+			dirty_[first + j] = false;
+		}
+		i += run;
+	}
+
+	dirtyList_.clear();
+}
@@ -0,0 +1,113 @@
+#ifndef __MEDLEAP_MASK_DATA__
+#define __MEDLEAP_MASK_DATA__
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "gl/math/Math.h"
+#include "gl/Texture.h"
+
+/**
+ * Binary mask with one bit per voxel (1 = removed). Voxels are grouped into bricks of
+ * brickSize^3 bits that are shared and copy-on-write: a brick is never modified in place, so
+ * edits and snapshots only hold pointers to the bricks they touch. Bricks that are entirely
+ * empty or entirely full all share the same two instances.
+ */
+class MaskData
+{
+public:
+	static const int brickSize = 16;
+	static const int wordsPerBrick = brickSize * brickSize * brickSize / 64;
+
+	typedef std::array<uint64_t, wordsPerBrick> Bits;
+	typedef std::shared_ptr<const Bits> BrickPtr;
+
+	/** State of a single brick before and after an edit */
+	struct BrickDelta
+	{
+		unsigned index;
+		BrickPtr before;
+		BrickPtr after;
+	};
+
+	/**
+	 * Describes a shape as spans of voxels along X. Returns false if row (y, z) is not covered,
+	 * otherwise sets the covered range [x0, x1).
+	 */
+	typedef std::function<bool(int y, int z, int& x0, int& x1)> SpanFunction;
+
+	MaskData();
+
+	/** Resizes the mask and clears every voxel */
+	void resize(int width, int height, int depth);
+
+	int width() const { return width_; }
+	int height() const { return height_; }
+	int depth() const { return depth_; }
+
+	/** Number of bricks along each axis */
+	gl::Vec3i bricks() const { return bricks_; }
+
+	/** Brick at brick coordinates (bx, by, bz) */
+	const BrickPtr& brick(int bx, int by, int bz) const;
+
+	/** Brick index of the brick that contains voxel (x, y, z) */
+	unsigned brickIndex(int x, int y, int z) const;
+
+	/** Returns true if voxel (x, y, z) is removed */
+	bool get(int x, int y, int z) const;
+
+	/** Sets every voxel in [min, max) to value. Returns the bricks that changed. */
+	std::vector<BrickDelta> fill(const gl::Vec3i& min, const gl::Vec3i& max, bool value);
+
+	/**
+	 * Sets every voxel covered by the spans of a shape to value. Only rows inside the bounding
+	 * range [min, max) are queried. Bricks are rasterized in parallel, 16 voxels of a row per
+	 * 64-bit word operation. Returns the bricks that changed.
+	 */
+	std::vector<BrickDelta> rasterize(const gl::Vec3i& min, const gl::Vec3i& max, bool value, const SpanFunction& span);
+
+	/** Sets (value = true) or clears the voxels whose bits are set in the given bricks; bricks outside the mask are ignored. Returns the bricks that changed. */
+	std::vector<BrickDelta> combine(const std::vector<std::pair<unsigned, Bits>>& bricks, bool value);
+
+	/** Restores the 'before' (undo) or 'after' (redo) state of each delta */
+	void apply(const std::vector<BrickDelta>& deltas, bool undo);
+
+	/** Incremented on every change */
+	uint64_t version() const { return version_; }
+
+	/** True if bricks changed since the last upload */
+	bool dirty() const { return !dirtyList_.empty(); }
+
+	/** Uploads the changed bricks to a GL_R8 3D texture of the same size; adjacent bricks along X are sent together */
+	void upload(const gl::Texture& texture);
+
+	/** Shared brick with no voxels set */
+	static const BrickPtr& empty();
+
+	/** Shared brick with all voxels set */
+	static const BrickPtr& full();
+
+	/** Bit position of voxel (x, y, z) inside its brick */
+	static int bit(int x, int y, int z)
+	{
+		return (((z & (brickSize - 1)) * brickSize + (y & (brickSize - 1))) * brickSize) + (x & (brickSize - 1));
+	}
+
+private:
+	int width_;
+	int height_;
+	int depth_;
+	gl::Vec3i bricks_;
+	std::vector<BrickPtr> data_;
+	std::vector<bool> dirty_;
+	std::vector<unsigned> dirtyList_;
+	uint64_t version_;
+
+	void set(unsigned index, const BrickPtr& brick);
+	BrickPtr canonical(std::shared_ptr<Bits> bits) const;
+};
+
+#endif // __MEDLEAP_MASK_DATA__
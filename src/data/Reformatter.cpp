@@ -0,0 +1,205 @@
+#include "Reformatter.h"
+#include "util/Parallel.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace gl;
+using namespace std;
+
+namespace
+{
+	const int tileSize = 32;
+	const int maxPixels = 2048;
+
+	/** Length of the box (size) projected onto direction a */
+	float projectedLength(const Vec3& a, const Vec3& size)
+	{
+		return std::abs(a.x) * size.x + std::abs(a.y) * size.y + std::abs(a.z) * size.z;
+	}
+
+	bool equal(const Vec3& a, const Vec3& b)
+	{
+		return (a - b).lengthSquared() < 1e-8f;
+	}
+}
+
+Reformatter::Reformatter() :
+	orientation_(AXIAL),
+	width_(1.0f),
+	height_(1.0f),
+	depth_(1.0f),
+	spacing_(1.0f),
+	numSlices_(1),
+	pixelsWide_(1),
+	pixelsHigh_(1),
+	voxelAligned_(true)
+{
+}
+
+const char* Reformatter::name(Orientation orientation)
+{
+	switch (orientation) {
+	case AXIAL: return "Axial";
+	case CORONAL: return "Coronal";
+	case SAGITTAL: return "Sagittal";
+	case OBLIQUE: return "Oblique";
+	default: return "";
+	}
+}
+
+void Reformatter::setOrientation(VolumeData* volume, Orientation orientation, const Camera& camera)
+{
+	orientation_ = orientation;
+
+	// patient directions in volume coordinates
+	Mat3 patientToVolume = volume->getPatientBasis().transpose();
+	Vec3 patientX = patientToVolume * Vec3::xAxis();
+	Vec3 patientY = patientToVolume * Vec3::yAxis();
+	Vec3 patientZ = patientToVolume * Vec3::zAxis();
+
+	switch (orientation) {
+	case CORONAL:
+		normal_ = patientY;
+		axisU_ = patientX;
+		axisV_ = patientZ;
+		break;
+	case SAGITTAL:
+		normal_ = patientX;
+		axisU_ = patientY;
+		axisV_ = patientZ;
+		break;
+	case OBLIQUE:
+		normal_ = Vec3(camera.forward());
+		axisU_ = Vec3(camera.right());
+		axisV_ = Vec3(camera.up());
+		break;
+	default:
+		normal_ = patientZ;
+		axisU_ = patientX;
+		axisV_ = patientY;
+		break;
+	}
+	normal_.normalize();
+	axisU_.normalize();
+	axisV_.normalize();
+
+	const Box& bounds = volume->getBounds();
+	boundsMin_ = bounds.min();
+	boundsSize_ = bounds.size();
+	center_ = bounds.center();
+
+	Vector3<unsigned> dims = volume->getSizeVoxels();
+	Vec3 voxelStep = boundsSize_ / Vec3((float)dims.x, (float)dims.y, (float)dims.z);
+
+	// planes cover the projection of the volume; one plane per voxel step along the normal
+	width_ = projectedLength(axisU_, boundsSize_);
+	height_ = projectedLength(axisV_, boundsSize_);
+	depth_ = projectedLength(normal_, boundsSize_);
+
+	numSlices_ = std::max(1, (int)std::floor(depth_ / projectedLength(normal_, voxelStep) + 0.5f));
+	spacing_ = depth_ / numSlices_;
+	pixelsWide_ = std::min(maxPixels, std::max(1, (int)std::floor(width_ / projectedLength(axisU_, voxelStep) + 0.5f)));
+	pixelsHigh_ = std::min(maxPixels, std::max(1, (int)std::floor(height_ / projectedLength(axisV_, voxelStep) + 0.5f)));
+
+	voxelAligned_ = orientation == AXIAL && equal(axisU_, Vec3::xAxis()) && equal(axisV_, Vec3::yAxis());
+}
+
+Reformatter::Plane Reformatter::plane(float slice) const
+{
+	Vec3 center = center_ + normal_ * (-0.5f * depth_ + (slice + 0.5f) * spacing_);
+	Vec3 corner = center - axisU_ * (0.5f * width_) - axisV_ * (0.5f * height_);
+
+	Plane p;
+	p.origin = (corner - boundsMin_) / boundsSize_;
+	p.u = axisU_ * width_ / boundsSize_;
+	p.v = axisV_ * height_ / boundsSize_;
+	p.n = normal_ * spacing_ / boundsSize_;
+	return p;
+}
+
+void Reformatter::resample(VolumeData* volume, const Plane& plane, int width, int height, vector<char>& out)
+{
+	out.resize((size_t)width * height * volume->getPixelSizeBytes());
+
+	switch (volume->getType())
+	{
+	case GL_BYTE:
+		resample(volume, plane, width, height, reinterpret_cast<GLbyte*>(&out[0]));
+		break;
+	case GL_UNSIGNED_BYTE:
+		resample(volume, plane, width, height, reinterpret_cast<GLubyte*>(&out[0]));
+		break;
+	case GL_SHORT:
+		resample(volume, plane, width, height, reinterpret_cast<GLshort*>(&out[0]));
+		break;
+	case GL_UNSIGNED_SHORT:
+		resample(volume, plane, width, height, reinterpret_cast<GLushort*>(&out[0]));
+		break;
+	}
+}
+
+template <typename T>
+void Reformatter::resample(VolumeData* volume, const Plane& plane, int width, int height, T* out)
+{
+	const int w = volume->getWidth();
+	const int h = volume->getHeight();
+	const int d = volume->getDepth();
+	const size_t sliceSize = (size_t)w * h;
+	const T* data = reinterpret_cast<const T*>(volume->getData());
+	const T outside = static_cast<T>(volume->getMinValue());
+
+	// texel centers in voxel coordinates (same convention as GL_LINEAR sampling)
+	Vec3 dims((float)w, (float)h, (float)d);
+	Vec3 stepX = plane.u * dims / (float)width;
+	Vec3 stepY = plane.v * dims / (float)height;
+	Vec3 start = plane.origin * dims - 0.5f + stepX * 0.5f + stepY * 0.5f;
+
+	const int tilesX = (width + tileSize - 1) / tileSize;
+	const int tilesY = (height + tileSize - 1) / tileSize;
+
+	// tiles keep the voxels touched by neighboring texels close together for oblique planes
+	parallelFor(0, (size_t)tilesX * tilesY, [&](unsigned, size_t begin, size_t end) {
+		for (size_t tile = begin; tile < end; tile++) {
+			int x0 = (int)(tile % tilesX) * tileSize;
+			int y0 = (int)(tile / tilesX) * tileSize;
+			int x1 = std::min(x0 + tileSize, width);
+			int y1 = std::min(y0 + tileSize, height);
+
+			for (int y = y0; y < y1; y++) {
+				Vec3 p = start + stepX * (float)x0 + stepY * (float)y;
+				T* row = out + (size_t)y * width;
+
+				for (int x = x0; x < x1; x++, p += stepX) {
+					if (p.x < -0.5f || p.y < -0.5f || p.z < -0.5f || p.x > w - 0.5f || p.y > h - 0.5f || p.z > d - 0.5f) {
+						row[x] = outside;
+						continue;
+					}
+
+					float px = std::min(std::max(p.x, 0.0f), w - 1.0f);
+					float py = std::min(std::max(p.y, 0.0f), h - 1.0f);
+					float pz = std::min(std::max(p.z, 0.0f), d - 1.0f);
+					int ix = (int)px;
+					int iy = (int)py;
+					int iz = (int)pz;
+					float fx = px - ix;
+					float fy = py - iy;
+					float fz = pz - iz;
+					int dx = (ix + 1 < w) ? 1 : 0;
+					size_t dy = (iy + 1 < h) ? w : 0;
+					size_t dz = (iz + 1 < d) ? sliceSize : 0;
+
+					const T* v = data + iz * sliceSize + (size_t)iy * w + ix;
+					float c00 = v[0] + (v[dx] - v[0]) * fx;
+					float c10 = v[dy] + (v[dy + dx] - v[dy]) * fx;
+					float c01 = v[dz] + (v[dz + dx] - v[dz]) * fx;
+					float c11 = v[dz + dy] + (v[dz + dy + dx] - v[dz + dy]) * fx;
+					float c0 = c00 + (c10 - c00) * fy;
+					float c1 = c01 + (c11 - c01) * fy;
+					float value = c0 + (c1 - c0) * fz;
+
+					row[x] = static_cast<T>(std::floor(value + 0.5f));
+				}
+			}
+		}
+	});
+}
@@ -0,0 +1,87 @@
+#ifndef __MEDLEAP_REFORMATTER__
+#define __MEDLEAP_REFORMATTER__
+
+#include <vector>
+#include "gl/math/Math.h"
+#include "util/Camera.h"
+#include "VolumeData.h"
+
+/**
+ * Multiplanar reformatting. Describes a stack of parallel planes through the volume that are
+ * either aligned with the patient axes (axial, coronal, sagittal) or perpendicular to the view
+ * direction of a camera (oblique). Planes are given in normalized texture coordinates so they
+ * can be sampled from the volume texture on the GPU; resample() produces the same image on
+ * the CPU when the volume is not resident.
+ */
+class Reformatter
+{
+public:
+	enum Orientation { AXIAL, CORONAL, SAGITTAL, OBLIQUE, NUM_OF_ORIENTATIONS };
+
+	/** Plane in texture coordinates: texcoord = origin + s * u + t * v for s, t in [0, 1] */
+	struct Plane
+	{
+		gl::Vec3 origin;
+		gl::Vec3 u;
+		gl::Vec3 v;
+		gl::Vec3 n; // offset to the next plane in the stack
+	};
+
+	Reformatter();
+
+	/** Computes the plane axes for a volume. The camera is only used for oblique planes. */
+	void setOrientation(VolumeData* volume, Orientation orientation, const Camera& camera);
+
+	Orientation orientation() const { return orientation_; }
+
+	/** Number of planes in the stack (one per voxel step along the plane normal) */
+	int numSlices() const { return numSlices_; }
+
+	/** Distance between adjacent planes in world units */
+	float sliceSpacing() const { return spacing_; }
+
+	/** Size of each plane in world units */
+	float width() const { return width_; }
+	float height() const { return height_; }
+
+	/** Image size that samples a plane at the finest voxel spacing */
+	int pixelsWide() const { return pixelsWide_; }
+	int pixelsHigh() const { return pixelsHigh_; }
+
+	/** True if the planes are exactly the volume's Z slices, so no resampling is needed */
+	bool voxelAligned() const { return voxelAligned_; }
+
+	/** Plane at a position in the stack; fractional positions are allowed */
+	Plane plane(float slice) const;
+
+	/**
+	 * Trilinearly resamples a plane into a width x height image with the volume's voxel type.
+	 * Texels outside the volume are set to the minimum voxel value. The image is split into
+	 * tiles that are resampled in parallel.
+	 */
+	static void resample(VolumeData* volume, const Plane& plane, int width, int height, std::vector<char>& out);
+
+	static const char* name(Orientation orientation);
+
+private:
+	Orientation orientation_;
+	gl::Vec3 boundsMin_;
+	gl::Vec3 boundsSize_;
+	gl::Vec3 center_;
+	gl::Vec3 normal_;
+	gl::Vec3 axisU_;
+	gl::Vec3 axisV_;
+	float width_;
+	float height_;
+	float depth_;
+	float spacing_;
+	int numSlices_;
+	int pixelsWide_;
+	int pixelsHigh_;
+	bool voxelAligned_;
+
+	template <typename T>
+	static void resample(VolumeData* volume, const Plane& plane, int width, int height, T* out);
+};
+
+#endif // __MEDLEAP_REFORMATTER__
@@ -0,0 +1,193 @@
+#include "RegionGrower.h"
+#include "util/Parallel.h"
+#include <algorithm>
+
+using namespace gl;
+using namespace std;
+
+RegionGrower::RegionGrower() : cancel_(false), running_(false), count_(0)
+{
+}
+
+RegionGrower::~RegionGrower()
+{
+	cancel();
+}
+
+void RegionGrower::start(VolumeData* volume, const Vec3i& seed, const Params& params)
+{
+	cancel();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		published_.clear();
+	}
+
+	if (seed.x < 0 || seed.y < 0 || seed.z < 0 ||
+		seed.x >= (int)volume->getWidth() || seed.y >= (int)volume->getHeight() || seed.z >= (int)volume->getDepth()) {
+		return;
+	}
+
+	cancel_ = false;
+	running_ = true;
+	count_ = 0;
+
+	switch (volume->getType())
+	{
+	case GL_BYTE:
+		worker_ = std::thread(&RegionGrower::run<GLbyte>, this, volume, seed, params);
+		break;
+	case GL_UNSIGNED_BYTE:
+		worker_ = std::thread(&RegionGrower::run<GLubyte>, this, volume, seed, params);
+		break;
+	case GL_SHORT:
+		worker_ = std::thread(&RegionGrower::run<GLshort>, this, volume, seed, params);
+		break;
+	case GL_UNSIGNED_SHORT:
+		worker_ = std::thread(&RegionGrower::run<GLushort>, this, volume, seed, params);
+		break;
+	default:
+		running_ = false;
+	}
+}
+
+void RegionGrower::cancel()
+{
+	cancel_ = true;
+	if (worker_.joinable()) {
+		worker_.join();
+	}
+	running_ = false;
+}
+
+void RegionGrower::discard()
+{
+	cancel();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	published_.clear();
+}
+
+bool RegionGrower::take(vector<BrickBits>& bricks)
+{
+	bricks.clear();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto& entry : published_) {
+		bricks.push_back(entry);
+	}
+	published_.clear();
+	return !bricks.empty();
+}
+
+template <typename T>
+void RegionGrower::run(VolumeData* volume, Vec3i seed, Params params)
+{
+	const int B = MaskData::brickSize;
+	const int w = volume->getWidth();
+	const int h = volume->getHeight();
+	const int d = volume->getDepth();
+	const Vec3i bricks((w + B - 1) / B, (h + B - 1) / B, (d + B - 1) / B);
+
+	const T* data = reinterpret_cast<const T*>(volume->getData());
+	const vector<Vec3>& gradients = volume->getGradients();
+	const bool useGradient = params.maxGradient > 0.0f && gradients.size() == volume->getNumVoxels();
+	const float maxGradient2 = params.maxGradient * params.maxGradient;
+
+	auto accept = [&](int x, int y, int z) {
+		size_t i = ((size_t)z * h + y) * w + x;
+		int value = data[i];
+		if (value < params.lower || value > params.upper) {
+			return false;
+		}
+		return !useGradient || gradients[i].lengthSquared() <= maxGradient2;
+	};
+
+	auto brickIndex = [&](const Vec3i& v) {
+		return (unsigned)(((v.z / B) * bricks.y + (v.y / B)) * bricks.x + (v.x / B));
+	};
+
+	// region bits per brick, allocated when a brick first gains a voxel
+	vector<unique_ptr<MaskData::Bits>> region((size_t)bricks.x * bricks.y * bricks.z);
+
+	typedef unordered_map<unsigned, vector<Vec3i>> Wave;
+	Wave wave;
+	wave[brickIndex(seed)].push_back(seed);
+
+	static const int offsets[6][3] = { { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 } };
+
+	while (!wave.empty() && !cancel_) {
+		vector<pair<unsigned, vector<Vec3i>>> active(make_move_iterator(wave.begin()), make_move_iterator(wave.end()));
+		wave.clear();
+
+		unsigned numThreads = std::min<unsigned>(workerCount(), (unsigned)active.size());
+		vector<vector<Vec3i>> outboxes(numThreads);
+		vector<char> grew(active.size(), 0);
+
+		parallelFor(0, active.size(), numThreads, [&](unsigned thread, size_t begin, size_t end) {
+			vector<Vec3i>& outbox = outboxes[thread];
+			for (size_t i = begin; i < end && !cancel_; i++) {
+				unsigned index = active[i].first;
+				vector<Vec3i>& stack = active[i].second;
+				Vec3i origin((index % bricks.x) * B, ((index / bricks.x) % bricks.y) * B, (index / (bricks.x * bricks.y)) * B);
+				unique_ptr<MaskData::Bits>& bits = region[index];
+				uint64_t added = 0;
+
+				// depth-first fill inside the brick; neighbors in other bricks go to the next wave
+				while (!stack.empty()) {
+					Vec3i v = stack.back();
+					stack.pop_back();
+
+					int b = MaskData::bit(v.x, v.y, v.z);
+					if (bits && (((*bits)[b >> 6] >> (b & 63)) & 1)) {
+						continue;
+					}
+					if (!accept(v.x, v.y, v.z)) {
+						continue;
+					}
+					if (!bits) {
+						bits.reset(new MaskData::Bits());
+						bits->fill(0);
+					}
+					(*bits)[b >> 6] |= 1ULL << (b & 63);
+					added++;
+
+					for (const int* o : offsets) {
+						Vec3i n(v.x + o[0], v.y + o[1], v.z + o[2]);
+						if (n.x < 0 || n.y < 0 || n.z < 0 || n.x >= w || n.y >= h || n.z >= d) {
+							continue;
+						}
+						if (n.x < origin.x || n.y < origin.y || n.z < origin.z || n.x >= origin.x + B || n.y >= origin.y + B || n.z >= origin.z + B) {
+							outbox.push_back(n);
+						} else {
+							stack.push_back(n);
+						}
+					}
+				}
+
+				if (added > 0) {
+					grew[i] = 1;
+					count_ += added;
+				}
+			}
+		});
+
+		// publish every brick that grew during this wave
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (size_t i = 0; i < active.size(); i++) {
+				if (grew[i]) {
+					published_[active[i].first] = *region[active[i].first];
+				}
+			}
+		}
+
+		for (vector<Vec3i>& outbox : outboxes) {
+			for (const Vec3i& v : outbox) {
+				wave[brickIndex(v)].push_back(v);
+			}
+		}
+	}
+
+	running_ = false;
+}
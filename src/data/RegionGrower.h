@@ -0,0 +1,67 @@
+#ifndef __MEDLEAP_REGION_GROWER__
+#define __MEDLEAP_REGION_GROWER__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "gl/math/Math.h"
+#include "VolumeData.h"
+#include "MaskData.h"
+
+/**
+ * Seeded region growing (6-connected flood fill) constrained by intensity and gradient
+ * magnitude. The fill advances as a wavefront over mask-sized bricks: every brick with pending
+ * seeds is filled by one worker thread, and voxels that cross into a neighboring brick are
+ * queued for the next wave. Bricks that grew are published after every wave so the mask can
+ * be updated while the fill is still running.
+ */
+class RegionGrower
+{
+public:
+	/** Acceptance criteria for voxels in the region */
+	struct Params
+	{
+		int lower;          // smallest accepted voxel value
+		int upper;          // largest accepted voxel value
+		float maxGradient;  // largest accepted gradient magnitude (ignored if <= 0)
+	};
+
+	typedef std::pair<unsigned, MaskData::Bits> BrickBits;
+
+	RegionGrower();
+	~RegionGrower();
+
+	/** Cancels any running fill and starts a new one from seed */
+	void start(VolumeData* volume, const gl::Vec3i& seed, const Params& params);
+
+	/** Stops the running fill; bricks already published are kept */
+	void cancel();
+
+	/** Stops the running fill and drops the bricks that haven't been taken (ex. the mask was edited or replaced) */
+	void discard();
+
+	/** True while the fill is running */
+	bool running() const { return running_; }
+
+	/** Moves the bricks that grew since the last call into bricks. Returns false if none did. */
+	bool take(std::vector<BrickBits>& bricks);
+
+	/** Number of voxels in the region so far */
+	uint64_t count() const { return count_; }
+
+private:
+	std::thread worker_;
+	std::atomic<bool> cancel_;
+	std::atomic<bool> running_;
+	std::atomic<uint64_t> count_;
+	std::mutex mutex_;
+	std::unordered_map<unsigned, MaskData::Bits> published_;
+
+	template <typename T>
+	void run(VolumeData* volume, gl::Vec3i seed, Params params);
+};
+
+#endif // __MEDLEAP_REGION_GROWER__
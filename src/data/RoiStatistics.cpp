@@ -0,0 +1,479 @@
+#include "RoiStatistics.h"
+#include "util/Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace gl;
+using namespace std;
+
+namespace
+{
+	enum class Coverage { inside, outside, partial };
+
+	/** FNV-1a hash used to detect changes in region predicates */
+	uint64_t hashBytes(uint64_t h, const void* data, size_t size)
+	{
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			h ^= p[i];
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+	template <typename T>
+	uint64_t hashValue(uint64_t h, const T& value)
+	{
+		return hashBytes(h, &value, sizeof(T));
+	}
+
+	const uint64_t hashSeed = 14695981039346656037ULL;
+
+	uint64_t hashPlane(uint64_t h, const Plane& p)
+	{
+		h = hashValue(h, p.normal());
+		return hashValue(h, p.distFromOrigin());
+	}
+
+	/** Voxels are kept on the side of the plane where dot(p, n) <= d */
+	Coverage classify(const Plane& plane, const Vec3& lo, const Vec3& hi)
+	{
+		Vec3 n = plane.normal();
+		float dmin = 0.0f;
+		float dmax = 0.0f;
+		for (int i = 0; i < 3; i++) {
+			dmin += n[i] * (n[i] > 0 ? lo[i] : hi[i]);
+			dmax += n[i] * (n[i] > 0 ? hi[i] : lo[i]);
+		}
+		if (dmax <= plane.distFromOrigin()) return Coverage::inside;
+		if (dmin > plane.distFromOrigin()) return Coverage::outside;
+		return Coverage::partial;
+	}
+
+	/** Voxels are kept inside the sphere */
+	Coverage classify(const Vec3& center, float radius, const Vec3& lo, const Vec3& hi)
+	{
+		float nearest = 0.0f;
+		float farthest = 0.0f;
+		for (int i = 0; i < 3; i++) {
+			float c = std::max(lo[i], std::min(center[i], hi[i])) - center[i];
+			float f = std::max(std::abs(lo[i] - center[i]), std::abs(hi[i] - center[i]));
+			nearest += c * c;
+			farthest += f * f;
+		}
+		float r2 = radius * radius;
+		if (farthest <= r2) return Coverage::inside;
+		if (nearest > r2) return Coverage::outside;
+		return Coverage::partial;
+	}
+
+	/** Voxels are kept where the mask is not set; collects the mask bricks overlapping [min, max) */
+	Coverage classify(const MaskData& mask, const Vec3i& min, const Vec3i& max, std::vector<MaskData::BrickPtr>& key)
+	{
+		bool empty = true;
+		bool full = true;
+		key.clear();
+		for (int bz = min.z / MaskData::brickSize; bz <= (max.z - 1) / MaskData::brickSize; bz++) {
+			for (int by = min.y / MaskData::brickSize; by <= (max.y - 1) / MaskData::brickSize; by++) {
+				for (int bx = min.x / MaskData::brickSize; bx <= (max.x - 1) / MaskData::brickSize; bx++) {
+					const MaskData::BrickPtr& brick = mask.brick(bx, by, bz);
+					empty = empty && brick == MaskData::empty();
+					full = full && brick == MaskData::full();
+					key.push_back(brick);
+				}
+			}
+		}
+		if (empty) return Coverage::inside;
+		if (full) return Coverage::outside;
+		return Coverage::partial;
+	}
+}
+
+void RoiStatistics::Stats::add(int value)
+{
+	count++;
+	sum += value;
+	sumSq += (double)value * value;
+	min = std::min(min, value);
+	max = std::max(max, value);
+}
+
+void RoiStatistics::Stats::add(const Stats& stats)
+{
+	count += stats.count;
+	sum += stats.sum;
+	sumSq += stats.sumSq;
+	min = std::min(min, stats.min);
+	max = std::max(max, stats.max);
+}
+
+RoiStatistics::RoiStatistics() :
+	volume_(nullptr),
+	bricksReady_(false),
+	hasPending_(false),
+	stop_(false),
+	generation_(0),
+	busy_(false),
+	lastSignature_(0),
+	hasResult_(false),
+	fresh_(false)
+{
+}
+
+RoiStatistics::~RoiStatistics()
+{
+	stopWorker();
+}
+
+void RoiStatistics::setVolume(VolumeData* volume)
+{
+	stopWorker();
+
+	volume_ = volume;
+	bricks_.clear();
+	bricksReady_ = false;
+	hasPending_ = false;
+	hasResult_ = false;
+	fresh_ = false;
+	lastSignature_ = 0;
+
+	if (volume_) {
+		startWorker();
+	}
+}
+
+void RoiStatistics::update(const Region& region)
+{
+	if (!volume_) {
+		return;
+	}
+
+	uint64_t signature = hashSeed;
+	for (const Plane& p : region.clipPlanes) {
+		signature = hashPlane(signature, p);
+	}
+	if (region.useSphere) {
+		signature = hashValue(signature, region.sphereCenter);
+		signature = hashValue(signature, region.sphereRadius);
+	}
+	if (region.mask) {
+		signature = hashValue(signature, region.mask->version());
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (signature == lastSignature_) {
+		return;
+	}
+	lastSignature_ = signature;
+	pending_ = region;
+	hasPending_ = true;
+	generation_++;
+	cv_.notify_one();
+}
+
+bool RoiStatistics::result(Result& result)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	result = result_;
+	bool fresh = fresh_;
+	fresh_ = false;
+	return fresh;
+}
+
+bool RoiStatistics::hasResult()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return hasResult_;
+}
+
+bool RoiStatistics::busy() const
+{
+	return busy_;
+}
+
+bool RoiStatistics::pending() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return hasPending_ || busy_ || fresh_;
+}
+
+void RoiStatistics::startWorker()
+{
+	stop_ = false;
+	worker_ = std::thread(&RoiStatistics::run, this);
+}
+
+void RoiStatistics::stopWorker()
+{
+	if (worker_.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+			generation_++;
+		}
+		cv_.notify_one();
+		worker_.join();
+	}
+}
+
+bool RoiStatistics::cancelled(unsigned generation) const
+{
+	return generation != generation_;
+}
+
+void RoiStatistics::run()
+{
+	while (true) {
+		Region region;
+		unsigned generation;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [&]{ return stop_ || hasPending_; });
+			if (stop_) {
+				return;
+			}
+			region = pending_;
+			hasPending_ = false;
+			generation = generation_;
+		}
+
+		busy_ = true;
+		bool ok = true;
+		Result result = compute(region, generation, ok);
+
+		// publish before clearing busy_ so pending() never misses a result
+		if (ok) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			result_ = result;
+			hasResult_ = true;
+			fresh_ = true;
+		}
+		busy_ = false;
+	}
+}
+
+RoiStatistics::Result RoiStatistics::compute(const Region& region, unsigned generation, bool& ok)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	Stats stats;
+	switch (volume_->getType())
+	{
+	case GL_BYTE:
+		buildBricks<GLbyte>(generation, ok);
+		stats = evaluate<GLbyte>(region, generation, ok);
+		break;
+	case GL_UNSIGNED_BYTE:
+		buildBricks<GLubyte>(generation, ok);
+		stats = evaluate<GLubyte>(region, generation, ok);
+		break;
+	case GL_SHORT:
+		buildBricks<GLshort>(generation, ok);
+		stats = evaluate<GLshort>(region, generation, ok);
+		break;
+	case GL_UNSIGNED_SHORT:
+		buildBricks<GLushort>(generation, ok);
+		stats = evaluate<GLushort>(region, generation, ok);
+		break;
+	}
+
+	Result result;
+	result.count = stats.count;
+	result.mean = 0.0;
+	result.stdDev = 0.0;
+	result.min = 0;
+	result.max = 0;
+	if (stats.count > 0) {
+		result.mean = stats.sum / stats.count;
+		result.stdDev = std::sqrt(std::max(0.0, stats.sumSq / stats.count - result.mean * result.mean));
+		result.min = stats.min;
+		result.max = stats.max;
+	}
+	Vec3 mm = volume_->getVoxelSizeMillimeters();
+	result.volumeMl = stats.count * (double)mm.x * mm.y * mm.z / 1000.0;
+	result.seconds = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::high_resolution_clock::now() - start).count();
+	return result;
+}
+
+template <typename T>
+void RoiStatistics::buildBricks(unsigned generation, bool& ok)
+{
+	if (bricksReady_ || !ok) {
+		return;
+	}
+
+	int w = volume_->getWidth();
+	int h = volume_->getHeight();
+	int d = volume_->getDepth();
+	int bw = (w + brickSize - 1) / brickSize;
+	int bh = (h + brickSize - 1) / brickSize;
+	int bd = (d + brickSize - 1) / brickSize;
+
+	// voxel centers in world space (matches texture coordinates in the volume shader)
+	const Box& bounds = volume_->getBounds();
+	voxelStep_ = bounds.size() / Vec3((float)w, (float)h, (float)d);
+	voxelOrigin_ = bounds.min() + voxelStep_ * 0.5f;
+
+	bricks_.resize(bw * bh * bd);
+	for (int z = 0; z < bd; z++) {
+		for (int y = 0; y < bh; y++) {
+			for (int x = 0; x < bw; x++) {
+				Brick& b = bricks_[(z * bh + y) * bw + x];
+				b.min = Vec3i(x * brickSize, y * brickSize, z * brickSize);
+				b.max = Vec3i(std::min<int>(w, b.min.x + brickSize), std::min<int>(h, b.min.y + brickSize), std::min<int>(d, b.min.z + brickSize));
+				b.lo = voxelOrigin_ + voxelStep_ * Vec3((float)b.min.x, (float)b.min.y, (float)b.min.z);
+				b.hi = voxelOrigin_ + voxelStep_ * Vec3((float)(b.max.x - 1), (float)(b.max.y - 1), (float)(b.max.z - 1));
+				b.full = Stats();
+				b.cached = false;
+			}
+		}
+	}
+
+	const T* data = reinterpret_cast<const T*>(volume_->getData());
+	std::atomic<bool> aborted(false);
+	parallelFor(0, bricks_.size(), [&](unsigned, size_t begin, size_t end) {
+		for (size_t i = begin; i < end && !aborted; i++) {
+			if (cancelled(generation)) {
+				aborted = true;
+				break;
+			}
+			Brick& b = bricks_[i];
+			for (int z = b.min.z; z < b.max.z; z++) {
+				for (int y = b.min.y; y < b.max.y; y++) {
+					const T* row = data + ((size_t)z * h + y) * w;
+					for (int x = b.min.x; x < b.max.x; x++) {
+						b.full.add(row[x]);
+					}
+				}
+			}
+		}
+	});
+
+	ok = !aborted;
+	bricksReady_ = ok;
+}
+
+template <typename T>
+RoiStatistics::Stats RoiStatistics::evaluate(const Region& region, unsigned generation, bool& ok)
+{
+	if (!ok) {
+		return Stats();
+	}
+
+	int w = volume_->getWidth();
+	int h = volume_->getHeight();
+	const T* data = reinterpret_cast<const T*>(volume_->getData());
+
+	// ignore a mask that does not belong to this volume
+	const MaskData* mask = region.mask.get();
+	if (mask && (mask->width() != w || mask->height() != h || mask->depth() != (int)volume_->getDepth())) {
+		mask = nullptr;
+	}
+
+	unsigned numThreads = workerCount();
+	std::vector<Stats> totals(numThreads);
+	std::atomic<bool> aborted(false);
+
+	parallelFor(0, bricks_.size(), numThreads, [&](unsigned thread, size_t begin, size_t end) {
+		Stats& total = totals[thread];
+		std::vector<const Plane*> planes;
+		std::vector<MaskData::BrickPtr> maskKey;
+
+		for (size_t i = begin; i < end; i++) {
+			if (cancelled(generation)) {
+				aborted = true;
+				return;
+			}
+
+			// classify the brick against every predicate; only those that cut the brick need
+			// to be tested per voxel
+			Brick& b = bricks_[i];
+			bool outside = false;
+			bool sphere = false;
+			bool masked = false;
+			uint64_t signature = hashSeed;
+			planes.clear();
+			maskKey.clear();
+
+			for (const Plane& p : region.clipPlanes) {
+				Coverage c = classify(p, b.lo, b.hi);
+				outside = outside || c == Coverage::outside;
+				if (c == Coverage::partial) {
+					planes.push_back(&p);
+					signature = hashPlane(signature, p);
+				}
+			}
+			if (!outside && region.useSphere) {
+				Coverage c = classify(region.sphereCenter, region.sphereRadius, b.lo, b.hi);
+				outside = c == Coverage::outside;
+				if (c == Coverage::partial) {
+					sphere = true;
+					signature = hashValue(signature, region.sphereCenter);
+					signature = hashValue(signature, region.sphereRadius);
+				}
+			}
+			if (!outside && mask) {
+				Coverage c = classify(*mask, b.min, b.max, maskKey);
+				outside = c == Coverage::outside;
+				masked = c == Coverage::partial;
+				if (!masked) {
+					maskKey.clear();
+				}
+			}
+
+			if (outside) {
+				continue;
+			}
+			if (planes.empty() && !sphere && !masked) {
+				total.add(b.full);
+				continue;
+			}
+			if (b.cached && b.signature == signature && b.maskKey == maskKey) {
+				total.add(b.partial);
+				continue;
+			}
+
+			Stats partial;
+			float r2 = region.sphereRadius * region.sphereRadius;
+			for (int z = b.min.z; z < b.max.z; z++) {
+				for (int y = b.min.y; y < b.max.y; y++) {
+					const T* row = data + ((size_t)z * h + y) * w;
+					for (int x = b.min.x; x < b.max.x; x++) {
+						Vec3 p = voxelOrigin_ + voxelStep_ * Vec3((float)x, (float)y, (float)z);
+
+						bool keep = true;
+						for (size_t k = 0; keep && k < planes.size(); k++) {
+							keep = p.dot(planes[k]->normal()) <= planes[k]->distFromOrigin();
+						}
+						if (keep && sphere) {
+							keep = (p - region.sphereCenter).lengthSquared() <= r2;
+						}
+						if (keep && masked) {
+							keep = !mask->get(x, y, z);
+						}
+
+						if (keep) {
+							partial.add(row[x]);
+						}
+					}
+				}
+			}
+
+			b.partial = partial;
+			b.signature = signature;
+			b.maskKey = maskKey;
+			b.cached = true;
+			total.add(partial);
+		}
+	});
+
+	ok = !aborted;
+
+	Stats stats;
+	for (const Stats& s : totals) {
+		stats.add(s);
+	}
+	return stats;
+}
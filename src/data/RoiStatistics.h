@@ -0,0 +1,130 @@
+#ifndef __MEDLEAP_ROI_STATISTICS__
+#define __MEDLEAP_ROI_STATISTICS__
+
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gl/geom/Plane.h"
+#include "gl/math/Math.h"
+#include "VolumeData.h"
+#include "MaskData.h"
+
+/**
+ * Computes statistics (mean, standard deviation, min/max, volume) of the voxels kept by the clip
+ * planes and mask and, optionally, within a radius of the focus cursor. The volume is divided into
+ * bricks that store precomputed statistics, so only bricks cut by the region boundary are
+ * visited voxel-by-voxel. Computation runs on a background thread; results are polled.
+ */
+class RoiStatistics
+{
+public:
+	/**
+	 * Predicates that define the region of interest. Clip planes and mask match the volume shader;
+	 * the sphere does not, since the shader only fades a screen-space circle around the cursor.
+	 */
+	struct Region
+	{
+		Region() : useSphere(false), sphereRadius(0.0f) {}
+
+		std::vector<gl::Plane> clipPlanes;
+		bool useSphere;          // keep only voxels within sphereRadius of sphereCenter
+		gl::Vec3 sphereCenter;   // volume (world) space
+		float sphereRadius;
+		std::shared_ptr<const MaskData> mask;
+	};
+
+	struct Result
+	{
+		uint64_t count;
+		double mean;
+		double stdDev;
+		int min;
+		int max;
+		double volumeMl;
+		double seconds;
+	};
+
+	RoiStatistics();
+	~RoiStatistics();
+
+	/** Changes the volume; any pending computation is cancelled */
+	void setVolume(VolumeData* volume);
+
+	/** Requests statistics for a region. Returns immediately; identical requests are ignored. */
+	void update(const Region& region);
+
+	/** Copies the latest result and returns true if it is newer than the last call */
+	bool result(Result& result);
+
+	/** True if at least one result has been computed for the current volume */
+	bool hasResult();
+
+	/** True while the background thread is computing */
+	bool busy() const;
+
+	/** True if a request is queued, being computed, or has a result that was not read yet */
+	bool pending() const;
+
+	static const int brickSize = 2 * MaskData::brickSize;
+
+private:
+	struct Stats
+	{
+		Stats() : count(0), sum(0.0), sumSq(0.0), min(INT_MAX), max(INT_MIN) {}
+
+		uint64_t count;
+		double sum;
+		double sumSq;
+		int min;
+		int max;
+
+		void add(int value);
+		void add(const Stats& stats);
+	};
+
+	struct Brick
+	{
+		gl::Vec3i min;      // first voxel index
+		gl::Vec3i max;      // one past the last voxel index
+		gl::Vec3 lo;        // world position of first voxel center
+		gl::Vec3 hi;        // world position of last voxel center
+		Stats full;         // statistics of every voxel in the brick
+		uint64_t signature; // predicates used to compute 'partial'
+		std::vector<MaskData::BrickPtr> maskKey; // mask bricks used to compute 'partial'
+		Stats partial;      // cached statistics of a partially covered brick
+		bool cached;
+	};
+
+	VolumeData* volume_;
+	std::vector<Brick> bricks_;
+	bool bricksReady_;
+	gl::Vec3 voxelOrigin_;
+	gl::Vec3 voxelStep_;
+
+	std::thread worker_;
+	mutable std::mutex mutex_;
+	std::condition_variable cv_;
+	Region pending_;
+	bool hasPending_;
+	bool stop_;
+	std::atomic<unsigned> generation_;
+	std::atomic<bool> busy_;
+	uint64_t lastSignature_;
+	Result result_;
+	bool hasResult_;
+	bool fresh_;
+
+	void startWorker();
+	void stopWorker();
+	void run();
+	bool cancelled(unsigned generation) const;
+	Result compute(const Region& region, unsigned generation, bool& ok);
+	template <typename T> void buildBricks(unsigned generation, bool& ok);
+	template <typename T> Stats evaluate(const Region& region, unsigned generation, bool& ok);
+};
+
+#endif // __MEDLEAP_ROI_STATISTICS__
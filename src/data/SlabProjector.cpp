@@ -0,0 +1,194 @@
+#include "SlabProjector.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+	const size_t maxBlocks = 4;
+
+	int floorDiv(int a, int b)
+	{
+		return (a >= 0) ? a / b : -((-a + b - 1) / b);
+	}
+}
+
+SlabProjector::SlabProjector() :
+	mode_(MIP),
+	thickness_(1),
+	numSlices_(0),
+	numPixels_(0),
+	type_(GL_UNSIGNED_BYTE),
+	useCounter_(0)
+{
+}
+
+const char* SlabProjector::name(Mode mode)
+{
+	switch (mode) {
+	case MIP: return "MIP";
+	case MINIP: return "MinIP";
+	case MEAN: return "Mean";
+	default: return "";
+	}
+}
+
+void SlabProjector::configure(Mode mode, int thickness, int numSlices, size_t numPixels, GLenum type)
+{
+	thickness = std::max(1, thickness);
+	if (mode == mode_ && thickness == thickness_ && numSlices == numSlices_ && numPixels == numPixels_ && type == type_) {
+		return;
+	}
+
+	mode_ = mode;
+	thickness_ = thickness;
+	numSlices_ = numSlices;
+	numPixels_ = numPixels;
+	type_ = type;
+	clear();
+}
+
+void SlabProjector::clear()
+{
+	blocks_.clear();
+	useCounter_ = 0;
+}
+
+int SlabProjector::identity() const
+{
+	switch (mode_) {
+	case MIP: return INT_MIN;
+	case MINIP: return INT_MAX;
+	default: return 0;
+	}
+}
+
+void SlabProjector::combine(int* dst, const int* src) const
+{
+	// plain loops over contiguous arrays so the compiler can vectorize them
+	const size_t n = numPixels_;
+	switch (mode_) {
+	case MIP:
+		for (size_t i = 0; i < n; i++)
+			dst[i] = std::max(dst[i], src[i]);
+		break;
+	case MINIP:
+		for (size_t i = 0; i < n; i++)
+			dst[i] = std::min(dst[i], src[i]);
+		break;
+	default:
+		for (size_t i = 0; i < n; i++)
+			dst[i] += src[i];
+		break;
+	}
+}
+
+template <typename T>
+void SlabProjector::load(const T* src, int* dst) const
+{
+	for (size_t i = 0; i < numPixels_; i++)
+		dst[i] = src[i];
+}
+
+void SlabProjector::load(int index, const SliceFunction& slice, int* dst) const
+{
+	if (index < 0 || index >= numSlices_) {
+		std::fill(dst, dst + numPixels_, identity());
+		return;
+	}
+
+	const void* src = slice(index);
+	switch (type_) {
+	case GL_BYTE: load(static_cast<const GLbyte*>(src), dst); break;
+	case GL_UNSIGNED_BYTE: load(static_cast<const GLubyte*>(src), dst); break;
+	case GL_SHORT: load(static_cast<const GLshort*>(src), dst); break;
+	case GL_UNSIGNED_SHORT: load(static_cast<const GLushort*>(src), dst); break;
+	}
+}
+
+const int* SlabProjector::block(int index, bool suffix, const SliceFunction& slice)
+{
+	for (Block& b : blocks_) {
+		if (b.index == index && b.suffix == suffix) {
+			b.lastUse = ++useCounter_;
+			return &b.data[0];
+		}
+	}
+
+	// reuse the least recently used block once the cache is full
+	Block* b;
+	if (blocks_.size() < maxBlocks) {
+		blocks_.push_back(Block());
+		b = &blocks_.back();
+	} else {
+		b = &*std::min_element(blocks_.begin(), blocks_.end(), [](const Block& x, const Block& y) {
+			return x.lastUse < y.lastUse;
+		});
+	}
+	b->index = index;
+	b->suffix = suffix;
+	b->lastUse = ++useCounter_;
+	b->data.resize(numPixels_ * thickness_);
+
+	// image i holds slices [first, first + i] (prefix) or [first + i, first + thickness) (suffix)
+	int first = index * thickness_;
+	int* data = &b->data[0];
+	if (suffix) {
+		for (int i = thickness_ - 1; i >= 0; i--) {
+			int* image = data + i * numPixels_;
+			load(first + i, slice, image);
+			if (i < thickness_ - 1)
+				combine(image, image + numPixels_);
+		}
+	} else {
+		for (int i = 0; i < thickness_; i++) {
+			int* image = data + i * numPixels_;
+			load(first + i, slice, image);
+			if (i > 0)
+				combine(image, image - numPixels_);
+		}
+	}
+
+	return data;
+}
+
+template <typename T>
+void SlabProjector::store(const int* src, int count, T* dst) const
+{
+	if (mode_ == MEAN) {
+		float n = (float)std::max(1, count);
+		for (size_t i = 0; i < numPixels_; i++)
+			dst[i] = static_cast<T>(std::floor(src[i] / n + 0.5f));
+	} else {
+		for (size_t i = 0; i < numPixels_; i++)
+			dst[i] = static_cast<T>(src[i]);
+	}
+}
+
+void SlabProjector::project(int first, const SliceFunction& slice, vector<char>& out)
+{
+	// window = suffix of the block containing 'first' + prefix of the next block
+	int index = floorDiv(first, thickness_);
+	int offset = first - index * thickness_;
+
+	window_.resize(numPixels_);
+	const int* suffix = block(index, true, slice) + offset * numPixels_;
+	std::copy(suffix, suffix + numPixels_, window_.begin());
+	if (offset > 0) {
+		const int* prefix = block(index + 1, false, slice) + (offset - 1) * numPixels_;
+		combine(&window_[0], prefix);
+	}
+
+	int count = std::min(first + thickness_, numSlices_) - std::max(first, 0);
+
+	size_t bytes = (type_ == GL_SHORT || type_ == GL_UNSIGNED_SHORT) ? 2 : 1;
+	out.resize(numPixels_ * bytes);
+	switch (type_) {
+	case GL_BYTE: store(&window_[0], count, reinterpret_cast<GLbyte*>(&out[0])); break;
+	case GL_UNSIGNED_BYTE: store(&window_[0], count, reinterpret_cast<GLubyte*>(&out[0])); break;
+	case GL_SHORT: store(&window_[0], count, reinterpret_cast<GLshort*>(&out[0])); break;
+	case GL_UNSIGNED_SHORT: store(&window_[0], count, reinterpret_cast<GLushort*>(&out[0])); break;
+	}
+}
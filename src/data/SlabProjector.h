@@ -0,0 +1,69 @@
+#ifndef __MEDLEAP_SLAB_PROJECTOR__
+#define __MEDLEAP_SLAB_PROJECTOR__
+
+#include <functional>
+#include <vector>
+#include "gl/glew.h"
+
+/**
+ * Thick-slab projection (maximum, minimum, or mean) over a window of consecutive slices.
+ * Slices are grouped into blocks as long as the slab; each block stores running prefix and
+ * suffix projections, so any window is the combination of one suffix image and one prefix
+ * image. Moving the slab by one slice in either direction reuses the cached blocks, and a new
+ * block (one pass over its slices) is only needed once every 'thickness' slices.
+ */
+class SlabProjector
+{
+public:
+	enum Mode { MIP, MINIP, MEAN, NUM_OF_MODES };
+
+	/** Returns slice 'index' as an image of the configured size and type; valid until the next call */
+	typedef std::function<const void*(int index)> SliceFunction;
+
+	SlabProjector();
+
+	/** Sets the projection parameters; cached blocks are discarded if any of them changed */
+	void configure(Mode mode, int thickness, int numSlices, size_t numPixels, GLenum type);
+
+	/** Discards cached blocks (the slices themselves changed) */
+	void clear();
+
+	/**
+	 * Projects slices [first, first + thickness) into out, which receives one value of the
+	 * configured type per pixel. Slices outside the stack are ignored.
+	 */
+	void project(int first, const SliceFunction& slice, std::vector<char>& out);
+
+	Mode mode() const { return mode_; }
+	int thickness() const { return thickness_; }
+
+	static const char* name(Mode mode);
+
+private:
+	struct Block
+	{
+		int index;
+		bool suffix;
+		unsigned lastUse;
+		std::vector<int> data;
+	};
+
+	Mode mode_;
+	int thickness_;
+	int numSlices_;
+	size_t numPixels_;
+	GLenum type_;
+	std::vector<Block> blocks_;
+	std::vector<int> window_;
+	unsigned useCounter_;
+
+	const int* block(int index, bool suffix, const SliceFunction& slice);
+	void load(int index, const SliceFunction& slice, int* dst) const;
+	void combine(int* dst, const int* src) const;
+	int identity() const;
+
+	template <typename T> void load(const T* src, int* dst) const;
+	template <typename T> void store(const int* src, int count, T* dst) const;
+};
+
+#endif // __MEDLEAP_SLAB_PROJECTOR__
@@ -2,6 +2,7 @@
 #define __MEDLEAP_VOLUME_DATA__
 
 #include "gl/glew.h"
+#include <functional>
 #include <vector>
 #include <string>
 #include <thread>
@@ -139,8 +140,8 @@ private:
 		return (int)(((T*)(data))[z * width * height + y * width + x]);
 	}
 
-    /** Computes gradient vectors for this volume. Gradients are always stored as floats, regardless of the volume data type. */
-    template<typename T> void computeGradients()
+    /** Computes gradient vectors for this volume. Gradients are always stored as floats, regardless of the volume data type. sliceDone, if set, is called from the worker threads after each slice. */
+    template<typename T> void computeGradients(const std::function<void()>& sliceDone = nullptr)
     {
 		using namespace gl;
 
@@ -184,6 +185,8 @@ private:
 						gradients[z * width * height + y * width + x] = g;
 					}
 				}
+				if (sliceDone)
+					sliceDone();
 			}
 		};
 
@@ -0,0 +1,589 @@
+#include "VolumeFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#ifdef MEDLEAP_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace gl;
+using namespace std;
+
+namespace
+{
+	/** Compressed bytes read from the file at a time */
+	const size_t inputChunk = 256 * 1024;
+
+	/** Largest accepted size along any axis (NIfTI stores them as 16 bit integers) */
+	const unsigned maxDimension = 32767;
+
+	bool endsWith(const string& s, const string& suffix)
+	{
+		if (s.size() < suffix.size()) {
+			return false;
+		}
+		return equal(suffix.rbegin(), suffix.rend(), s.rbegin(), [](char a, char b) { return tolower(a) == tolower(b); });
+	}
+
+	string lower(string s)
+	{
+		transform(s.begin(), s.end(), s.begin(), ::tolower);
+		return s;
+	}
+
+	string trim(const string& s)
+	{
+		size_t begin = s.find_first_not_of(" \t\r\n");
+		size_t end = s.find_last_not_of(" \t\r\n");
+		return (begin == string::npos) ? string() : s.substr(begin, end - begin + 1);
+	}
+
+	/** Directory of a file, including the trailing separator */
+	string directoryOf(const string& fileName)
+	{
+		size_t i = fileName.find_last_of("/\\");
+		return (i == string::npos) ? string() : fileName.substr(0, i + 1);
+	}
+
+	/** Relative data file names are relative to the header */
+	string resolve(const string& headerFile, const string& dataFile)
+	{
+		bool absolute = !dataFile.empty() && (dataFile[0] == '/' || dataFile[0] == '\\' || (dataFile.size() > 1 && dataFile[1] == ':'));
+		return absolute ? dataFile : directoryOf(headerFile) + dataFile;
+	}
+
+	bool littleEndianHost()
+	{
+		const unsigned short one = 1;
+		return *reinterpret_cast<const unsigned char*>(&one) == 1;
+	}
+
+	template <typename T> T field(const char* header, size_t offset, bool swap)
+	{
+		T value;
+		memcpy(&value, header + offset, sizeof(T));
+		if (swap) {
+			char* bytes = reinterpret_cast<char*>(&value);
+			reverse(bytes, bytes + sizeof(T));
+		}
+		return value;
+	}
+
+	/** RAS (NIfTI, some NRRD files) to LPS (DICOM) */
+	Vec3 rasToLps(const Vec3& v)
+	{
+		return Vec3(-v.x, -v.y, v.z);
+	}
+
+	/** NRRD and MetaImage type names */
+	GLenum typeFromName(const string& name)
+	{
+		static map<string, GLenum> types;
+		if (types.empty()) {
+			const char* bytes[] = { "signed char", "int8", "int8_t", "met_char" };
+			const char* ubytes[] = { "uchar", "unsigned char", "uint8", "uint8_t", "met_uchar" };
+			const char* shorts[] = { "short", "short int", "signed short", "signed short int", "int16", "int16_t", "met_short" };
+			const char* ushorts[] = { "ushort", "unsigned short", "unsigned short int", "uint16", "uint16_t", "met_ushort" };
+			for (const char* n : bytes) types[n] = GL_BYTE;
+			for (const char* n : ubytes) types[n] = GL_UNSIGNED_BYTE;
+			for (const char* n : shorts) types[n] = GL_SHORT;
+			for (const char* n : ushorts) types[n] = GL_UNSIGNED_SHORT;
+		}
+		auto it = types.find(lower(name));
+		return (it == types.end()) ? 0 : it->second;
+	}
+
+	template <typename T> vector<T> values(const string& s)
+	{
+		vector<T> result;
+		stringstream ss(s);
+		T v;
+		while (ss >> v) {
+			result.push_back(v);
+		}
+		return result;
+	}
+
+	/** Parses NRRD vectors such as "(1,0,0) (0,1,0) (0,0,2.5)"; "none" entries are skipped */
+	vector<Vec3> vectors(const string& s)
+	{
+		vector<Vec3> result;
+		size_t open = s.find('(');
+		while (open != string::npos) {
+			size_t close = s.find(')', open);
+			if (close == string::npos) {
+				break;
+			}
+			string inner = s.substr(open + 1, close - open - 1);
+			replace(inner.begin(), inner.end(), ',', ' ');
+			vector<float> v = values<float>(inner);
+			if (v.size() == 3) {
+				result.push_back(Vec3(v[0], v[1], v[2]));
+			}
+			open = s.find('(', close);
+		}
+		return result;
+	}
+
+	void defaults(VolumeFile::Header& header)
+	{
+		header.dataOffset = 0;
+		header.skip = 0;
+		header.compressed = false;
+		header.bigEndian = false;
+		header.width = header.height = header.depth = 0;
+		header.type = 0;
+		header.slope = 1.0;
+		header.intercept = 0.0;
+		header.spacing = Vec3(1.0f);
+		header.orientation = Mat3();
+	}
+}
+
+// ---------------------------------------------------------------------------------------------
+
+#ifdef MEDLEAP_HAVE_ZLIB
+struct VolumeFile::Stream::Inflater
+{
+	z_stream z;
+	bool ended;
+};
+#else
+struct VolumeFile::Stream::Inflater
+{
+};
+#endif
+
+VolumeFile::Stream::Stream()
+{
+}
+
+VolumeFile::Stream::~Stream()
+{
+#ifdef MEDLEAP_HAVE_ZLIB
+	if (inflater_) {
+		inflateEnd(&inflater_->z);
+	}
+#endif
+}
+
+bool VolumeFile::Stream::open(const string& fileName, size_t offset, bool compressed)
+{
+	file_.open(fileName.c_str(), ios::in | ios::binary);
+	if (!file_ || !file_.seekg(offset)) {
+		return false;
+	}
+
+	if (!compressed) {
+		return true;
+	}
+
+#ifdef MEDLEAP_HAVE_ZLIB
+	inflater_.reset(new Inflater);
+	memset(&inflater_->z, 0, sizeof(z_stream));
+	inflater_->ended = false;
+	input_.resize(inputChunk);
+
+	// 15 + 32: maximum window, detect a zlib or gzip header
+	if (inflateInit2(&inflater_->z, 15 + 32) != Z_OK) {
+		inflater_.reset();
+		return false;
+	}
+	return true;
+#else
+	cerr << "Compressed volume files need zlib: " << fileName << endl;
+	return false;
+#endif
+}
+
+bool VolumeFile::Stream::read(char* data, size_t size)
+{
+	if (!inflater_) {
+		file_.read(data, size);
+		return file_.gcount() == static_cast<streamsize>(size);
+	}
+
+#ifdef MEDLEAP_HAVE_ZLIB
+	// decompress straight into the destination; input is refilled as it runs out
+	z_stream& z = inflater_->z;
+	z.next_out = reinterpret_cast<Bytef*>(data);
+	z.avail_out = static_cast<uInt>(size);
+	while (z.avail_out > 0) {
+		if (inflater_->ended) {
+			return false;
+		}
+		if (z.avail_in == 0) {
+			file_.read(&input_[0], input_.size());
+			z.avail_in = static_cast<uInt>(file_.gcount());
+			z.next_in = reinterpret_cast<Bytef*>(&input_[0]);
+			if (z.avail_in == 0) {
+				return false;
+			}
+		}
+
+		int status = inflate(&z, Z_NO_FLUSH);
+		if (status == Z_STREAM_END) {
+			inflater_->ended = true;
+		} else if (status != Z_OK && status != Z_BUF_ERROR) {
+			return false;
+		}
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool VolumeFile::Stream::skip(size_t size)
+{
+	if (!inflater_) {
+		return static_cast<bool>(file_.seekg(size, ios::cur));
+	}
+
+	vector<char> discard(min(size, inputChunk));
+	while (size > 0) {
+		size_t n = min(size, discard.size());
+		if (!read(&discard[0], n)) {
+			return false;
+		}
+		size -= n;
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------
+
+VolumeFile::Format VolumeFile::format(const string& fileName)
+{
+	if (endsWith(fileName, ".nii") || endsWith(fileName, ".nii.gz")) {
+		return Format::nifti;
+	} else if (endsWith(fileName, ".nrrd") || endsWith(fileName, ".nhdr")) {
+		return Format::nrrd;
+	} else if (endsWith(fileName, ".mha") || endsWith(fileName, ".mhd")) {
+		return Format::metaimage;
+	}
+	return Format::unknown;
+}
+
+bool VolumeFile::readHeader(const string& fileName, Header& header, string& error)
+{
+	defaults(header);
+	header.dataFile = fileName;
+
+	bool ok;
+	switch (format(fileName)) {
+	case Format::nifti:
+		ok = readNifti(fileName, header, error);
+		break;
+	case Format::nrrd:
+		ok = readNrrd(fileName, header, error);
+		break;
+	case Format::metaimage:
+		ok = readMetaImage(fileName, header, error);
+		break;
+	default:
+		error = "unknown file format";
+		return false;
+	}
+
+	if (ok && (header.width == 0 || header.height == 0 || header.depth == 0)) {
+		error = "empty volume";
+		return false;
+	}
+
+	// voxel counts are unsigned and every voxel also gets a gradient, so larger volumes can't be loaded
+	uint64_t voxels = static_cast<uint64_t>(header.width) * header.height * header.depth;
+	if (ok && (header.width > maxDimension || header.height > maxDimension || header.depth > maxDimension ||
+		voxels > numeric_limits<unsigned>::max() / sizeof(gl::Vec3))) {
+		error = "volume is too large";
+		return false;
+	}
+	if (ok && header.type == 0) {
+		error = "unsupported voxel type (only 8 and 16 bit integers)";
+		return false;
+	}
+#ifndef MEDLEAP_HAVE_ZLIB
+	if (ok && header.compressed) {
+		error = "compressed data needs zlib";
+		return false;
+	}
+#endif
+	return ok;
+}
+
+bool VolumeFile::readNifti(const string& fileName, Header& header, string& error)
+{
+	const size_t headerSize = 348;
+
+	header.compressed = endsWith(fileName, ".gz");
+	Stream stream;
+	char h[headerSize];
+	if (!stream.open(fileName, 0, header.compressed) || !stream.read(h, headerSize)) {
+		error = "can't read the NIfTI header";
+		return false;
+	}
+
+	// the header size tells the byte order
+	bool swap = field<int>(h, 0, false) != static_cast<int>(headerSize);
+	if (swap && field<int>(h, 0, true) != static_cast<int>(headerSize)) {
+		error = "not a NIfTI-1 file";
+		return false;
+	}
+	if (memcmp(h + 344, "n+1", 4) != 0) {
+		error = "only single file NIfTI-1 (.nii) is supported";
+		return false;
+	}
+	header.bigEndian = littleEndianHost() == swap;
+
+	short dims = field<short>(h, 40, swap);
+	if (dims < 3) {
+		error = "not a 3D volume";
+		return false;
+	}
+	if (dims > 3 && field<short>(h, 48, swap) > 1) {
+		cerr << "Warning: only the first volume of " << fileName << " is loaded" << endl;
+	}
+	short width = field<short>(h, 42, swap);
+	short height = field<short>(h, 44, swap);
+	short depth = field<short>(h, 46, swap);
+	if (width <= 0 || height <= 0 || depth <= 0) {
+		error = "invalid dimensions";
+		return false;
+	}
+	header.width = width;
+	header.height = height;
+	header.depth = depth;
+
+	switch (field<short>(h, 70, swap)) {
+	case 2: header.type = GL_UNSIGNED_BYTE; break;
+	case 4: header.type = GL_SHORT; break;
+	case 256: header.type = GL_BYTE; break;
+	case 512: header.type = GL_UNSIGNED_SHORT; break;
+	default: header.type = 0; break;
+	}
+
+	float qfac = field<float>(h, 76, swap) < 0.0f ? -1.0f : 1.0f;
+	header.spacing = Vec3(fabs(field<float>(h, 80, swap)), fabs(field<float>(h, 84, swap)), fabs(field<float>(h, 88, swap)));
+	header.skip = static_cast<size_t>(field<float>(h, 108, swap));
+	header.dataOffset = 0;
+
+	float slope = field<float>(h, 112, swap);
+	if (slope != 0.0f && std::isfinite(slope)) {
+		header.slope = slope;
+		header.intercept = field<float>(h, 116, swap);
+	}
+
+	// sform (an affine) is preferred to qform (a quaternion); both map voxels to RAS millimeters
+	short qformCode = field<short>(h, 252, swap);
+	short sformCode = field<short>(h, 254, swap);
+	if (sformCode > 0) {
+		Vec3 rows[3];
+		for (int r = 0; r < 3; r++) {
+			size_t row = 280 + 16 * r;
+			rows[r] = Vec3(field<float>(h, row, swap), field<float>(h, row + 4, swap), field<float>(h, row + 8, swap));
+		}
+		Vec3 x = rasToLps(Vec3(rows[0].x, rows[1].x, rows[2].x)).normal();
+		Vec3 y = rasToLps(Vec3(rows[0].y, rows[1].y, rows[2].y)).normal();
+		Vec3 z = rasToLps(Vec3(rows[0].z, rows[1].z, rows[2].z)).normal();
+		header.orientation = Mat3(x, y, z);
+	} else if (qformCode > 0) {
+		float b = field<float>(h, 256, swap);
+		float c = field<float>(h, 260, swap);
+		float d = field<float>(h, 264, swap);
+		float a = sqrt(max(0.0f, 1.0f - (b * b + c * c + d * d)));
+		Vec3 x(a * a + b * b - c * c - d * d, 2 * (b * c + a * d), 2 * (b * d - a * c));
+		Vec3 y(2 * (b * c - a * d), a * a + c * c - b * b - d * d, 2 * (c * d + a * b));
+		Vec3 z(2 * (b * d + a * c), 2 * (c * d - a * b), a * a + d * d - b * b - c * c);
+		header.orientation = Mat3(rasToLps(x), rasToLps(y), rasToLps(z) * qfac);
+	}
+
+	return true;
+}
+
+bool VolumeFile::readNrrd(const string& fileName, Header& header, string& error)
+{
+	ifstream in(fileName.c_str(), ios::in | ios::binary);
+	string line;
+	if (!getline(in, line) || line.compare(0, 4, "NRRD") != 0) {
+		error = "not a NRRD file";
+		return false;
+	}
+
+	map<string, string> fields;
+	while (getline(in, line)) {
+		line = trim(line);
+		if (line.empty()) {
+			break;
+		}
+		if (line[0] == '#' || line.find(":=") != string::npos) {
+			continue;
+		}
+		size_t colon = line.find(':');
+		if (colon != string::npos) {
+			fields[lower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+		}
+	}
+
+	// attached data starts right after the blank line that ends the header
+	header.dataOffset = static_cast<size_t>(in.tellg());
+	string dataFile = fields.count("data file") ? fields["data file"] : fields["datafile"];
+	if (!dataFile.empty()) {
+		if (dataFile.find(' ') != string::npos || lower(dataFile).compare(0, 4, "list") == 0) {
+			error = "NRRD data split over several files is not supported";
+			return false;
+		}
+		header.dataFile = resolve(fileName, dataFile);
+		header.dataOffset = 0;
+	}
+
+	if (atoi(fields["dimension"].c_str()) != 3) {
+		error = "not a 3D volume";
+		return false;
+	}
+	vector<unsigned> sizes = values<unsigned>(fields["sizes"]);
+	if (sizes.size() != 3) {
+		error = "invalid sizes";
+		return false;
+	}
+	header.width = sizes[0];
+	header.height = sizes[1];
+	header.depth = sizes[2];
+	header.type = typeFromName(fields["type"]);
+	header.bigEndian = lower(fields["endian"]) == "big";
+
+	string encoding = lower(fields["encoding"]);
+	if (encoding == "gzip" || encoding == "gz") {
+		header.compressed = true;
+	} else if (encoding != "raw") {
+		error = "unsupported encoding " + encoding;
+		return false;
+	}
+	if (fields.count("byte skip")) {
+		int skip = atoi(fields["byte skip"].c_str());
+		if (skip < 0) {
+			error = "byte skip -1 is not supported";
+			return false;
+		}
+		header.skip = skip;
+	}
+
+	// space directions hold both the axes and the spacing; "spacings" only the latter
+	vector<Vec3> directions = vectors(fields["space directions"]);
+	if (directions.size() == 3) {
+		string space = lower(fields["space"]);
+		bool ras = space == "right-anterior-superior" || space == "ras";
+		Vec3 axes[3];
+		for (int i = 0; i < 3; i++) {
+			float length = directions[i].length();
+			axes[i] = (length > 0.0f) ? directions[i] / length : Vec3(0.0f);
+			if (ras) {
+				axes[i] = rasToLps(axes[i]);
+			}
+		}
+		header.spacing = Vec3(directions[0].length(), directions[1].length(), directions[2].length());
+		header.orientation = Mat3(axes[0], axes[1], axes[2]);
+	} else {
+		vector<float> spacings = values<float>(fields["spacings"]);
+		if (spacings.size() == 3) {
+			header.spacing = Vec3(spacings[0], spacings[1], spacings[2]);
+		}
+	}
+
+	return true;
+}
+
+bool VolumeFile::readMetaImage(const string& fileName, Header& header, string& error)
+{
+	ifstream in(fileName.c_str(), ios::in | ios::binary);
+	map<string, string> fields;
+	string line;
+	while (getline(in, line)) {
+		size_t equals = line.find('=');
+		if (equals == string::npos) {
+			continue;
+		}
+		string key = lower(trim(line.substr(0, equals)));
+		fields[key] = trim(line.substr(equals + 1));
+
+		// ElementDataFile is always the last field; LOCAL data follows it
+		if (key == "elementdatafile") {
+			break;
+		}
+	}
+	header.dataOffset = static_cast<size_t>(in.tellg());
+
+	if (!fields.count("elementdatafile")) {
+		error = "not a MetaImage file";
+		return false;
+	}
+	if (atoi(fields["ndims"].c_str()) != 3) {
+		error = "not a 3D volume";
+		return false;
+	}
+
+	string dataFile = fields["elementdatafile"];
+	if (lower(dataFile) != "local") {
+		if (dataFile.find(' ') != string::npos || lower(dataFile).compare(0, 4, "list") == 0) {
+			error = "MetaImage data split over several files is not supported";
+			return false;
+		}
+		header.dataFile = resolve(fileName, dataFile);
+		header.dataOffset = 0;
+	}
+
+	vector<unsigned> sizes = values<unsigned>(fields["dimsize"]);
+	if (sizes.size() != 3) {
+		error = "invalid DimSize";
+		return false;
+	}
+	header.width = sizes[0];
+	header.height = sizes[1];
+	header.depth = sizes[2];
+	header.type = typeFromName(fields["elementtype"]);
+
+	if (fields.count("elementnumberofchannels") && atoi(fields["elementnumberofchannels"].c_str()) != 1) {
+		error = "only single channel images are supported";
+		return false;
+	}
+
+	string msb = lower(fields.count("binarydatabyteordermsb") ? fields["binarydatabyteordermsb"] : fields["elementbyteordermsb"]);
+	header.bigEndian = msb == "true";
+	header.compressed = lower(fields["compresseddata"]) == "true";
+
+	if (fields.count("headersize")) {
+		int skip = atoi(fields["headersize"].c_str());
+		if (skip < 0) {
+			// -1: the voxels are at the end of the data file
+			ifstream data(header.dataFile.c_str(), ios::in | ios::binary | ios::ate);
+			size_t bytes = static_cast<size_t>(header.width) * header.height * header.depth * (header.type == GL_SHORT || header.type == GL_UNSIGNED_SHORT ? 2 : 1);
+			size_t size = static_cast<size_t>(data.tellg());
+			if (header.compressed || size < bytes) {
+				error = "invalid HeaderSize";
+				return false;
+			}
+			header.skip = size - bytes - header.dataOffset;
+		} else {
+			header.skip = skip;
+		}
+	}
+
+	vector<float> spacing = values<float>(fields.count("elementspacing") ? fields["elementspacing"] : fields["elementsize"]);
+	if (spacing.size() == 3) {
+		header.spacing = Vec3(spacing[0], spacing[1], spacing[2]);
+	}
+
+	// the direction cosines of the axes, in LPS like DICOM
+	string matrix = fields.count("transformmatrix") ? fields["transformmatrix"] : fields.count("orientation") ? fields["orientation"] : fields["rotation"];
+	vector<float> m = values<float>(matrix);
+	if (m.size() == 9) {
+		header.orientation = Mat3(Vec3(m[0], m[1], m[2]), Vec3(m[3], m[4], m[5]), Vec3(m[6], m[7], m[8]));
+	}
+
+	return true;
+}
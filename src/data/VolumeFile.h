@@ -0,0 +1,74 @@
+#ifndef __MEDLEAP_VOLUME_FILE__
+#define __MEDLEAP_VOLUME_FILE__
+
+#include "gl/glew.h"
+#include "gl/math/Math.h"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Headers of single-file volume formats: NIfTI-1 (.nii, .nii.gz), NRRD (.nrrd, .nhdr) and
+ * MetaImage (.mha, .mhd). The header describes where the voxels are and how they are stored;
+ * a Stream then reads them in chunks, inflating gzip or zlib data on the fly when MedLeap is
+ * built with zlib (MEDLEAP_HAVE_ZLIB).
+ */
+class VolumeFile
+{
+public:
+	enum class Format { unknown, nifti, nrrd, metaimage };
+
+	struct Header
+	{
+		std::string dataFile;    // file with the voxels; may be the header file itself
+		size_t dataOffset;       // where the voxels start in dataFile, before decompression
+		size_t skip;             // bytes to skip after decompression (ex. the header of a .nii.gz)
+		bool compressed;         // gzip or zlib
+		bool bigEndian;
+		unsigned width;
+		unsigned height;
+		unsigned depth;
+		GLenum type;             // GL_BYTE, GL_UNSIGNED_BYTE, GL_SHORT or GL_UNSIGNED_SHORT
+		double slope;            // real value = stored value * slope + intercept
+		double intercept;
+		gl::Vec3 spacing;        // millimeters
+		gl::Mat3 orientation;    // patient space (LPS) directions of the x, y and z axes
+	};
+
+	/** Reads voxel data sequentially from a (possibly compressed) file */
+	class Stream
+	{
+	public:
+		Stream();
+		~Stream();
+
+		/** Starts reading at offset; compressed data may be gzip or zlib */
+		bool open(const std::string& fileName, size_t offset, bool compressed);
+
+		/** Reads exactly size bytes. Returns false if the data ends first or can't be decoded. */
+		bool read(char* data, size_t size);
+
+		bool skip(size_t size);
+
+	private:
+		struct Inflater;
+
+		std::ifstream file_;
+		std::unique_ptr<Inflater> inflater_;
+		std::vector<char> input_;
+	};
+
+	/** Format from the file name extension */
+	static Format format(const std::string& fileName);
+
+	/** Reads the header of a file. Returns false, with the reason in error, if it can't be loaded. */
+	static bool readHeader(const std::string& fileName, Header& header, std::string& error);
+
+private:
+	static bool readNifti(const std::string& fileName, Header& header, std::string& error);
+	static bool readNrrd(const std::string& fileName, Header& header, std::string& error);
+	static bool readMetaImage(const std::string& fileName, Header& header, std::string& error);
+};
+
+#endif // __MEDLEAP_VOLUME_FILE__
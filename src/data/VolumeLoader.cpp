@@ -1,10 +1,23 @@
 #include "VolumeLoader.h"
+#include "VolumePrefetcher.h"
+#include "VolumeFile.h"
 #include "gdcmImageReader.h"
 #include "gdcmAttribute.h"
 #include "gdcmTag.h"
 #include "gdcmScanner.h"
 #include "gdcmIPPSorter.h"
+#include "gdcmConfigure.h"
+#if GDCM_MAJOR_VERSION > 2 || (GDCM_MAJOR_VERSION == 2 && GDCM_MINOR_VERSION >= 4)
+#include "gdcmImageRegionReader.h"
+#include "gdcmBoxRegion.h"
+#endif
 #include "util/Util.h"
+#include "util/Profiler.h"
+#include "util/Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <new>
 #include <thread>
 #include <regex>
 
@@ -12,11 +25,8 @@ using namespace std;
 using namespace gdcm;
 using namespace gl;
 
-VolumeLoader::VolumeLoader()
+VolumeLoader::VolumeLoader() : prefetcher_(NULL)
 {
-    volume = NULL;
-    state = READY;
-    stateMessage = "Idle";
 }
 
 vector<VolumeLoader::ID> VolumeLoader::search(const std::string& directoryPath)
@@ -26,11 +36,19 @@ vector<VolumeLoader::ID> VolumeLoader::search(const std::string& directoryPath)
     // find all DICOM files in the directory that have a series UID
     Tag uid(0x0020,0x000e);
     Tag modality(0x0008,0x0060);
+    Tag numberOfFrames(0x0028,0x0008);
+    Tag rows(0x0028,0x0010);
+    Tag columns(0x0028,0x0011);
+    Tag bitsAllocated(0x0028,0x0100);
     Directory directory;
     directory.Load(directoryPath);
     Scanner scanner;
     scanner.AddTag(uid);
     scanner.AddTag(modality);
+    scanner.AddTag(numberOfFrames);
+    scanner.AddTag(rows);
+    scanner.AddTag(columns);
+    scanner.AddTag(bitsAllocated);
     scanner.Scan(directory.GetFilenames());
     vector<string> seriesIDs = scanner.GetOrderedValues(uid);
     
@@ -38,17 +56,26 @@ vector<VolumeLoader::ID> VolumeLoader::search(const std::string& directoryPath)
     for (string seriesID : seriesIDs) {
         vector<string> files = scanner.GetAllFilenamesFromTagToValue(uid, seriesID.c_str());
         
-        // a volume must have more than 1 image, so I'm ignoring other series
-        if (files.size() > 1) {
+        // a volume must have more than 1 image (or frame), so I'm ignoring other series
+        const char* frames = scanner.GetValue(files[0].c_str(), numberOfFrames);
+        if (files.size() > 1 || (frames && atoi(frames) > 1)) {
+            // memory of the loaded volume: voxels and a gradient per voxel
+            const char* r = scanner.GetValue(files[0].c_str(), rows);
+            const char* c = scanner.GetValue(files[0].c_str(), columns);
+            const char* b = scanner.GetValue(files[0].c_str(), bitsAllocated);
+            size_t depth = (files.size() > 1) ? files.size() : atoi(frames);
+            size_t voxelBytes = ((b && atoi(b) > 8) ? 2 : 1) + sizeof(Vec3);
+            size_t bytes = (r && c) ? static_cast<size_t>(atoi(r)) * atoi(c) * depth * voxelBytes : 0;
+
             string strModality = scanner.GetValue(files[0].c_str(), modality);
             if (strModality == "CT") {
-                ID id = { seriesID, directoryPath, VolumeData::CT, (unsigned)files.size() };
+                ID id = { seriesID, directoryPath, VolumeData::CT, (unsigned)files.size(), bytes };
                 ids.push_back(id);
             } else if (strModality == "MR") {
-                ID id = { seriesID, directoryPath, VolumeData::MR, (unsigned)files.size() };
+                ID id = { seriesID, directoryPath, VolumeData::MR, (unsigned)files.size(), bytes };
                 ids.push_back(id);
             } else {
-                ID id = { seriesID, directoryPath, VolumeData::UNKNOWN, (unsigned)files.size() };
+                ID id = { seriesID, directoryPath, VolumeData::UNKNOWN, (unsigned)files.size(), bytes };
                 ids.push_back(id);
             }
         }
@@ -58,6 +85,14 @@ vector<VolumeLoader::ID> VolumeLoader::search(const std::string& directoryPath)
 }
 
 void VolumeLoader::sortFiles(VolumeLoader::ID id, vector<string>& fileNames, double* zSpacing)
+{
+    // a time-resolved series is read as its first phase
+    vector<vector<string>> phases;
+    sortPhases(id, phases, zSpacing);
+    fileNames = phases.empty() ? vector<string>() : phases[0];
+}
+
+void VolumeLoader::sortPhases(VolumeLoader::ID id, vector<vector<string>>& phases, double* zSpacing)
 {
     // use directory from the series
     Directory directory;
@@ -65,37 +100,90 @@ void VolumeLoader::sortFiles(VolumeLoader::ID id, vector<string>& fileNames, dou
     
     // scan directory by series UID
     Tag uid(0x0020,0x000e);
+    Tag temporalPosition(0x0020,0x0100);
+    Tag triggerTime(0x0018,0x1060);
     Scanner scanner;
     scanner.AddTag(uid);
+    scanner.AddTag(temporalPosition);
+    scanner.AddTag(triggerTime);
     scanner.Scan(directory.GetFilenames());
+    Directory::FilenamesType files = scanner.GetAllFilenamesFromTagToValue(uid, id.uid.c_str());
+
+    // phases are told apart by their temporal position, or by the trigger time of gated scans
+    map<double, Directory::FilenamesType> groups;
+    for (const string& file : files) {
+        const char* time = scanner.GetValue(file.c_str(), temporalPosition);
+        if (!time)
+            time = scanner.GetValue(file.c_str(), triggerTime);
+        groups[time ? atof(time) : 0.0].push_back(file);
+    }
+
+    // only equal stacks of several images are phases; otherwise the tags vary per image (ex. the
+    // trigger time of each slice of a static MR series) and the series is a single volume
+    bool timeResolved = groups.size() > 1;
+    for (auto& group : groups) {
+        if (group.second.size() < 2 || group.second.size() != groups.begin()->second.size())
+            timeResolved = false;
+    }
+    if (!timeResolved) {
+        groups.clear();
+        groups[0.0] = files;
+    }
+
+    phases.clear();
+    *zSpacing = 1;
+
+    // a multi-frame object: the frames are already in order
+    if (files.size() == 1) {
+        phases.push_back(files);
+        return;
+    }
     
-    // sort files by (tolerance is default from GDCM sample code)
-    Directory::FilenamesType unsorted = scanner.GetAllFilenamesFromTagToValue(uid, id.uid.c_str());
-    
-    IPPSorter sorter;
-    sorter.SetComputeZSpacing(true);
-    sorter.SetZSpacingTolerance(0.001);
-    
-    // weak error checking
-    if (!sorter.Sort(unsorted)) {
-        cerr << "Warning: could not sort using IPP/IOP." << endl;
-		// use slicethickness or 1 and default order of files
-		fileNames = directory.GetFilenames();
-		*zSpacing = 1;
-	} else {
-		fileNames = sorter.GetFilenames();
-		*zSpacing = sorter.GetZSpacing();
-	}
+    for (auto& group : groups) {
+        Directory::FilenamesType& unsorted = group.second;
+
+        // sort files by (tolerance is default from GDCM sample code)
+        IPPSorter sorter;
+        sorter.SetComputeZSpacing(true);
+        sorter.SetZSpacingTolerance(0.001);
+        
+        // weak error checking
+        if (!sorter.Sort(unsorted)) {
+            cerr << "Warning: could not sort using IPP/IOP." << endl;
+            // use slicethickness or 1 and default order of files
+            phases.push_back(groups.size() == 1 ? directory.GetFilenames() : unsorted);
+        } else {
+            if (phases.empty())
+                *zSpacing = sorter.GetZSpacing();
+            phases.push_back(sorter.GetFilenames());
+        }
+    }
 }
 
 void VolumeLoader::setSource(const Source& source)
 {
+	// a series warmed by the prefetcher is ready without touching the disk
+	VolumeData* prefetched = (prefetcher_ && source.type == Source::DICOM_DIR) ? prefetcher_->take(source.name) : NULL;
+	if (prefetched) {
+		cancel();
+		job_ = make_shared<LoadJob>();
+		job_->finish(prefetched);
+		return;
+	}
+
 	if (source.type == Source::DICOM_DIR) {
-		std::vector<ID> ids = search(source.name);
-		if (!ids.empty())
-			setSource(ids[0]);
-		else
-			std::cout << "WARNING: directory does not seem to contain DICOM images" << std::endl;
+		string directory = source.name;
+		start([this, directory](LoadJob& job) -> VolumeData* {
+			std::vector<ID> ids = search(directory);
+			if (ids.empty()) {
+				std::cout << "WARNING: directory does not seem to contain DICOM images" << std::endl;
+				return NULL;
+			}
+			return read(ids[0], job);
+		});
+	}
+	else if (source.type == Source::VOLUME_FILE) {
+		loadVolumeFile(source.name);
 	}
 	else {
 		loadRAW(source.name);
@@ -104,97 +192,296 @@ void VolumeLoader::setSource(const Source& source)
 
 void VolumeLoader::setSource(VolumeLoader::ID id)
 {
-    if (state == READY) {
-        this->id = id;
-        
-        thread t(&VolumeLoader::load, this);
-        t.detach();
-    }
+	start([this, id](LoadJob& job) { return read(id, job); });
 }
 
-VolumeLoader::State VolumeLoader::getState()
+void VolumeLoader::start(function<VolumeData*(LoadJob&)> work)
 {
-    return state;
+	cancel();
+
+	// the thread keeps its own reference, so a job that is replaced or cancelled can still finish
+	shared_ptr<LoadJob> job = make_shared<LoadJob>();
+	job_ = job;
+	thread t([job, work] { job->finish(work(*job)); });
+	t.detach();
+}
+
+void VolumeLoader::cancel()
+{
+	if (job_) {
+		job_->cancel();
+		job_ = nullptr;
+	}
+}
+
+VolumeLoader::State VolumeLoader::getState() const
+{
+	if (!job_) {
+		return READY;
+	}
+
+	switch (job_->phase()) {
+	case LoadJob::Phase::finished:
+		return FINISHED;
+	case LoadJob::Phase::failed:
+	case LoadJob::Phase::cancelled:
+		return READY;
+	default:
+		return LOADING;
+	}
 }
 
 std::string VolumeLoader::getStateMessage() const
 {
-    return stateMessage;
+	return job_ ? job_->message() : "Idle";
 }
 
 void VolumeLoader::loadRAW(const std::string& fileName)
 {
-	auto work = [=] {
-		string datName = fileName.substr(0, fileName.size() - 4) + ".txt";
-		ifstream f(datName);
-		string line;
-
-		if (f.is_open()) {
-			this->state = LOADING;
-			stateMessage = "Reading RAW";
-
-			this->volume = new VolumeData;
-
-			getline(f, line);
-
-			smatch matches;
-			regex_match(line, matches, regex{"\\D*(\\d+)x(\\d+)x(\\d+)"});
-			volume->width = std::stoi(matches[1]);
-			volume->height = std::stoi(matches[2]);
-			volume->depth = std::stoi(matches[3]);
-
-			getline(f, line);
-			regex_match(line, matches, regex{ ("\\D*(\\d+)") });
-			unsigned pixelBytes = std::stoi(matches[1]);
-
-			getline(f, line);
-			regex_match(line, matches, regex{ ("scale: (.*):(.*):(.*)") });
-			float x, y, z;
-			x = stof(matches[1]);
-			y = stof(matches[2]);
-			z = stof(matches[3]);
-
-			ifstream binary(fileName, ios::in | ios::binary);
-			volume->data = new char[volume->getNumVoxels()*pixelBytes];
-			binary.read(volume->data, volume->getNumVoxels()*pixelBytes);
-			binary.close();
-
-			volume->setVoxelSize(x, y, z);
-
-			if (pixelBytes == 1) {
-				volume->type = GL_UNSIGNED_BYTE;
-				calculateMinMax<GLubyte>();
-				volume->computeGradients<GLubyte>();
+	start([this, fileName](LoadJob& job) { return readRAW(fileName, job); });
+}
+
+VolumeData* VolumeLoader::readRAW(const std::string& fileName, LoadJob& job)
+{
+	string datName = fileName.substr(0, fileName.size() - 4) + ".txt";
+	ifstream f(datName);
+	string line;
+
+	if (f.is_open()) {
+		VolumeData* volume = new VolumeData;
+
+		getline(f, line);
+
+		smatch matches;
+		regex_match(line, matches, regex{"\\D*(\\d+)x(\\d+)x(\\d+)"});
+		volume->width = std::stoi(matches[1]);
+		volume->height = std::stoi(matches[2]);
+		volume->depth = std::stoi(matches[3]);
+
+		getline(f, line);
+		regex_match(line, matches, regex{ ("\\D*(\\d+)") });
+		unsigned pixelBytes = std::stoi(matches[1]);
+
+		getline(f, line);
+		regex_match(line, matches, regex{ ("scale: (.*):(.*):(.*)") });
+		float x, y, z;
+		x = stof(matches[1]);
+		y = stof(matches[2]);
+		z = stof(matches[3]);
+
+		ifstream binary(fileName, ios::in | ios::binary);
+		volume->data = new char[volume->getNumVoxels()*pixelBytes];
+		size_t sliceBytes = volume->width * volume->height * pixelBytes;
+		job.begin(LoadJob::Phase::reading, volume->depth);
+		for (unsigned i = 0; i < volume->depth && !job.cancelled(); i++) {
+			binary.read(volume->data + i * sliceBytes, sliceBytes);
+			job.advance(sliceBytes);
+		}
+		binary.close();
+
+		volume->setVoxelSize(x, y, z);
+		volume->format = GL_RED;
+		volume->name = fileName;
+
+		bool complete;
+		if (pixelBytes == 1) {
+			volume->type = GL_UNSIGNED_BYTE;
+			complete = transform<GLubyte>(volume, job, false, true, 1.0, 0.0);
+		}
+		else {
+			volume->type = GL_UNSIGNED_SHORT;
+			complete = transform<GLushort>(volume, job, false, true, 1.0, 0.0);
+		}
+
+		if (!complete) {
+			delete volume;
+			return NULL;
+		}
+		return volume;
+	}
+	return NULL;
+}
+
+void VolumeLoader::loadVolumeFile(const std::string& fileName)
+{
+	start([this, fileName](LoadJob& job) { return readVolumeFile(fileName, job); });
+}
+
+VolumeData* VolumeLoader::readVolumeFile(const std::string& fileName, LoadJob& job)
+{
+	job.begin(LoadJob::Phase::scanning);
+
+	VolumeFile::Header header;
+	string error;
+	if (!VolumeFile::readHeader(fileName, header, error)) {
+		cerr << "ERROR reading " << fileName << ": " << error << endl;
+		return NULL;
+	}
+
+	VolumeFile::Stream stream;
+	if (!stream.open(header.dataFile, header.dataOffset, header.compressed) || !stream.skip(header.skip)) {
+		cerr << "ERROR reading " << header.dataFile << endl;
+		return NULL;
+	}
+
+	VolumeData* volume = new VolumeData;
+	volume->modality = VolumeData::UNKNOWN;
+	volume->width = header.width;
+	volume->height = header.height;
+	volume->depth = header.depth;
+	volume->type = header.type;
+	volume->format = GL_RED;
+	volume->name = fileName;
+	volume->orientation = header.orientation;
+	volume->setVoxelSize(header.spacing.x, header.spacing.y, header.spacing.z);
+	volume->data = new (nothrow) char[volume->getNumVoxels() * gl::sizeOf(volume->type)];
+	if (!volume->data) {
+		cerr << "ERROR reading " << fileName << ": not enough memory" << endl;
+		delete volume;
+		return NULL;
+	}
+
+	// slices are decompressed straight into the volume, so only the stream's input buffer is extra;
+	// they are stored flipped and in reverse order like DICOM slices, which the orientation assumes
+	{
+		Profiler::Scope scope("VolumeLoader::readVolumeFile");
+		unsigned short one = 1;
+		bool littleEndian = *reinterpret_cast<unsigned char*>(&one) == 1;
+		bool swap = gl::sizeOf(volume->type) == 2 && header.bigEndian == littleEndian;
+		size_t sliceBytes = volume->getSliceSizeBytes();
+
+		job.begin(LoadJob::Phase::reading, volume->depth);
+		for (unsigned z = 0; z < volume->depth; z++) {
+			char* slice = volume->data + (volume->depth - z - 1) * sliceBytes;
+			if (job.cancelled() || !stream.read(slice, sliceBytes)) {
+				if (!job.cancelled())
+					cerr << "ERROR reading " << header.dataFile << ": data ends early or is corrupt" << endl;
+				delete volume;
+				return NULL;
 			}
-			else {
-				volume->type = GL_UNSIGNED_SHORT;
-				calculateMinMax<GLushort>();
-				volume->computeGradients<GLushort>();
+			if (swap) {
+				for (size_t i = 0; i < sliceBytes; i += 2)
+					std::swap(slice[i], slice[i + 1]);
+			}
+			gl::flipImage(slice, volume->width, volume->height, volume->getPixelSizeBytes());
+			job.advance(sliceBytes);
+		}
+	}
+
+	// the same min/max (or modality LUT) and gradient passes as DICOM and RAW data
+	bool lut = header.slope != 1.0 || header.intercept != 0.0;
+	bool complete = false;
+	switch (volume->type) {
+	case GL_BYTE: complete = transform<GLbyte>(volume, job, lut, true, header.slope, header.intercept); break;
+	case GL_UNSIGNED_BYTE: complete = transform<GLubyte>(volume, job, lut, true, header.slope, header.intercept); break;
+	case GL_SHORT: complete = transform<GLshort>(volume, job, lut, true, header.slope, header.intercept); break;
+	case GL_UNSIGNED_SHORT: complete = transform<GLushort>(volume, job, lut, true, header.slope, header.intercept); break;
+	}
+	if (!complete) {
+		delete volume;
+		return NULL;
+	}
+	return volume;
+}
+
+bool VolumeLoader::readSlices(const vector<string>& files, VolumeData* volume, LoadJob& job)
+{
+	// every file has its own reader, so compressed transfer syntaxes (JPEG 2000, JPEG-LS...) are
+	// decoded on all cores; slices are stored bottom-up, in reverse file order
+	size_t sliceBytes = volume->getSliceSizeBytes();
+	atomic<bool> failed(false);
+	parallelFor(0, files.size(), [&](unsigned, size_t begin, size_t end) {
+		for (size_t i = begin; i < end && !failed && !job.cancelled(); i++) {
+			ImageReader reader;
+			reader.SetFileName(files[i].c_str());
+			if (!reader.Read() || reader.GetImage().GetBufferLength() != sliceBytes) {
+				cerr << "ERROR reading " << files[i] << endl;
+				failed = true;
+				return;
 			}
-			volume->format = GL_RED;
-			volume->name = fileName;
 
-			this->state = FINISHED;
-			stateMessage = "Finished";
+			char* slice = volume->data + (volume->depth - i - 1) * sliceBytes;
+			reader.GetImage().GetBuffer(slice);
+			gl::flipImage(slice, volume->width, volume->height, volume->getPixelSizeBytes());
+			job.advance(sliceBytes);
 		}
-	};
+	});
+	return !failed && !job.cancelled();
+}
 
-	thread t(work);
-	t.detach();
+bool VolumeLoader::readFrames(const string& file, VolumeData* volume, LoadJob& job)
+{
+	size_t sliceBytes = volume->getSliceSizeBytes();
+
+#if GDCM_MAJOR_VERSION > 2 || (GDCM_MAJOR_VERSION == 2 && GDCM_MINOR_VERSION >= 4)
+	// each thread decodes its own frames, one region (frame) at a time
+	atomic<bool> failed(false);
+	parallelFor(0, volume->depth, [&](unsigned, size_t begin, size_t end) {
+		ImageRegionReader reader;
+		reader.SetFileName(file.c_str());
+		if (!reader.ReadInformation()) {
+			failed = true;
+			return;
+		}
+
+		for (size_t f = begin; f < end && !failed && !job.cancelled(); f++) {
+			BoxRegion frame;
+			unsigned z = static_cast<unsigned>(f);
+			frame.SetDomain(0, volume->width - 1, 0, volume->height - 1, z, z);
+			reader.SetRegion(frame);
+
+			char* slice = volume->data + (volume->depth - f - 1) * sliceBytes;
+			if (reader.ComputeBufferLength() != sliceBytes || !reader.ReadIntoBuffer(slice, sliceBytes)) {
+				failed = true;
+				return;
+			}
+			gl::flipImage(slice, volume->width, volume->height, volume->getPixelSizeBytes());
+			job.advance(sliceBytes);
+		}
+	});
+	if (failed) {
+		cerr << "ERROR decoding frames of " << file << endl;
+	}
+	return !failed && !job.cancelled();
+#else
+	// older GDCM decodes all frames at once, in file order
+	ImageReader reader;
+	reader.SetFileName(file.c_str());
+	if (!reader.Read() || reader.GetImage().GetBufferLength() != sliceBytes * volume->depth || job.cancelled()) {
+		return false;
+	}
+	reader.GetImage().GetBuffer(volume->data);
+
+	for (unsigned f = 0; f < volume->depth / 2; f++) {
+		char* a = volume->data + f * sliceBytes;
+		char* b = volume->data + (volume->depth - f - 1) * sliceBytes;
+		swap_ranges(a, a + sliceBytes, b);
+	}
+	for (unsigned f = 0; f < volume->depth; f++) {
+		gl::flipImage(volume->data + f * sliceBytes, volume->width, volume->height, volume->getPixelSizeBytes());
+		job.advance(sliceBytes);
+	}
+	return !job.cancelled();
+#endif
 }
 
-void VolumeLoader::load()
+VolumeData* VolumeLoader::read(const ID& id, LoadJob& job)
 {
-    this->state = LOADING;
-    
     // sort DCM files so they are ordered correctly along Z
-    stateMessage = "Scanning DICOM files";
+    job.begin(LoadJob::Phase::scanning);
     vector<string> files;
     double zSpacing;
-    sortFiles(id, files, &zSpacing);
-    if (files.size() < 2) {
-        this->volume = NULL;
-        return;
+    {
+        Profiler::Scope scope("VolumeLoader::sortFiles");
+        sortFiles(id, files, &zSpacing);
+    }
+    return read(id, files, zSpacing, job, true);
+}
+
+VolumeData* VolumeLoader::read(const ID& id, vector<string> files, double zSpacing, LoadJob& job, bool gradients)
+{
+    if (files.empty() || job.cancelled()) {
+        return NULL;
     }
     
     
@@ -205,11 +492,24 @@ void VolumeLoader::load()
     Image& img = reader.GetImage();
     DataSet& dataSet = reader.GetFile().GetDataSet();
     
-    volume = new VolumeData;
+    VolumeData* volume = new VolumeData;
     volume->modality = id.modality;
     volume->width = img.GetColumns();
     volume->height = img.GetRows();
     volume->depth = static_cast<unsigned int>(files.size());
+
+    // enhanced (multi-frame) CT and MR objects hold the whole series in one file
+    unsigned frames = (img.GetNumberOfDimensions() > 2) ? img.GetDimension(2) : 1;
+    if (frames > 1) {
+        if (files.size() > 1)
+            cerr << "Warning: series has several multi-frame objects; only the first is loaded." << endl;
+        files.resize(1);
+        volume->depth = frames;
+        zSpacing = (img.GetSpacing()[2] > 0) ? img.GetSpacing()[2] : 1;
+    } else if (files.size() < 2) {
+        delete volume;
+        return NULL;
+    }
     
     
     // only supporting 8/16-bit monochrome images (CT and MR)
@@ -225,20 +525,20 @@ void VolumeLoader::load()
         case PixelFormat::UINT8:
             volume->type = (id.modality == VolumeData::CT) ? GL_BYTE : GL_UNSIGNED_BYTE;
             break;
+        case PixelFormat::INT12:
         case PixelFormat::INT16:
             volume->type = GL_SHORT;
             break;
+        case PixelFormat::UINT12:
         case PixelFormat::UINT16:
             volume->type = (id.modality == VolumeData::CT) ? GL_SHORT : GL_UNSIGNED_SHORT;
             break;
         default:
             delete volume;
-            volume = NULL;
-            return;
+            return NULL;
     }
     
     // now that the type and dimensions are known, allocate memory for voxels
-    stateMessage = "Reading DICOM Images";
     volume->data = new char[volume->width * volume->height * volume->depth * gl::sizeOf(volume->type)];
     
     // load first image (already in reader memory)
@@ -255,19 +555,24 @@ void VolumeLoader::load()
 		//gl::flipImage(volume->data + offset, volume->width, volume->height, volume->getPixelSizeBytes());
   //  }
 
-	for (int i = 0; i < volume->depth; i++) {
-		size_t offset = (volume->depth - i - 1) * volume->getSliceSizeBytes();
-		ImageReader reader;
-		reader.SetFileName(files[i].c_str());
-		reader.Read();
-		reader.GetImage().GetBuffer(volume->data + offset);
-		gl::flipImage(volume->data + offset, volume->width, volume->height, volume->getPixelSizeBytes());
+	{
+		Profiler::Scope scope("VolumeLoader::readImages");
+		job.begin(LoadJob::Phase::reading, volume->depth);
+		bool complete = (frames > 1) ? readFrames(files[0], volume, job) : readSlices(files, volume, job);
+		if (!complete) {
+			delete volume;
+			return NULL;
+		}
 	}
 
 
 
 	// Z spacing should be regular between images (this is NOT slice thickness attribute)
-	{
+	if (frames > 1) {
+		// pixel spacing is in the functional groups, which GDCM already parsed
+		const double* spacing = img.GetSpacing();
+		volume->setVoxelSize(static_cast<float>(spacing[0]), static_cast<float>(spacing[1]), static_cast<float>(zSpacing));
+	} else {
 		Attribute<0x0028, 0x0030> at;
 		at.SetFromDataSet(dataSet);
 		const double* pixelSpacing = at.GetValues();
@@ -278,46 +583,32 @@ void VolumeLoader::load()
 	}
     
     // Apply modality LUT (if possible) and update min/max values
+    Profiler::Scope lutScope("VolumeLoader::modalityAndGradients");
+    bool lut = volume->modality != VolumeData::UNKNOWN;
+    bool complete = false;
     switch (volume->type)
     {
         case GL_BYTE:
-            if (volume->modality == VolumeData::UNKNOWN)
-                calculateMinMax<GLbyte>();
-            else
-                applyModalityLUT<GLbyte>(img.GetSlope(), img.GetIntercept());
-            stateMessage = "Calculating Gradients";
-            volume->computeGradients<GLbyte>();
+            complete = transform<GLbyte>(volume, job, lut, gradients, img.GetSlope(), img.GetIntercept());
             break;
         case GL_UNSIGNED_BYTE:
-            if (volume->modality == VolumeData::UNKNOWN)
-                calculateMinMax<GLubyte>();
-            else
-                applyModalityLUT<GLubyte>(img.GetSlope(), img.GetIntercept());
-            stateMessage = "Calculating Gradients";
-            volume->computeGradients<GLubyte>();
+            complete = transform<GLubyte>(volume, job, lut, gradients, img.GetSlope(), img.GetIntercept());
             break;
         case GL_SHORT:
-            if (volume->modality == VolumeData::UNKNOWN)
-                calculateMinMax<GLshort>();
-            else
-                applyModalityLUT<GLshort>(img.GetSlope(), img.GetIntercept());
-            stateMessage = "Calculating Gradients";
-            volume->computeGradients<GLshort>();
+            complete = transform<GLshort>(volume, job, lut, gradients, img.GetSlope(), img.GetIntercept());
             break;
         case GL_UNSIGNED_SHORT:
-            if (volume->modality == VolumeData::UNKNOWN)
-                calculateMinMax<GLushort>();
-            else
-                applyModalityLUT<GLushort>(img.GetSlope(), img.GetIntercept());
-            stateMessage = "Calculating Gradients";
-            volume->computeGradients<GLushort>();
+            complete = transform<GLushort>(volume, job, lut, gradients, img.GetSlope(), img.GetIntercept());
             break;
         default:
             break; // should not happen
     }
+    if (!complete) {
+        delete volume;
+        return NULL;
+    }
     
     // store value of interest LUTs as windows
-    stateMessage = "Calculating Gradients";
     if (volume->modality != VolumeData::UNKNOWN) {
         int numWindows;
         double* centers;
@@ -380,16 +671,13 @@ void VolumeLoader::load()
 		replace(name.begin(), name.end(), '^', ' ');
 		volume->name = name;
 	}
-    
-    state = FINISHED;
-    stateMessage = "Finished";
+
+    return volume;
 }
 
 VolumeData* VolumeLoader::getVolume()
 {
-    VolumeData* result = volume;
-    volume = NULL;
-    state = READY;
-    stateMessage = "Idle";
+    VolumeData* result = job_ ? job_->take() : NULL;
+    job_ = nullptr;
     return result;
 }
@@ -2,8 +2,13 @@
 #define __MEDLEAP_VOLUME_LOADER__
 
 #include "VolumeData.h"
+#include "LoadJob.h"
 #include "gdcmReader.h"
 #include "gdcmAttribute.h"
+#include <functional>
+#include <memory>
+
+class VolumePrefetcher;
 
 /** Utility class for constructing a VolumeData from DICOM image series */
 class VolumeLoader
@@ -12,7 +17,7 @@ public:
 
 	struct Source
 	{
-		enum Type { DICOM_DIR, RAW };
+		enum Type { DICOM_DIR, RAW, VOLUME_FILE };
 		std::string name;
 		Type type;
 	};
@@ -24,6 +29,7 @@ public:
         std::string directory;
         VolumeData::Modality modality;
         unsigned int numImages;
+        size_t estimatedBytes;  // memory of the loaded volume (voxels and gradients); 0 if unknown
     };
     
     enum State
@@ -36,74 +42,137 @@ public:
     /** This will search a directory to find all unique CT or MT image series. */
     std::vector<ID> search(const std::string& directoryPath);
     
-    /** Loads the specified image series. */
+    /** Loads the specified image series. A load in progress is cancelled. */
     void setSource(ID seriesID);
     
-    /** This will load the first image series found in a directory */
+    /** This will load the first image series found in a directory. A load in progress is cancelled. A directory warmed by the prefetcher finishes immediately. */
     void setSource(const Source& source);
+
+    /** Loads the specified image series on the calling thread, reporting progress to job. Returns NULL if it fails or the job is cancelled; the caller owns the volume. */
+    VolumeData* read(const ID& seriesID, LoadJob& job);
+
+    /** Loads the given files of a series, already sorted by sortFiles or sortPhases. Gradients are skipped if gradients is false (ex. cine phases, which are only shown through the 3D texture). */
+    VolumeData* read(const ID& seriesID, std::vector<std::string> fileNames, double zSpacing, LoadJob& job, bool gradients);
+
+    /** Volumes prefetched by this object are used by setSource instead of reading the files again */
+    void prefetcher(VolumePrefetcher* prefetcher) { prefetcher_ = prefetcher; }
     
     /** Stores file names sorted by Z into the fileNames parameter. Also stores the computed Z spacing into zSpacing parameter. */
     void sortFiles(ID seriesID, std::vector<std::string>& fileNames, double* zSpacing);
 
+    /** Groups the files of a time-resolved (4D) series into phases by temporal position or trigger time, each sorted by Z. The series has a single phase unless there are several groups with the same number of images (more than one each). */
+    void sortPhases(ID seriesID, std::vector<std::vector<std::string>>& phases, double* zSpacing);
+
 	void loadRAW(const std::string& fileName);
 
+    /** Loads a NIfTI-1, NRRD or MetaImage file (see VolumeFile) */
+    void loadVolumeFile(const std::string& fileName);
+
+    /** Stops the current load, which is checked before each slice. The state returns to READY. */
+    void cancel();
+
+    /** Progress of the current load; NULL if there is none */
+    std::shared_ptr<const LoadJob> job() const { return job_; }
+
     /** Retrieves the previously loaded volume, or NULL if it failed. The caller now owns the volume memory and is responsible for deleting it. After calling once this will return NULL until the next load is called. Resets the state to READY. */
     VolumeData* getVolume();
     
     /** Current state of the loader */
-    State getState();
+    State getState() const;
     
     /** More details about what's going on */
     std::string getStateMessage() const;
     
 private:
-    VolumeData* volume;
-    ID id;
-    State state;
-    std::string stateMessage;
-    
-    /** Actual loading work */
-    void load();
+    std::shared_ptr<LoadJob> job_;
+    VolumePrefetcher* prefetcher_;
     
+    /** Runs work on a new detached thread with a new job; the current job is cancelled */
+    void start(std::function<VolumeData*(LoadJob&)> work);
+
+    VolumeData* readRAW(const std::string& fileName, LoadJob& job);
+
+    VolumeData* readVolumeFile(const std::string& fileName, LoadJob& job);
+
+    /** Decodes single-frame files in parallel into their slices. Returns false on errors or cancellation. */
+    static bool readSlices(const std::vector<std::string>& files, VolumeData* volume, LoadJob& job);
+
+    /** Decodes the frames of a multi-frame file in parallel into the slices */
+    static bool readFrames(const std::string& file, VolumeData* volume, LoadJob& job);
+
+    /** Applies the modality LUT (lut = true) or only finds the min/max values, then computes the gradients if asked. Returns false if the job was cancelled. */
+    template <typename T>
+    static bool transform(VolumeData* volume, LoadJob& job, bool lut, bool gradients, double slope, double intercept)
+    {
+        return (lut ? applyModalityLUT<T>(volume, job, slope, intercept) : calculateMinMax<T>(volume, job)) &&
+            (!gradients || computeGradients<T>(volume, job));
+    }
+
     /** The modality LUT transforms device-dependent values to device-independent modality values. For example, it will transform raw UINT16 CT data values into signed CT Hounsfield units. It uses the slope and intercept stored in the DICOM dataset to transform values. */
     template <typename T>
-    void applyModalityLUT(double slope, double intercept)
+    static bool applyModalityLUT(VolumeData* volume, LoadJob& job, double slope, double intercept)
     {
-        stateMessage = "Applying Modality Transformation";
+        job.begin(LoadJob::Phase::transforming, volume->depth);
 
         T* buffer = (T*)volume->data;
+        size_t sliceVoxels = volume->width * volume->height;
         volume->minVoxelValue = std::numeric_limits<int>::infinity();
         volume->maxVoxelValue = -std::numeric_limits<int>::infinity();
-        for (int i = 0; i < volume->getNumVoxels(); i++) {
-            *buffer = static_cast<T>((*buffer) * slope + intercept);
-            if (*buffer > volume->maxVoxelValue) volume->maxVoxelValue = *buffer;
-            if (*buffer < volume->minVoxelValue) volume->minVoxelValue = *buffer;
-            buffer++;
+        for (unsigned z = 0; z < volume->depth; z++) {
+            if (job.cancelled())
+                return false;
+            for (size_t i = 0; i < sliceVoxels; i++) {
+                *buffer = static_cast<T>((*buffer) * slope + intercept);
+                if (*buffer > volume->maxVoxelValue) volume->maxVoxelValue = *buffer;
+                if (*buffer < volume->minVoxelValue) volume->minVoxelValue = *buffer;
+                buffer++;
+            }
+            job.advance(volume->getSliceSizeBytes());
         }
 
 		float nl = gl::normalize<T>(volume->minVoxelValue);
 		float nr = gl::normalize<T>(volume->maxVoxelValue);
 		volume->visible_.width(nl, nr);
+        return true;
     }
     
     /** This is used instead of modality LUT if the modality is unknown */
     template <typename T>
-    void calculateMinMax()
+    static bool calculateMinMax(VolumeData* volume, LoadJob& job)
     {
-        stateMessage = "Calculating Min/Max Values";
+        job.begin(LoadJob::Phase::transforming, volume->depth);
 
         T* buffer = (T*)volume->data;
+        size_t sliceVoxels = volume->width * volume->height;
         volume->minVoxelValue = std::numeric_limits<int>::infinity();
         volume->maxVoxelValue = -std::numeric_limits<int>::infinity();
-        for (int i = 0; i < volume->getNumVoxels(); i++) {
-            if (*buffer > volume->maxVoxelValue) volume->maxVoxelValue = *buffer;
-            if (*buffer < volume->minVoxelValue) volume->minVoxelValue = *buffer;
-            buffer++;
+        for (unsigned z = 0; z < volume->depth; z++) {
+            if (job.cancelled())
+                return false;
+            for (size_t i = 0; i < sliceVoxels; i++) {
+                if (*buffer > volume->maxVoxelValue) volume->maxVoxelValue = *buffer;
+                if (*buffer < volume->minVoxelValue) volume->minVoxelValue = *buffer;
+                buffer++;
+            }
+            job.advance(volume->getSliceSizeBytes());
         }
 
 		float nl = gl::normalize<T>(volume->minVoxelValue);
 		float nr = gl::normalize<T>(volume->maxVoxelValue);
 		volume->visible_.width(nl, nr);
+        return true;
+    }
+
+    template <typename T>
+    static bool computeGradients(VolumeData* volume, LoadJob& job)
+    {
+        if (job.cancelled())
+            return false;
+
+        job.begin(LoadJob::Phase::gradients, volume->depth);
+        size_t sliceBytes = volume->width * volume->height * sizeof(gl::Vec3);
+        volume->computeGradients<T>([&job, sliceBytes] { job.advance(sliceBytes); });
+        return !job.cancelled();
     }
 };
 
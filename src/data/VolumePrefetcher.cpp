@@ -0,0 +1,162 @@
+#include "VolumePrefetcher.h"
+#include "VolumeLoader.h"
+#include "util/Profiler.h"
+#include <limits>
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+	/** Lets the renderer and the foreground loader win over prefetching */
+	void lowerThreadPriority()
+	{
+#if defined(_WIN32)
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__APPLE__)
+		pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#elif defined(__linux__)
+		setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+	}
+}
+
+VolumePrefetcher::VolumePrefetcher(size_t budget) : budget_(budget), used_(0)
+{
+}
+
+VolumePrefetcher::~VolumePrefetcher()
+{
+	thread_.cancel();
+	lock_guard<mutex> lock(mutex_);
+	for (Cached& c : cache_) {
+		delete c.volume;
+	}
+}
+
+void VolumePrefetcher::prefetch(const vector<string>& directories)
+{
+	thread_.post([this, directories](const TaskThread::Cancelled& cancelled) {
+		lowerThreadPriority();
+		demote();
+
+		for (unsigned i = 0; i < directories.size(); i++) {
+			const string& directory = directories[i];
+			if (cancelled()) {
+				return;
+			}
+			if (cached(directory, i)) {
+				continue;
+			}
+
+			Profiler::Scope scope("VolumePrefetcher::load");
+			VolumeLoader loader;
+			vector<VolumeLoader::ID> ids = loader.search(directory);
+			if (ids.empty() || cancelled()) {
+				continue;
+			}
+
+			// don't decode a series only to drop it; it can't push out the more likely ones
+			if (ids[0].estimatedBytes > room(i)) {
+				continue;
+			}
+
+			LoadJob job(cancelled);
+			VolumeData* volume = loader.read(ids[0], job);
+			if (volume) {
+				store(directory, volume, i);
+			}
+		}
+	});
+}
+
+void VolumePrefetcher::cancel()
+{
+	thread_.cancel();
+}
+
+VolumeData* VolumePrefetcher::take(const string& directory)
+{
+	lock_guard<mutex> lock(mutex_);
+	for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+		if (it->directory == directory) {
+			VolumeData* volume = it->volume;
+			used_ -= it->bytes;
+			cache_.erase(it);
+			return volume;
+		}
+	}
+	return NULL;
+}
+
+void VolumePrefetcher::demote()
+{
+	lock_guard<mutex> lock(mutex_);
+	for (Cached& c : cache_) {
+		c.priority = numeric_limits<unsigned>::max();
+	}
+}
+
+bool VolumePrefetcher::cached(const string& directory, unsigned priority)
+{
+	lock_guard<mutex> lock(mutex_);
+	for (Cached& c : cache_) {
+		if (c.directory == directory) {
+			c.priority = priority;
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t VolumePrefetcher::room(unsigned priority)
+{
+	lock_guard<mutex> lock(mutex_);
+	size_t held = 0;
+	for (Cached& c : cache_) {
+		if (c.priority <= priority) {
+			held += c.bytes;
+		}
+	}
+	return (held < budget_) ? budget_ - held : 0;
+}
+
+void VolumePrefetcher::store(const string& directory, VolumeData* volume, unsigned priority)
+{
+	size_t size = bytes(*volume);
+
+	lock_guard<mutex> lock(mutex_);
+	while (used_ + size > budget_) {
+		// the least likely volume goes first, but never one more likely than the new volume
+		auto last = cache_.end();
+		for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+			if (it->priority > priority && (last == cache_.end() || it->priority > last->priority)) {
+				last = it;
+			}
+		}
+		if (last == cache_.end()) {
+			delete volume;
+			return;
+		}
+		used_ -= last->bytes;
+		delete last->volume;
+		cache_.erase(last);
+	}
+
+	Cached c = { directory, volume, size, priority };
+	cache_.push_back(c);
+	used_ += size;
+}
+
+size_t VolumePrefetcher::bytes(const VolumeData& volume)
+{
+	return static_cast<size_t>(volume.getNumVoxels()) * volume.getPixelSizeBytes() + volume.getGradients().size() * sizeof(gl::Vec3);
+}
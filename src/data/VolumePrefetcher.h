@@ -0,0 +1,69 @@
+#ifndef __MEDLEAP_VOLUME_PREFETCHER__
+#define __MEDLEAP_VOLUME_PREFETCHER__
+
+#include "VolumeData.h"
+#include "util/TaskThread.h"
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Speculatively loads DICOM series that are likely to be opened next (ex. the other series in the
+ * directory of the one just opened) on a low priority thread. Prefetched volumes are complete:
+ * sorted, transformed by the modality LUT and with gradients, so VolumeLoader can hand them out
+ * without reading anything. Volumes are kept under a memory budget; the least likely ones are
+ * dropped first, and a volume is never dropped to make room for a less likely one.
+ */
+class VolumePrefetcher
+{
+public:
+	/** budget is the most memory, in bytes, held by prefetched volumes */
+	explicit VolumePrefetcher(size_t budget);
+
+	~VolumePrefetcher();
+
+	/** Loads the first series in each directory, most likely first; replaces and cancels earlier requests */
+	void prefetch(const std::vector<std::string>& directories);
+
+	/** Stops prefetching as soon as possible; volumes already loaded are kept */
+	void cancel();
+
+	/** Removes and returns the prefetched volume of a directory, or NULL. The caller owns it. */
+	VolumeData* take(const std::string& directory);
+
+	/** True while series are being loaded */
+	bool busy() const { return thread_.busy(); }
+
+private:
+	struct Cached
+	{
+		std::string directory;
+		VolumeData* volume;
+		size_t bytes;
+		unsigned priority;  // index in the latest request; lower is more likely to be opened
+	};
+
+	size_t budget_;
+	size_t used_;
+	std::mutex mutex_;
+	std::list<Cached> cache_;
+
+	// declared last so the thread stops before the cache is destroyed
+	TaskThread thread_;
+
+	/** Marks every volume as left over from an earlier request */
+	void demote();
+
+	/** True if the directory is cached; it takes the given priority */
+	bool cached(const std::string& directory, unsigned priority);
+
+	/** Bytes of the budget not held by volumes more likely than priority */
+	size_t room(unsigned priority);
+
+	/** Drops less likely volumes to make room; deletes volume if it still doesn't fit */
+	void store(const std::string& directory, VolumeData* volume, unsigned priority);
+	static size_t bytes(const VolumeData& volume);
+};
+
+#endif // __MEDLEAP_VOLUME_PREFETCHER__
@@ -1,8 +1,26 @@
 #include "Program.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 using namespace gl;
 
+Program::Counters Program::counters_ = { 0, 0, 0, 0 };
+Program::Counters Program::frameCounters_ = { 0, 0, 0, 0 };
+
+namespace
+{
+	// FNV-1a; computed on the fly from the C string so lookups don't allocate
+	unsigned hashName(const char* name)
+	{
+		unsigned h = 2166136261u;
+		for (const char* c = name; *c; c++) {
+			h = (h ^ static_cast<unsigned char>(*c)) * 16777619u;
+		}
+		return h;
+	}
+}
+
 Program::Program() : handle_(nullptr)
 {
 }
@@ -40,15 +58,105 @@ void Program::release()
 {
 	handle_ = nullptr;
 	attached_.clear();
+	reflection_ = nullptr;
+}
+
+void Program::endFrame()
+{
+	frameCounters_ = counters_;
+	counters_ = Counters{ 0, 0, 0, 0 };
+}
+
+void Program::reflect()
+{
+	reflection_ = std::make_shared<Reflection>();
+
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(id(), GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(id(), GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> buf(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; i++) {
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(id(), i, static_cast<GLsizei>(buf.size()), nullptr, &size, &type, &buf[0]);
+		Variable v = { &buf[0], glGetUniformLocation(id(), &buf[0]), false, std::vector<char>() };
+		reflection_->uniforms.push_back(v);
+	}
+
+	glGetProgramiv(id(), GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(id(), GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+	buf.resize(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; i++) {
+		GLint size;
+		GLenum type;
+		glGetActiveAttrib(id(), i, static_cast<GLsizei>(buf.size()), nullptr, &size, &type, &buf[0]);
+		Variable v = { &buf[0], glGetAttribLocation(id(), &buf[0]), false, std::vector<char>() };
+		reflection_->attributes.push_back(v);
+	}
+
+	// arrays are reported as "name[0]" but are usually set by their plain name
+	auto index = [](std::vector<Variable>& variables, std::unordered_map<unsigned, size_t>& table) {
+		for (size_t i = 0; i < variables.size(); i++) {
+			const std::string& name = variables[i].name;
+			table.insert(std::make_pair(hashName(name.c_str()), i));
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+				table.insert(std::make_pair(hashName(name.substr(0, name.size() - 3).c_str()), i));
+			}
+		}
+	};
+	index(reflection_->uniforms, reflection_->uniformIndex);
+	index(reflection_->attributes, reflection_->attributeIndex);
+}
+
+Program::Variable* Program::lookup(bool uniform, const GLchar* name) const
+{
+	if (!reflection_) {
+		return nullptr;
+	}
+
+	std::vector<Variable>& variables = uniform ? reflection_->uniforms : reflection_->attributes;
+	std::unordered_map<unsigned, size_t>& index = uniform ? reflection_->uniformIndex : reflection_->attributeIndex;
+
+	unsigned hash = hashName(name);
+	auto it = index.find(hash);
+	if (it != index.end()) {
+		Variable& v = variables[it->second];
+		size_t length = std::strlen(name);
+		if (v.name.compare(0, length, name) == 0 && (v.name.size() == length || v.name.compare(length, std::string::npos, "[0]") == 0)) {
+			counters_.cachedLookups++;
+			return &v;
+		}
+		// hash collision: leave it to the driver
+		return nullptr;
+	}
+
+	// inactive names (location -1) and array elements are resolved once and remembered
+	counters_.locationQueries++;
+	GLint location = uniform ? glGetUniformLocation(id(), name) : glGetAttribLocation(id(), name);
+	Variable v = { name, location, std::strchr(name, '[') != nullptr, std::vector<char>() };
+	variables.push_back(v);
+	index.insert(std::make_pair(hash, variables.size() - 1));
+	return &variables.back();
 }
 
 GLint Program::getUniform(const GLchar* name) const
 {
+	Variable* v = lookup(true, name);
+	if (v) {
+		return v->location;
+	}
+	counters_.locationQueries++;
 	return glGetUniformLocation(id(), name);
 }
 
 GLint Program::getAttribute(const GLchar* name) const
 {
+	Variable* v = lookup(false, name);
+	if (v) {
+		return v->location;
+	}
+	counters_.locationQueries++;
 	return glGetAttribLocation(id(), name);
 }
 
@@ -68,9 +176,33 @@ void Program::attach(const Shader& shader)
 	attached_.push_back(shader);
 }
 
+bool Program::unchanged(const GLchar* name, const void* value, size_t size, GLint& location)
+{
+	Variable* v = lookup(true, name);
+	if (!v) {
+		location = getUniform(name);
+		counters_.uniformCalls++;
+		return false;
+	}
+
+	location = v->location;
+	if (!v->element) {
+		const char* bytes = static_cast<const char*>(value);
+		if (v->value.size() == size && std::memcmp(&v->value[0], bytes, size) == 0) {
+			counters_.skippedUniforms++;
+			return true;
+		}
+		v->value.assign(bytes, bytes + size);
+	}
+
+	counters_.uniformCalls++;
+	return false;
+}
+
 bool Program::link()
 {
 	glLinkProgram(id());
+	reflection_ = nullptr;
 
 	GLint status = 0;
 	glGetProgramiv(id(), GL_LINK_STATUS, &status);
@@ -89,6 +221,7 @@ bool Program::link()
 		return false;
 	}
 
+	reflect();
 	return true;
 }
 
@@ -138,71 +271,87 @@ Program Program::create(const Shader& vShader, const Shader& fShader)
 
 void Program::uniform(const GLchar* name, GLint value)
 {
-	glUniform1i(glGetUniformLocation(id(), name), value);
+	GLint loc;
+	if (!unchanged(name, &value, sizeof(value), loc))
+		glUniform1i(loc, value);
 }
 
 void Program::uniform(const GLchar* name, GLboolean value)
 {
-	glUniform1i(glGetUniformLocation(id(), name), value);
+	uniform(name, static_cast<GLint>(value));
 }
 
 void Program::uniform(const GLchar* name, float x)
 {
-	glUniform1f(glGetUniformLocation(id(), name), x);
+	GLint loc;
+	if (!unchanged(name, &x, sizeof(x), loc))
+		glUniform1f(loc, x);
 }
 
 void Program::uniform(const GLchar* name, float x, float y)
 {
-	glUniform2f(glGetUniformLocation(id(), name), x, y);
+	uniform(name, Vec2(x, y));
 }
 
 void Program::uniform(const GLchar* name, float x, float y, float z)
 {
-	glUniform3f(glGetUniformLocation(id(), name), x, y, z);
+	uniform(name, Vec3(x, y, z));
 }
 
 void Program::uniform(const GLchar* name, float x, float y, float z, float w)
 {
-	glUniform4f(glGetUniformLocation(id(), name), x, y, z, w);
+	uniform(name, Vec4(x, y, z, w));
 }
 
 void Program::uniform(const GLchar* name, const Vec2& v)
 {
-	glUniform2f(glGetUniformLocation(id(), name), v.x, v.y);
+	GLfloat values[] = { v.x, v.y };
+	GLint loc;
+	if (!unchanged(name, values, sizeof(values), loc))
+		glUniform2f(loc, v.x, v.y);
 }
 
 void Program::uniform(const GLchar* name, const Vec3& v)
 {
-	glUniform3f(glGetUniformLocation(id(), name), v.x, v.y, v.z);
+	GLfloat values[] = { v.x, v.y, v.z };
+	GLint loc;
+	if (!unchanged(name, values, sizeof(values), loc))
+		glUniform3f(loc, v.x, v.y, v.z);
 }
 
 void Program::uniform(const GLchar* name, const Vec4& v)
 {
-	glUniform4f(glGetUniformLocation(id(), name), v.x, v.y, v.z, v.w);
+	GLfloat values[] = { v.x, v.y, v.z, v.w };
+	GLint loc;
+	if (!unchanged(name, values, sizeof(values), loc))
+		glUniform4f(loc, v.x, v.y, v.z, v.w);
 }
 
 void Program::uniform(const GLchar* name, const std::vector<Vec2>& v)
 {
-	if (!v.empty()) {
-		glUniform2fv(glGetUniformLocation(id(), name), v.size(), (const GLfloat*)(&v[0]));
-	}
+	GLint loc;
+	if (!v.empty() && !unchanged(name, &v[0], v.size() * sizeof(Vec2), loc))
+		glUniform2fv(loc, static_cast<GLsizei>(v.size()), (const GLfloat*)(&v[0]));
 }
 
 void Program::uniform(const GLchar* name, const std::vector<Vec3>& v)
 {
-	if (!v.empty()) {
-		glUniform3fv(glGetUniformLocation(id(), name), v.size(), (const GLfloat*)(&v[0]));
-	}
+	GLint loc;
+	if (!v.empty() && !unchanged(name, &v[0], v.size() * sizeof(Vec3), loc))
+		glUniform3fv(loc, static_cast<GLsizei>(v.size()), (const GLfloat*)(&v[0]));
 }
 
 void Program::uniform(const GLchar* name, const std::vector<Vec4>& v)
 {
-	if (!v.empty()) {
-		glUniform4fv(glGetUniformLocation(id(), name), v.size(), (const GLfloat*)(&v[0]));
-	}
+	GLint loc;
+	if (!v.empty() && !unchanged(name, &v[0], v.size() * sizeof(Vec4), loc))
+		glUniform4fv(loc, static_cast<GLsizei>(v.size()), (const GLfloat*)(&v[0]));
 }
 
 void Program::uniform(const GLchar* name, const Mat4& m)
 {
-	glUniformMatrix4fv(glGetUniformLocation(id(), name), 1, false, m);
-}
\ No newline at end of file
+	const GLfloat* values = m;
+	GLint loc;
+	if (!unchanged(name, values, 16 * sizeof(GLfloat), loc))
+		glUniformMatrix4fv(loc, 1, false, values);
+}
@@ -4,15 +4,32 @@
 #include "gl/glew.h"
 #include "gl/Shader.h"
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include "gl/math/Math.h"
 
 namespace gl
 {
-    /** A compiled and linked set of vertex and fragment shaders. */
+    /**
+     * A compiled and linked set of vertex and fragment shaders. The active uniforms and attributes
+     * are enumerated once at link time and looked up by a hash of their name afterwards, so no
+     * location queries reach the driver while drawing. The last value of each uniform is cached and
+     * uniform() skips calls that would not change it; uniforms must therefore only be set through
+     * this class.
+     */
     class Program
     {
     public:
+        /** Driver calls made and avoided by all programs */
+        struct Counters
+        {
+            unsigned locationQueries;  // glGetUniformLocation / glGetAttribLocation calls
+            unsigned cachedLookups;    // lookups answered from the link-time tables
+            unsigned uniformCalls;     // glUniform* calls
+            unsigned skippedUniforms;  // glUniform* calls skipped because the value didn't change
+        };
+
         Program();
 
 		~Program();
@@ -53,13 +70,44 @@ namespace gl
 		void uniform(const GLchar* name, const std::vector<Vec4>& v);
 		void uniform(const GLchar* name, const Mat4& m);
         
+        /** Counters of the last completed frame */
+        static const Counters& frameCounters() { return frameCounters_; }
+
+        /** Ends the current frame's counters; call once per frame */
+        static void endFrame();
+
         static Program create(const char* vsrc, const char* fsrc);
         static Program createFromSrc(const char* vsrc, const char* fsrc);
         static Program create(const Shader& vShader, const Shader& fShader);
 
     private:
+		struct Variable
+		{
+			std::string name;
+			GLint location;
+			bool element;            // single element of an array ("name[2]"); its value isn't cached
+			std::vector<char> value; // last value set (uniforms only); empty if unknown
+		};
+
+		/** Link-time tables shared by all copies of a program */
+		struct Reflection
+		{
+			std::vector<Variable> uniforms;
+			std::vector<Variable> attributes;
+			std::unordered_map<unsigned, size_t> uniformIndex;
+			std::unordered_map<unsigned, size_t> attributeIndex;
+		};
+
 		std::shared_ptr<GLuint> handle_;
 		std::vector<gl::Shader> attached_;
+		std::shared_ptr<Reflection> reflection_;
+
+		static Counters counters_;
+		static Counters frameCounters_;
+
+		void reflect();
+		Variable* lookup(bool uniform, const GLchar* name) const;
+		bool unchanged(const GLchar* name, const void* value, size_t size, GLint& location);
     };
 }
 
@@ -15,6 +15,9 @@ namespace gl
 		void center(const Vec3& center) { center_ = center; }
 		Vec3 center() const { return center_; }
 
+		void radius(float radius) { radius_ = radius; }
+		float radius() const { return radius_; }
+
 	private:
 		Vec3 center_;
 		float radius_;
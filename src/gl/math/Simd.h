@@ -0,0 +1,230 @@
+#ifndef __GL_MATH_SIMD_H__
+#define __GL_MATH_SIMD_H__
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GL_MATH_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GL_MATH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace gl
+{
+	/// Kernels behind the Matrix4 operators. Matrices are 16 values stored by column first and
+	/// vectors are 4 values; none of the arrays need to be aligned, and the output must not
+	/// overlap an input. The templates are the scalar versions; float overloads use SSE or NEON
+	/// when the target has them and are chosen over the templates automatically.
+	namespace simd
+	{
+		/// out = m * v
+		template <typename T> inline void transform(const T* m, const T* v, T* out)
+		{
+			for (int i = 0; i < 4; ++i)
+				out[i] = m[i] * v[0] + m[i + 4] * v[1] + m[i + 8] * v[2] + m[i + 12] * v[3];
+		}
+
+		/// out = a * b
+		template <typename T> inline void multiply(const T* a, const T* b, T* out)
+		{
+			for (int j = 0; j < 4; ++j)
+				transform(a, b + j * 4, out + j * 4);
+		}
+
+		/// out = inverse of m; returns false (and leaves out untouched) if m is singular
+		template <typename T> inline bool inverse(const T* m, T* out)
+		{
+			// adapted from MESA implementation of gluInvertMatrix
+			T inv[16], det;
+
+			inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] +
+				m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+			inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] -
+				m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+			inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] +
+				m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+			inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] -
+				m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+			inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] -
+				m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+			inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] +
+				m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+			inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] -
+				m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+			inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] +
+				m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+			inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] +
+				m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+			inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] -
+				m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+			inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] +
+				m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+			inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] -
+				m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+			inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] -
+				m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+			inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] +
+				m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+			inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] -
+				m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+			inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] +
+				m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+			det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+			if (det == 0)
+				return false;
+
+			det = static_cast<T>(1.0 / det);
+			for (int i = 0; i < 16; i++)
+				out[i] = inv[i] * det;
+			return true;
+		}
+
+#if defined(GL_MATH_SSE)
+
+		inline void transform(const float* m, const float* v, float* out)
+		{
+			__m128 r = _mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(v[0]));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_set1_ps(v[1])));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(v[2])));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(v[3])));
+			_mm_storeu_ps(out, r);
+		}
+
+		inline void multiply(const float* a, const float* b, float* out)
+		{
+			__m128 c0 = _mm_loadu_ps(a);
+			__m128 c1 = _mm_loadu_ps(a + 4);
+			__m128 c2 = _mm_loadu_ps(a + 8);
+			__m128 c3 = _mm_loadu_ps(a + 12);
+			for (int j = 0; j < 16; j += 4) {
+				__m128 r = _mm_mul_ps(c0, _mm_set1_ps(b[j]));
+				r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(b[j + 1])));
+				r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(b[j + 2])));
+				r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(b[j + 3])));
+				_mm_storeu_ps(out + j, r);
+			}
+		}
+
+		inline bool inverse(const float* src, float* out)
+		{
+			// cofactor expansion from Intel's "Streaming SIMD Extensions - Inverse of 4x4 Matrix"
+			// (AP-928), with an exact division instead of the reciprocal estimate. The inverse of
+			// the transpose is the transpose of the inverse, so the storage order doesn't matter.
+			__m128 minor0, minor1, minor2, minor3;
+			__m128 row0, row1, row2, row3;
+			__m128 det, tmp1;
+
+			tmp1 = _mm_setzero_ps();
+			row1 = _mm_setzero_ps();
+			row3 = _mm_setzero_ps();
+
+			tmp1 = _mm_loadh_pi(_mm_loadl_pi(tmp1, (const __m64*)(src)), (const __m64*)(src + 4));
+			row1 = _mm_loadh_pi(_mm_loadl_pi(row1, (const __m64*)(src + 8)), (const __m64*)(src + 12));
+			row0 = _mm_shuffle_ps(tmp1, row1, 0x88);
+			row1 = _mm_shuffle_ps(row1, tmp1, 0xDD);
+			tmp1 = _mm_loadh_pi(_mm_loadl_pi(tmp1, (const __m64*)(src + 2)), (const __m64*)(src + 6));
+			row3 = _mm_loadh_pi(_mm_loadl_pi(row3, (const __m64*)(src + 10)), (const __m64*)(src + 14));
+			row2 = _mm_shuffle_ps(tmp1, row3, 0x88);
+			row3 = _mm_shuffle_ps(row3, tmp1, 0xDD);
+
+			tmp1 = _mm_mul_ps(row2, row3);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+			minor0 = _mm_mul_ps(row1, tmp1);
+			minor1 = _mm_mul_ps(row0, tmp1);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+			minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp1), minor0);
+			minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor1);
+			minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+			tmp1 = _mm_mul_ps(row1, row2);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+			minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor0);
+			minor3 = _mm_mul_ps(row0, tmp1);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+			minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp1));
+			minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor3);
+			minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+			tmp1 = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+			row2 = _mm_shuffle_ps(row2, row2, 0x4E);
+			minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor0);
+			minor2 = _mm_mul_ps(row0, tmp1);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+			minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp1));
+			minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor2);
+			minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+			tmp1 = _mm_mul_ps(row0, row1);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+			minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor2);
+			minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp1), minor3);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+			minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp1), minor2);
+			minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp1));
+
+			tmp1 = _mm_mul_ps(row0, row3);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+			minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp1));
+			minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor2);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+			minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor1);
+			minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp1));
+
+			tmp1 = _mm_mul_ps(row0, row2);
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+			minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor1);
+			minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp1));
+			tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+			minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp1));
+			minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor3);
+
+			det = _mm_mul_ps(row0, minor0);
+			det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+			det = _mm_add_ss(_mm_shuffle_ps(det, det, 0xB1), det);
+			if (_mm_cvtss_f32(det) == 0.0f)
+				return false;
+
+			det = _mm_div_ss(_mm_set_ss(1.0f), det);
+			det = _mm_shuffle_ps(det, det, 0x00);
+			_mm_storeu_ps(out, _mm_mul_ps(det, minor0));
+			_mm_storeu_ps(out + 4, _mm_mul_ps(det, minor1));
+			_mm_storeu_ps(out + 8, _mm_mul_ps(det, minor2));
+			_mm_storeu_ps(out + 12, _mm_mul_ps(det, minor3));
+			return true;
+		}
+
+#elif defined(GL_MATH_NEON)
+
+		inline void transform(const float* m, const float* v, float* out)
+		{
+			float32x4_t r = vmulq_n_f32(vld1q_f32(m), v[0]);
+			r = vmlaq_n_f32(r, vld1q_f32(m + 4), v[1]);
+			r = vmlaq_n_f32(r, vld1q_f32(m + 8), v[2]);
+			r = vmlaq_n_f32(r, vld1q_f32(m + 12), v[3]);
+			vst1q_f32(out, r);
+		}
+
+		inline void multiply(const float* a, const float* b, float* out)
+		{
+			float32x4_t c0 = vld1q_f32(a);
+			float32x4_t c1 = vld1q_f32(a + 4);
+			float32x4_t c2 = vld1q_f32(a + 8);
+			float32x4_t c3 = vld1q_f32(a + 12);
+			for (int j = 0; j < 16; j += 4) {
+				float32x4_t r = vmulq_n_f32(c0, b[j]);
+				r = vmlaq_n_f32(r, c1, b[j + 1]);
+				r = vmlaq_n_f32(r, c2, b[j + 2]);
+				r = vmlaq_n_f32(r, c3, b[j + 3]);
+				vst1q_f32(out + j, r);
+			}
+		}
+
+		// the inverse uses the scalar template on NEON
+
+#endif
+	}
+}
+
+#endif // __GL_MATH_SIMD_H__
@@ -1,7 +1,10 @@
 #include "Draw.h"
 #include "gl/math/Math.h"
+#include <cstring>
+#include <map>
 
 using namespace gl;
+using namespace std;
 
 static const char* vSrc = "\
 #version 150\n\
@@ -24,47 +27,217 @@ void main()\n\
     display_color = vec4(fs_color, 1.0);\n\
 }";
 
-Draw::Draw()
+namespace
 {
+	const GLsizei floatsPerVertex = 6;
+	const GLsizeiptr initialCapacity = 256 * 1024;
+
+	/** Shared program and streaming buffer for all Draw instances */
+	struct Batch
+	{
+		Program program;
+		Buffer ring;
+		GLsizeiptr capacity;
+		GLintptr head;         // next free byte in the ring
+		GLenum mode;           // GL_POINTS, GL_LINES or GL_TRIANGLES
+		Mat4 mvp;
+		vector<GLfloat> queued;
+
+		Batch() : capacity(0), head(0), mode(GL_TRIANGLES) {}
+	};
+
+	Batch& batch()
+	{
+		static Batch b;
+		if (b.program.id() == 0) {
+			b.program = Program::createFromSrc(vSrc, fSrc);
+		}
+		return b;
+	}
+
+	/** Points on the unit circle; the table for each segment count is computed once */
+	const vector<Vec2>& unitCircle(int numSegments)
+	{
+		static map<int, vector<Vec2>> tables;
+		vector<Vec2>& table = tables[numSegments];
+		if (table.empty()) {
+			table.resize(numSegments + 1);
+			for (int i = 0; i <= numSegments; i++) {
+				float angle = two_pi * (i % numSegments) / numSegments;
+				table[i] = Vec2(std::cos(angle), std::sin(angle));
+			}
+		}
+		return table;
+	}
+
+	/** Independent primitive type that the vertices of a mode are converted to */
+	GLenum batchMode(GLenum mode)
+	{
+		switch (mode) {
+		case GL_POINTS:
+			return GL_POINTS;
+		case GL_LINES:
+		case GL_LINE_STRIP:
+		case GL_LINE_LOOP:
+			return GL_LINES;
+		default:
+			return GL_TRIANGLES;
+		}
+	}
+
+	void append(vector<GLfloat>& out, const GLfloat* v)
+	{
+		out.insert(out.end(), v, v + floatsPerVertex);
+	}
+
+	void bindAttributes(Program& program, GLintptr offset)
+	{
+		GLint loc = program.getAttribute("vs_position");
+		glEnableVertexAttribArray(loc);
+		glVertexAttribPointer(loc, 3, GL_FLOAT, false, floatsPerVertex * sizeof(GLfloat), (GLvoid*)offset);
+
+		loc = program.getAttribute("vs_color");
+		glEnableVertexAttribArray(loc);
+		glVertexAttribPointer(loc, 3, GL_FLOAT, false, floatsPerVertex * sizeof(GLfloat), (GLvoid*)(offset + 3 * sizeof(GLfloat)));
+	}
 }
 
-void Draw::begin(GLenum mode)
+Mesh::Mesh() : mode_(GL_LINES), count_(0)
+{
+}
+
+void Mesh::draw(const Mat4& mvp) const
 {
-	if (lineShader.id() == 0 || lineBuffer.id() == 0) {
-		lineShader = Program::createFromSrc(vSrc, fSrc);
-		lineBuffer.generateVBO(GL_DYNAMIC_DRAW);
+	if (empty()) {
+		return;
 	}
+
+	Draw::flush();
+
+	Batch& b = batch();
+	b.program.enable();
+	b.program.uniform("modelViewProj", mvp);
+	buffer_.bind();
+	bindAttributes(b.program, 0);
+	glDrawArrays(mode_, 0, count_);
+}
+
+Draw::Draw() : mode(GL_LINES)
+{
+}
+
+void Draw::begin(GLenum mode)
+{
 	this->mode = mode;
 	vertices.clear();
 }
 
 void Draw::end()
 {
-	if (vertices.empty()) {
+}
+
+void Draw::draw()
+{
+	const GLsizei n = static_cast<GLsizei>(vertices.size() / floatsPerVertex);
+	if (n == 0) {
 		return;
 	}
 
-	lineBuffer.bind();
-	lineBuffer.data(&vertices[0], vertices.size() * sizeof(GLfloat));
+	Batch& b = batch();
+	GLenum target = batchMode(mode);
+	if (!b.queued.empty() && (target != b.mode || std::memcmp((const float*)b.mvp, (const float*)modelViewProjection, 16 * sizeof(float)) != 0)) {
+		flush();
+	}
+	b.mode = target;
+	b.mvp = modelViewProjection;
+
+	// strips, loops and fans are unrolled so consecutive draws can share one glDrawArrays
+	const GLfloat* v = &vertices[0];
+	switch (mode) {
+	case GL_LINE_STRIP:
+	case GL_LINE_LOOP:
+		for (GLsizei i = 0; i + 1 < n; i++) {
+			append(b.queued, v + i * floatsPerVertex);
+			append(b.queued, v + (i + 1) * floatsPerVertex);
+		}
+		if (mode == GL_LINE_LOOP && n > 2) {
+			append(b.queued, v + (n - 1) * floatsPerVertex);
+			append(b.queued, v);
+		}
+		break;
+	case GL_TRIANGLE_STRIP:
+		for (GLsizei i = 0; i + 2 < n; i++) {
+			append(b.queued, v + i * floatsPerVertex);
+			append(b.queued, v + (i + 1) * floatsPerVertex);
+			append(b.queued, v + (i + 2) * floatsPerVertex);
+		}
+		break;
+	case GL_TRIANGLE_FAN:
+		for (GLsizei i = 1; i + 1 < n; i++) {
+			append(b.queued, v);
+			append(b.queued, v + i * floatsPerVertex);
+			append(b.queued, v + (i + 1) * floatsPerVertex);
+		}
+		break;
+	default:
+		b.queued.insert(b.queued.end(), vertices.begin(), vertices.end());
+		break;
+	}
 }
 
-void Draw::draw()
+void Draw::flush()
 {
-	lineShader.enable();
-	lineBuffer.bind();
+	Batch& b = batch();
+	if (b.queued.empty()) {
+		return;
+	}
+
+	GLsizeiptr size = b.queued.size() * sizeof(GLfloat);
+	if (b.ring.id() == 0) {
+		b.ring.generateVBO(GL_STREAM_DRAW);
+	}
+	b.ring.bind();
 
-	GLint loc = lineShader.getAttribute("vs_position");
-	glEnableVertexAttribArray(loc);
-	glVertexAttribPointer(loc, 3, GL_FLOAT, false, 6 * sizeof(GLfloat), 0);
+	// the ring is only ever appended to, so writes never touch data a pending draw may read;
+	// once it is full the storage is orphaned and the driver hands back a fresh block
+	if (b.capacity < size) {
+		b.capacity = std::max(size, std::max(b.capacity * 2, initialCapacity));
+		b.ring.data(nullptr, b.capacity);
+		b.head = 0;
+	} else if (b.head + size > b.capacity) {
+		b.ring.data(nullptr, b.capacity);
+		b.head = 0;
+	}
 
-	loc = lineShader.getAttribute("vs_color");
-	glEnableVertexAttribArray(loc);
-	glVertexAttribPointer(loc, 3, GL_FLOAT, false, 6 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+	GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+	void* dst = glMapBufferRange(GL_ARRAY_BUFFER, b.head, size, access);
+	if (dst) {
+		std::memcpy(dst, &b.queued[0], size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	} else {
+		b.ring.subData(&b.queued[0], size, b.head);
+	}
 
-	loc = lineShader.getUniform("modelViewProj");
-	glUniformMatrix4fv(loc, 1, false, modelViewProjection);
+	b.program.enable();
+	b.program.uniform("modelViewProj", b.mvp);
+	bindAttributes(b.program, b.head);
+	glDrawArrays(b.mode, 0, static_cast<GLsizei>(b.queued.size() / floatsPerVertex));
 
-	glDrawArrays(mode, 0, static_cast<GLsizei>(vertices.size() / 6));
+	b.head += size;
+	b.queued.clear();
+}
+
+Mesh Draw::mesh() const
+{
+	Mesh m;
+	m.mode_ = mode;
+	m.count_ = static_cast<GLsizei>(vertices.size() / floatsPerVertex);
+	if (m.count_ > 0) {
+		m.buffer_.generateVBO(GL_STATIC_DRAW);
+		m.buffer_.bind();
+		m.buffer_.data(&vertices[0], vertices.size() * sizeof(GLfloat));
+	}
+	return m;
 }
 
 void Draw::setModelViewProj(const Mat4& mvp)
@@ -81,12 +254,15 @@ void Draw::color(float r, float g, float b)
 
 void Draw::vertex(float x, float y, float z)
 {
-	vertices.push_back(x);
-	vertices.push_back(y);
-	vertices.push_back(z);
-	vertices.push_back(currentColor.x);
-	vertices.push_back(currentColor.y);
-	vertices.push_back(currentColor.z);
+	size_t i = vertices.size();
+	vertices.resize(i + floatsPerVertex);
+	GLfloat* v = &vertices[i];
+	v[0] = x;
+	v[1] = y;
+	v[2] = z;
+	v[3] = currentColor.x;
+	v[4] = currentColor.y;
+	v[5] = currentColor.z;
 }
 
 void Draw::line(float x1, float y1, float x2, float y2)
@@ -97,12 +273,18 @@ void Draw::line(float x1, float y1, float x2, float y2)
 
 void Draw::circle(float x, float y, float radius, int numSegments)
 {
-	float angle = 0.0f;
-	float step = two_pi / numSegments;
-	for (int i = 0; i < numSegments; ++i) {
-		vertex(x + std::cos(angle) * radius, y + std::sin(angle) * radius);
-		vertex(x + std::cos(angle + step) * radius, y + std::sin(angle + step) * radius);
-		angle += step;
+	const vector<Vec2>& unit = unitCircle(numSegments);
+	if (mode == GL_LINES) {
+		for (int i = 0; i < numSegments; ++i) {
+			vertex(x + unit[i].x * radius, y + unit[i].y * radius);
+			vertex(x + unit[i + 1].x * radius, y + unit[i + 1].y * radius);
+		}
+	} else {
+		// a fan or loop only needs each point once; strips also need the closing point
+		int count = (mode == GL_LINE_STRIP) ? numSegments + 1 : numSegments;
+		for (int i = 0; i < count; ++i) {
+			vertex(x + unit[i].x * radius, y + unit[i].y * radius);
+		}
 	}
 }
 
@@ -112,4 +294,4 @@ void Draw::geometry(const Geometry& g)
 		const Vec3& p = g.vertices[g.indices[i]];
 		vertex(p.x, p.y, p.z);
 	}
-}
\ No newline at end of file
+}
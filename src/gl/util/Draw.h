@@ -9,17 +9,52 @@
 #include "Geometry.h"
 #include <vector>
 
-/** Simple "immediate mode" utility for debug drawing */
 namespace gl{
+	/** Static vertices recorded with Draw and kept in their own buffer (ex. bounding box lines) */
+	class Mesh
+	{
+	public:
+		Mesh();
+
+		bool empty() const { return count_ == 0; }
+
+		/** Draws the mesh after any queued Draw primitives */
+		void draw(const Mat4& mvp) const;
+
+	private:
+		friend class Draw;
+
+		Buffer buffer_;
+		GLenum mode_;
+		GLsizei count_;
+	};
+
+	/**
+	 * Simple "immediate mode" utility for debug drawing. All instances share one program and one
+	 * streaming vertex buffer: draw() only queues the vertices, converted to independent lines or
+	 * triangles, and the queue is drawn with a single call when the transform or primitive type
+	 * changes or flush() is called. Callers must flush() before changing other GL state or drawing
+	 * with another program; MainRenderer flushes after each layer.
+	 */
 	class Draw
 	{
 	public:
 		Draw();
 
 		void begin(GLenum mode);
+
+		/** Ends recording; the vertices are kept until the next begin() */
 		void end();
+
+		/** Queues the vertices between the last begin() and end(); they can be queued again later */
 		void draw();
 
+		/** Draws all queued primitives */
+		static void flush();
+
+		/** Copies the vertices between the last begin() and end() into a static mesh */
+		Mesh mesh() const;
+
 		void setModelViewProj(const Mat4& mvp);
 
 		void color(float r, float g, float b);
@@ -34,8 +69,6 @@ namespace gl{
 
 	private:
 		Mat4 modelViewProjection;
-		gl::Program lineShader;
-		gl::Buffer lineBuffer;
 		std::vector<GLfloat> vertices;
 		Vec3 currentColor;
 		GLenum mode;
@@ -64,6 +64,12 @@ public:
 	{
 	}
 
+	/** Returns TRUE while the layer needs new frames without any input (animations, progressive rendering, background work). */
+	virtual bool animating() const
+	{
+		return false;
+	}
+
 	/** If this layer has some context menu, it can be created here */
 	virtual std::unique_ptr<Menu> contextMenu()
 	{
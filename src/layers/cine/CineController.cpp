@@ -0,0 +1,227 @@
+#include "CineController.h"
+#include "main/MainController.h"
+#include "main/MainConfig.h"
+#include <iomanip>
+#include <sstream>
+
+using namespace gl;
+using namespace std;
+using namespace std::chrono;
+using namespace Leap;
+
+CineController::CineController() :
+	cache_(MainConfig().getValue<unsigned>(MainConfig::CINE_CACHE_PHASES, 8)),
+	phase_(0),
+	shown_(0),
+	direction_(1),
+	playing_(false),
+	timer_(0),
+	rate_timer_(0),
+	streamed_(0),
+	rate_(0.0f),
+	shading_off_(false),
+	saved_phase_(0),
+	leap_scrub_dst_(10.0f)
+{
+	MainConfig cfg;
+	fps_ = max(1.0f, cfg.getValue<float>(MainConfig::CINE_FPS, 15.0f));
+
+	text_.loadFont("menlo18");
+
+	poses_.l().enabled(true);
+	poses_.l().engageDelay(milliseconds(0));
+	poses_.l().disengageDelay(milliseconds(0));
+	poses_.l().trackFunction(std::bind(&CineController::leapScrub, this, std::placeholders::_1));
+	poses_.l().closeFn([&](const Leap::Frame& c){
+		saved_phase_ = phase_;
+		play(false);
+	});
+}
+
+void CineController::setVolume(VolumeData* volume)
+{
+	cache_.close();
+	restoreShading();
+	phase_ = 0;
+	shown_ = 0;
+	direction_ = 1;
+	playing_ = false;
+	timer_ = milliseconds(0);
+}
+
+void CineController::open(const string& directory)
+{
+	cache_.open(directory);
+}
+
+void CineController::phase(int index)
+{
+	int count = static_cast<int>(cache_.numPhases());
+	if (count == 0)
+		return;
+
+	if (index < 0) {
+		index = count - 1 - (-index - 1) % count;
+	} else {
+		index = index % count;
+	}
+
+	if (index != static_cast<int>(phase_)) {
+		direction_ = (index > static_cast<int>(phase_)) ? 1 : -1;
+	}
+	phase_ = static_cast<unsigned>(index);
+}
+
+void CineController::play(bool playing)
+{
+	playing_ = playing && active();
+	timer_ = milliseconds(0);
+	if (playing_) {
+		direction_ = 1;
+	}
+}
+
+bool CineController::keyboardInput(GLFWwindow* window, int key, int action, int mods)
+{
+	if (!active())
+		return true;
+
+	if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
+		play(!playing_);
+	} else if (key == GLFW_KEY_PERIOD && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+		play(false);
+		phase(phase_ + 1);
+	} else if (key == GLFW_KEY_COMMA && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+		play(false);
+		phase(static_cast<int>(phase_) - 1);
+	}
+
+	return true;
+}
+
+bool CineController::leapInput(const Leap::Controller& controller, const Leap::Frame& frame)
+{
+	poses_.update(frame);
+
+	return false;
+}
+
+void CineController::leapScrub(const Leap::Frame& frame)
+{
+	if (poses_.l().isClosed()) {
+		auto& lsc = MainController::getInstance().leapStateController();
+		lsc.increaseBrightness(LeapStateController::icon_l_open);
+		Vector delta = poses_.l().hand().fingers()[Finger::TYPE_INDEX].tipPosition() - poses_.l().handClosed().fingers()[Finger::TYPE_INDEX].tipPosition();
+		phase(static_cast<int>(saved_phase_ + delta.x / leap_scrub_dst_));
+	}
+}
+
+void CineController::update(milliseconds elapsed)
+{
+	// read once: a decode error on the cache thread drops the phases at any time
+	unsigned count = cache_.numPhases();
+	if (count < 2)
+		return;
+
+	if (playing_) {
+		// only move on to a decoded phase; a late one holds the current phase instead of stalling
+		milliseconds interval(static_cast<long long>(1000.0f / fps_));
+		timer_ += elapsed;
+		if (timer_ >= interval) {
+			unsigned next = (phase_ + 1) % count;
+			if (cache_.get(next)) {
+				phase_ = next;
+				timer_ = min(timer_ - interval, interval);
+			} else {
+				timer_ = interval;
+			}
+		}
+	}
+
+	cache_.seek(phase_, direction_);
+	stream();
+
+	// measured rate, so a cache that can't keep up shows
+	rate_timer_ += elapsed;
+	if (rate_timer_ >= seconds(1)) {
+		rate_ = streamed_ * 1000.0f / rate_timer_.count();
+		streamed_ = 0;
+		rate_timer_ = milliseconds(0);
+	}
+
+	stringstream ss;
+	ss << "Phase " << (phase_ + 1) << " / " << count;
+	if (playing_)
+		ss << ", " << fixed << setprecision(1) << rate_ << " volumes/s";
+
+	text_.viewport(viewport_);
+	text_.clear();
+	text_.hAlign(TextRenderer::HAlign::center);
+	text_.vAlign(TextRenderer::VAlign::bottom);
+	text_.color(0.0f, 0.0f, 0.0f, 1.0f);
+	text_.add(ss.str(), viewport_.width / 2.0f - 1, 39.0f);
+	text_.color(1.0f, 1.0f, 1.0f, 1.0f);
+	text_.add(ss.str(), viewport_.width / 2.0f, 40.0f);
+}
+
+void CineController::stream()
+{
+	if (static_cast<int>(phase_) == shown_)
+		return;
+
+	shared_ptr<VolumeData> volume = cache_.get(phase_);
+	if (!volume)
+		return;
+
+	VolumeController& vc = MainController::getInstance().volumeController();
+	if (!vc.streamVolume(volume.get())) {
+		// the volume texture isn't resident; there is nothing to update
+		shown_ = static_cast<int>(phase_);
+		return;
+	}
+
+	// the gradients are those of the loaded volume (the first phase), so shading would be wrong for the others
+	if (phase_ == 0) {
+		restoreShading();
+	} else if (!shading_off_ && vc.useShading()) {
+		vc.toggleShading();
+		shading_off_ = true;
+	}
+
+	shown_ = static_cast<int>(phase_);
+	streamed_++;
+}
+
+void CineController::restoreShading()
+{
+	if (shading_off_) {
+		VolumeController& vc = MainController::getInstance().volumeController();
+		if (!vc.useShading())
+			vc.toggleShading();
+		shading_off_ = false;
+	}
+}
+
+void CineController::draw()
+{
+	if (active())
+		text_.draw();
+}
+
+bool CineController::animating() const
+{
+	return active() && (playing_ || static_cast<int>(phase_) != shown_);
+}
+
+void CineController::gainFocus()
+{
+	auto& lsc = MainController::getInstance().leapStateController();
+	lsc.clear();
+	lsc.add(LeapStateController::icon_point_circle, "Main Menu");
+	lsc.add(LeapStateController::icon_l_open, "Scrub");
+}
+
+void CineController::loseFocus()
+{
+	poses_.l().tracking(false);
+}
@@ -0,0 +1,65 @@
+#ifndef __medleap_CineController__
+#define __medleap_CineController__
+
+#include "layers/Controller.h"
+#include "data/CineCache.h"
+#include "leap/PoseTracker.h"
+#include "util/TextRenderer.h"
+
+/**
+ * Cine playback of time-resolved (4D) series. Phases are decoded ahead of playback by a CineCache
+ * and streamed into the volume texture, so both the 3D and the 2D views show the current phase.
+ * Playback only moves on to phases that are already decoded, holding the current one otherwise.
+ * Phases can only be shown while the whole volume fits in the texture. Space plays or pauses,
+ * comma and period step; with focus, the L pose scrubs through the phases like slice scrolling.
+ */
+class CineController : public Controller
+{
+public:
+	CineController();
+
+	/** A new volume was loaded; playback of the previous series stops */
+	void setVolume(VolumeData* volume);
+
+	/** Looks for the phases of the series loaded from directory */
+	void open(const std::string& directory);
+
+	/** True if the loaded series has more than one phase */
+	bool active() const { return cache_.numPhases() > 1; }
+
+	unsigned phase() const { return phase_; }
+	void phase(int index);
+	bool playing() const { return playing_; }
+	void play(bool playing);
+
+	bool keyboardInput(GLFWwindow* window, int key, int action, int mods) override;
+	bool leapInput(const Leap::Controller& controller, const Leap::Frame& frame) override;
+	void update(std::chrono::milliseconds elapsed) override;
+	void draw() override;
+	bool animating() const override;
+	void gainFocus() override;
+	void loseFocus() override;
+
+private:
+	CineCache cache_;
+	unsigned phase_;
+	int shown_;                          // phase in the volume texture; the loaded volume is phase 0
+	int direction_;
+	bool playing_;
+	float fps_;
+	std::chrono::milliseconds timer_;
+	std::chrono::milliseconds rate_timer_;
+	unsigned streamed_;
+	float rate_;                         // volumes shown per second
+	bool shading_off_;                   // shading was turned off because gradients are of the first phase
+	PoseTracker poses_;
+	unsigned saved_phase_;
+	float leap_scrub_dst_;
+	TextRenderer text_;
+
+	void stream();
+	void leapScrub(const Leap::Frame& frame);
+	void restoreShading();
+};
+
+#endif // __medleap_CineController__
@@ -26,12 +26,14 @@ ColorPickController::ColorPickController() :
 	color_select_prog_ = Program::create("shaders/color_pick_selected.vert", "shaders/color_pick_selected.frag");
 	gradient_prog_ = Program::create("shaders/color_pick_gradient.vert", "shaders/color_pick_gradient.frag");
 
-	color_cursor_.begin(GL_LINES);
-	color_cursor_.color(0, 0, 0);
-	color_cursor_.circle(0, 0, 25.0f, 32);
-	color_cursor_.color(1, 1, 1);
-	color_cursor_.circle(0, 0, 20.0f, 32);
-	color_cursor_.end();
+	Draw cursor;
+	cursor.begin(GL_LINES);
+	cursor.color(0, 0, 0);
+	cursor.circle(0, 0, 25.0f, 32);
+	cursor.color(1, 1, 1);
+	cursor.circle(0, 0, 20.0f, 32);
+	cursor.end();
+	color_cursor_ = cursor.mesh();
 
 	text_.loadFont("menlo14");
 
@@ -244,13 +246,11 @@ void ColorPickController::draw()
 	// draw cursor circle
 	x = cos(color_.hue()) * circle_rect_.width / 2.0f * color_.saturation() + circle_rect_.center().x;
 	y = sin(color_.hue()) * circle_rect_.width / 2.0f * color_.saturation() + circle_rect_.center().y;
-	color_cursor_.setModelViewProj(projection_ * translation(x, y, 0));
-	color_cursor_.draw();
+	color_cursor_.draw(projection_ * translation(x, y, 0));
 
 	// draw leap cursor
 	if (poses_.v().tracking()) {
-		color_cursor_.setModelViewProj(projection_ * translation(m_leap_cursor.x, m_leap_cursor.y, 0));
-		color_cursor_.draw();
+		color_cursor_.draw(projection_ * translation(m_leap_cursor.x, m_leap_cursor.y, 0));
 	}
 
 	text_.draw();
@@ -261,6 +261,6 @@ void ColorPickController::quad(Program prog, const Rectangle<float>& rect)
 	Mat4 t = translation(rect.center().x, rect.center().y, 0);
 	Mat4 s = scale(rect.width*0.5f, rect.height*0.5f, 1);
 	Mat4 mvp = projection_ * t * s;
-	glUniformMatrix4fv(prog.getUniform("modelViewProjection"), 1, false, mvp);
+	prog.uniform("modelViewProjection", mvp);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 }
\ No newline at end of file
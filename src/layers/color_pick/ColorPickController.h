@@ -45,7 +45,7 @@ private:
 	gl::Rectangle<float> alpha_rect_;
 	gl::Rectangle<float> value_rect_;
 	gl::Rectangle<float> select_rect_;
-	gl::Draw color_cursor_;
+	gl::Mesh color_cursor_;
 	gl::Mat4 projection_;
 	gl::Vec2 m_leap_cursor;
 	TextRenderer text_;
@@ -6,7 +6,7 @@ using namespace gl;
 using namespace std;
 using namespace Leap;
 
-FocusController::FocusController()
+FocusController::FocusController() : cursor_moving_(false)
 {
 	poses_.v().enabled(true);
 	poses_.palmsFace().enabled(true);
@@ -46,7 +46,14 @@ bool FocusController::leapInput(const Leap::Controller& controller, const Leap::
 	poses_.update(frame);
 
 	if (poses_.v().tracking()) {
-		moveCursor();
+		moveCursor(frame);
+	} else if (cursor_moving_) {
+		// drop the predicted lead once the cursor is released
+		cursor_moving_ = false;
+		cursor_predictor_.reset();
+		VolumeController& vc = MainController::getInstance().volumeController();
+		vc.maskCenter = cursor_pos_;
+		vc.markDirty();
 	}
 
 	if (poses_.palmsFace().tracking()) {
@@ -59,7 +66,7 @@ bool FocusController::leapInput(const Leap::Controller& controller, const Leap::
 	return false;
 }
 
-void FocusController::moveCursor()
+void FocusController::moveCursor(const Frame& frame)
 {
     
     auto& lsc = MainController::getInstance().leapStateController();
@@ -75,7 +82,11 @@ void FocusController::moveCursor()
 
 	cursor_pos_ = mc.volumeData()->getBounds().clamp(cursor_pos_ + hand_delta_ws / 400.0f);
 
-	vc.maskCenter = cursor_pos_;
+	// the cursor is shown where the hand is expected to be when the frame is displayed
+	cursor_moving_ = true;
+	cursor_predictor_.update(poses_.v().handPosition(), frame.timestamp());
+	Vec4 lead_ws = eye2world * cursor_predictor_.lead(PalmPredictor::lookahead()).toVector4<Vec4>();
+	vc.maskCenter = mc.volumeData()->getBounds().clamp(cursor_pos_ + lead_ws / 400.0f);
 	vc.markDirty();
 }
 
@@ -3,6 +3,7 @@
 
 #include "layers/Controller.h"
 #include "leap/PoseTracker.h"
+#include "leap/PalmPredictor.h"
 #include "layers/volume/LeapCameraControl.h"
 
 class FocusController : public Controller
@@ -17,9 +18,11 @@ public:
 private:
 	LeapCameraControl camera_control_;
 	PoseTracker poses_;
+	PalmPredictor cursor_predictor_;
 	gl::Vec3 cursor_pos_;
+	bool cursor_moving_;
 
-	void moveCursor();
+	void moveCursor(const Leap::Frame& frame);
 	void scaleCursor();
 };
 
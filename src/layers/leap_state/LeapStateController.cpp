@@ -77,6 +77,16 @@ void LeapStateController::increaseBrightness(Icon icon)
     }
 }
 
+bool LeapStateController::animating() const
+{
+	// icons fade out a little every frame after being highlighted
+	for (const DisplayedIcon& ic : displayed_) {
+		if (ic.brightness > 0.0f)
+			return true;
+	}
+	return false;
+}
+
 void LeapStateController::draw()
 {
 	Mat4 m_proj = viewport_.orthoProjection();
@@ -33,6 +33,7 @@ public:
 
 	LeapStateController();
 	void draw() override;
+	bool animating() const override;
 	void clear();
 	void add(Icon icon, const std::string& label);
     void increaseBrightness(Icon icon);
@@ -2,50 +2,10 @@
 #include "main/MainController.h"
 
 #if defined(_WIN32)
-#include "util/dirent.h"
 #define DELIM "\\"
 #else
 #define DELIM "/"
-#include <dirent.h>
 #endif
-#include <errno.h>
-
-static enum class FileType
-{
-	other,
-	readable_dir,
-	dcm,
-	file,
-	raw
-};
-
-static FileType fileType(const std::string& wd, struct dirent* entry)
-{
-	if (entry->d_type == DT_DIR) {
-		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
-			return FileType::other;
-		}
-
-		std::string full_name = wd + DELIM + std::string{ entry->d_name };
-		DIR* dir = opendir(full_name.c_str());
-		FileType type = FileType::other;
-		if (dir) {
-			type = FileType::readable_dir;
-		}
-
-		closedir(dir);
-		return type;
-	} else {
-		std::string name{ entry->d_name };
-		if (name.size() > 3 && name.substr(name.size() - 4, 4) == ".raw") {
-			return FileType::raw;
-		} else if (name.size() > 3 && name.substr(name.size() - 4, 4) == ".dcm") {
-			return FileType::dcm;
-		}
-
-		return FileType::file;
-	}
-}
 
 DirectoryMenu::DirectoryMenu() : 
 	Menu("Directory Menu"), 
@@ -59,27 +19,72 @@ void DirectoryMenu::directory(const std::string& directory_name)
 	name = directory_name;
 
 	items_.clear();
+	entries_.clear();
+	details_.clear();
 
-	DIR* dir = opendir(working_dir_.c_str());
-	struct dirent* entry = readdir(dir);
+	scanner_.cancelPrefetch();
+	scanner_.list(working_dir_);
+}
 
-	while (entry != NULL)
-	{
-		FileType type = fileType(working_dir_, entry);
-		std::string subdir{ entry->d_name };
-		std::string full_subdir{ working_dir_ + DELIM + subdir };
+bool DirectoryMenu::poll()
+{
+	bool changed = false;
 
-		if (type == FileType::readable_dir) {
-			createItem(subdir, [this, full_subdir]{ directory(full_subdir); });
-		} else if (type == FileType::raw) {
-			createItem(subdir, [this, full_subdir]{ load({ full_subdir, VolumeLoader::Source::RAW }); });
-		} else if (type == FileType::dcm) {
-			createItem(subdir, [this]{ load({ working_dir_, VolumeLoader::Source::DICOM_DIR }); });
-			break;
+	std::vector<DirectoryScanner::Entry> entries;
+	if (scanner_.takeEntries(entries)) {
+		for (const DirectoryScanner::Entry& entry : entries) {
+			add(entry);
 		}
-		entry = readdir(dir);
+		changed = true;
+	}
+
+	std::vector<std::pair<std::string, DirectoryScanner::Summary>> summaries;
+	if (scanner_.takeSummaries(summaries)) {
+		for (auto& summary : summaries) {
+			for (size_t i = 0; i < entries_.size(); i++) {
+				if (entries_[i].path == summary.first) {
+					details_[i] = summary.second.text();
+				}
+			}
+		}
+		changed = true;
+	}
+
+	return changed;
+}
+
+void DirectoryMenu::add(const DirectoryScanner::Entry& entry)
+{
+	std::string path = entry.path;
+
+	switch (entry.type) {
+	case DirectoryScanner::Type::readable_dir:
+		createItem(entry.name, [this, path]{ directory(path); });
+		break;
+	case DirectoryScanner::Type::raw:
+		createItem(entry.name, [this, path]{ load({ path, VolumeLoader::Source::RAW }); });
+		break;
+	case DirectoryScanner::Type::volume:
+		createItem(entry.name, [this, path]{ load({ path, VolumeLoader::Source::VOLUME_FILE }); });
+		break;
+	case DirectoryScanner::Type::dcm:
+		createItem(entry.name, [this, path]{ load({ path, VolumeLoader::Source::DICOM_DIR }); });
+		break;
+	default:
+		return;
+	}
+
+	entries_.push_back(entry);
+	details_.push_back("");
+}
+
+void DirectoryMenu::highlight(int i)
+{
+	if (i >= 0 && i < static_cast<int>(entries_.size())) {
+		scanner_.prefetch(entries_[i]);
+	} else {
+		scanner_.cancelPrefetch();
 	}
-	closedir(dir);
 }
 
 void DirectoryMenu::upDirectory()
@@ -94,4 +99,4 @@ void DirectoryMenu::load(const VolumeLoader::Source& source)
 	if (on_load_) {
 		on_load_(source);
 	}
-}
\ No newline at end of file
+}
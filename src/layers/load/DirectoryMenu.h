@@ -3,8 +3,14 @@
 
 #include "layers/menu/Menu.h"
 #include "data/VolumeLoader.h"
+#include "DirectoryScanner.h"
 #include <functional>
 
+/**
+ * Menu of the subdirectories, RAW files and DICOM series in a directory. The directory is listed
+ * in the background: items appear as poll() collects them, followed later by a description of
+ * the DICOM series behind each item.
+ */
 class DirectoryMenu : public Menu
 {
 public:
@@ -12,13 +18,32 @@ public:
 	void directory(const std::string& dir);
 	void upDirectory();
 
+	/** Adds the items and details found since the last call. Returns true if anything changed. */
+	bool poll();
+
+	/** True while the directory is still being listed or summarized */
+	bool listing() const { return scanner_.busy(); }
+
+	/** Series summary for item i (ex. "CT, 240 images, 512 x 512"); empty if not known (yet) */
+	const std::string& detail(size_t i) const { return details_[i]; }
+
+	/** File or directory behind item i */
+	const std::string& path(size_t i) const { return entries_[i].path; }
+
+	/** Prefetches the files behind item i; a negative index cancels the prefetch */
+	void highlight(int i);
+
 	void onLoad(std::function<void(const VolumeLoader::Source&)> on_load) { on_load_ = on_load; }
 
 private:
 	std::function<void(const VolumeLoader::Source&)> on_load_;
     std::string working_dir_;
+	DirectoryScanner scanner_;
+	std::vector<DirectoryScanner::Entry> entries_;
+	std::vector<std::string> details_;
 
+	void add(const DirectoryScanner::Entry& entry);
 	void load(const VolumeLoader::Source& source);
 };
 
-#endif // __medleap_DirectoryMenu__
\ No newline at end of file
+#endif // __medleap_DirectoryMenu__
@@ -0,0 +1,290 @@
+#include "DirectoryScanner.h"
+#include "data/VolumeFile.h"
+#include "gdcmReader.h"
+#include "gdcmAttribute.h"
+#include "gdcmScanner.h"
+#include "gdcmTag.h"
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include "util/dirent.h"
+#define DELIM "\\"
+#else
+#define DELIM "/"
+#include <dirent.h>
+#endif
+
+using namespace std;
+using namespace gdcm;
+
+namespace
+{
+	const size_t prefetchChunk = 1 << 20;
+
+	/** Directories summarized so far; false entries have no DICOM files */
+	mutex indexMutex;
+	map<string, pair<bool, DirectoryScanner::Summary>> headerIndex;
+
+	bool endsWith(const string& name, const char* suffix)
+	{
+		size_t n = strlen(suffix);
+		return name.size() >= n && name.compare(name.size() - n, n, suffix) == 0;
+	}
+
+	bool isDirectory(const string& path, struct dirent* entry)
+	{
+		if (entry->d_type != DT_UNKNOWN) {
+			return entry->d_type == DT_DIR;
+		}
+
+		// some network file systems don't report the type
+		struct stat info;
+		return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == S_IFDIR;
+	}
+
+	DirectoryScanner::Type fileType(const string& path, struct dirent* entry)
+	{
+		if (isDirectory(path, entry)) {
+			if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+				return DirectoryScanner::Type::other;
+			}
+
+			DIR* dir = opendir(path.c_str());
+			if (!dir) {
+				return DirectoryScanner::Type::other;
+			}
+			closedir(dir);
+			return DirectoryScanner::Type::readable_dir;
+		}
+
+		string name{ entry->d_name };
+		if (endsWith(name, ".raw")) {
+			return DirectoryScanner::Type::raw;
+		} else if (endsWith(name, ".dcm")) {
+			return DirectoryScanner::Type::dcm;
+		} else if (VolumeFile::format(name) != VolumeFile::Format::unknown) {
+			return DirectoryScanner::Type::volume;
+		}
+		return DirectoryScanner::Type::file;
+	}
+}
+
+string DirectoryScanner::Summary::text() const
+{
+	stringstream ss;
+	ss << (modality.empty() ? "DICOM" : modality) << ", " << numImages << (numImages == 1 ? " image" : " images");
+	if (width > 0 && height > 0) {
+		ss << ", " << width << " x " << height;
+	}
+	if (numSeries > 1) {
+		ss << " (" << numSeries << " series)";
+	}
+	return ss.str();
+}
+
+DirectoryScanner::DirectoryScanner() : listing_(0)
+{
+}
+
+void DirectoryScanner::list(const string& directory)
+{
+	unsigned listing;
+	{
+		lock_guard<mutex> lock(mutex_);
+		listing = ++listing_;
+		entries_.clear();
+		summaries_.clear();
+	}
+
+	lister_.post([this, directory, listing](const TaskThread::Cancelled& cancelled) {
+		vector<Entry> found;
+		DIR* dir = opendir(directory.c_str());
+		if (!dir) {
+			return;
+		}
+
+		for (struct dirent* e = readdir(dir); e && !cancelled(); e = readdir(dir)) {
+			Entry entry;
+			entry.name = e->d_name;
+			entry.path = directory + DELIM + entry.name;
+			entry.type = fileType(entry.path, e);
+
+			if (entry.type == Type::readable_dir || entry.type == Type::raw || entry.type == Type::volume) {
+				found.push_back(entry);
+				publish(listing, entry);
+			} else if (entry.type == Type::dcm) {
+				// a directory with DICOM files is offered as a single series to load
+				entry.path = directory;
+				found.push_back(entry);
+				publish(listing, entry);
+				break;
+			}
+		}
+		closedir(dir);
+
+		// headers are only read after all names are shown
+		for (const Entry& entry : found) {
+			if (cancelled()) {
+				return;
+			}
+
+			Summary s;
+			if ((entry.type == Type::readable_dir || entry.type == Type::dcm) && summary(entry.path, s, cancelled)) {
+				publish(listing, entry.path, s);
+			}
+		}
+	});
+}
+
+void DirectoryScanner::publish(unsigned listing, const Entry& entry)
+{
+	lock_guard<mutex> lock(mutex_);
+	if (listing == listing_) {
+		entries_.push_back(entry);
+	}
+}
+
+void DirectoryScanner::publish(unsigned listing, const string& path, const Summary& summary)
+{
+	lock_guard<mutex> lock(mutex_);
+	if (listing == listing_) {
+		summaries_.push_back(make_pair(path, summary));
+	}
+}
+
+bool DirectoryScanner::takeEntries(vector<Entry>& entries)
+{
+	lock_guard<mutex> lock(mutex_);
+	entries.clear();
+	entries.swap(entries_);
+	return !entries.empty();
+}
+
+bool DirectoryScanner::takeSummaries(vector<pair<string, Summary>>& summaries)
+{
+	lock_guard<mutex> lock(mutex_);
+	summaries.clear();
+	summaries.swap(summaries_);
+	return !summaries.empty();
+}
+
+vector<string> DirectoryScanner::dicomFiles(const string& directory, const TaskThread::Cancelled& cancelled)
+{
+	vector<string> files;
+	DIR* dir = opendir(directory.c_str());
+	if (!dir) {
+		return files;
+	}
+
+	for (struct dirent* entry = readdir(dir); entry && !cancelled(); entry = readdir(dir)) {
+		if (endsWith(entry->d_name, ".dcm")) {
+			files.push_back(directory + DELIM + entry->d_name);
+		}
+	}
+	closedir(dir);
+	return files;
+}
+
+bool DirectoryScanner::summary(const string& directory, Summary& summary, const TaskThread::Cancelled& cancelled)
+{
+	{
+		lock_guard<mutex> lock(indexMutex);
+		auto it = headerIndex.find(directory);
+		if (it != headerIndex.end()) {
+			summary = it->second.second;
+			return it->second.first;
+		}
+	}
+
+	vector<string> files = dicomFiles(directory, cancelled);
+	Summary s = { "", 0, 0, 0, 0 };
+	if (!files.empty() && !cancelled()) {
+		Tag uid(0x0020, 0x000e);
+		Tag modality(0x0008, 0x0060);
+		Scanner scanner;
+		scanner.AddTag(uid);
+		scanner.AddTag(modality);
+		scanner.Scan(files);
+
+		// describe the series with the most images
+		string first;
+		vector<string> seriesIDs = scanner.GetOrderedValues(uid);
+		s.numSeries = static_cast<unsigned>(seriesIDs.size());
+		for (const string& seriesID : seriesIDs) {
+			vector<string> seriesFiles = scanner.GetAllFilenamesFromTagToValue(uid, seriesID.c_str());
+			if (seriesFiles.size() > s.numImages) {
+				s.numImages = static_cast<unsigned>(seriesFiles.size());
+				first = seriesFiles[0];
+				const char* value = scanner.GetValue(first.c_str(), modality);
+				s.modality = value ? value : "";
+			}
+		}
+
+		if (!first.empty() && !cancelled()) {
+			Reader reader;
+			reader.SetFileName(first.c_str());
+			if (reader.ReadUpToTag(Tag(0x0028, 0x0011))) {
+				const DataSet& dataSet = reader.GetFile().GetDataSet();
+				Attribute<0x0028, 0x0010> rows;
+				rows.SetFromDataSet(dataSet);
+				Attribute<0x0028, 0x0011> columns;
+				columns.SetFromDataSet(dataSet);
+				s.height = rows.GetValue();
+				s.width = columns.GetValue();
+			}
+		}
+	}
+
+	// a cancelled scan may be incomplete, so it isn't indexed
+	if (cancelled()) {
+		return false;
+	}
+
+	bool dicom = s.numImages > 0;
+	lock_guard<mutex> lock(indexMutex);
+	headerIndex[directory] = make_pair(dicom, s);
+	summary = s;
+	return dicom;
+}
+
+void DirectoryScanner::prefetch(const Entry& entry)
+{
+	if (entry.type == Type::other || entry.type == Type::file) {
+		cancelPrefetch();
+		return;
+	}
+	if (entry.path == prefetched_) {
+		return;
+	}
+	prefetched_ = entry.path;
+
+	prefetcher_.post([entry](const TaskThread::Cancelled& cancelled) {
+		vector<string> files;
+		if (entry.type == Type::raw || entry.type == Type::volume) {
+			files.push_back(entry.path);
+		} else {
+			files = dicomFiles(entry.path, cancelled);
+		}
+
+		// the data is discarded; reading it is enough to have the OS cache it
+		vector<char> buffer(prefetchChunk);
+		for (const string& file : files) {
+			ifstream in(file.c_str(), ios::binary);
+			while (in && !cancelled()) {
+				in.read(&buffer[0], buffer.size());
+			}
+			if (cancelled()) {
+				return;
+			}
+		}
+	});
+}
+
+void DirectoryScanner::cancelPrefetch()
+{
+	prefetched_.clear();
+	prefetcher_.cancel();
+}
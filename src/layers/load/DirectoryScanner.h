@@ -0,0 +1,92 @@
+#ifndef __medleap_DirectoryScanner__
+#define __medleap_DirectoryScanner__
+
+#include "util/TaskThread.h"
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Lists directories for the load menu on a background thread so slow (ex. network) volumes never
+ * block the UI. Entries are published as soon as they are read and collected by the UI thread
+ * with takeEntries(); once the listing is complete, the DICOM series in each entry are summarized
+ * from their headers. Summaries are kept in a header index for the rest of the session.
+ */
+class DirectoryScanner
+{
+public:
+	enum class Type
+	{
+		other,
+		readable_dir,
+		dcm,
+		file,
+		raw,
+		volume  // NIfTI, NRRD or MetaImage file
+	};
+
+	struct Entry
+	{
+		std::string name;
+		std::string path;  // for dcm entries, the directory that holds the series
+		Type type;
+	};
+
+	/** Largest DICOM series in a directory */
+	struct Summary
+	{
+		std::string modality;
+		unsigned numSeries;
+		unsigned numImages;
+		unsigned width;
+		unsigned height;
+
+		/** Ex. "CT, 240 images, 512 x 512" */
+		std::string text() const;
+	};
+
+	DirectoryScanner();
+
+	/** Starts listing a directory; a listing in progress is cancelled and its results dropped */
+	void list(const std::string& directory);
+
+	/** Moves the entries found since the last call into entries. Returns false if there are none. */
+	bool takeEntries(std::vector<Entry>& entries);
+
+	/** Moves the summaries (keyed by entry path) found since the last call. Returns false if there are none. */
+	bool takeSummaries(std::vector<std::pair<std::string, Summary>>& summaries);
+
+	/** True until the current listing and its summaries are complete */
+	bool busy() const { return lister_.busy(); }
+
+	/**
+	 * Reads the files of a DICOM or RAW entry in the background so they are in the OS file cache
+	 * when the entry is opened. Replaces the previous prefetch unless it is for the same entry.
+	 */
+	void prefetch(const Entry& entry);
+
+	void cancelPrefetch();
+
+	/** DICOM files (by extension) directly in a directory */
+	static std::vector<std::string> dicomFiles(const std::string& directory, const TaskThread::Cancelled& cancelled);
+
+	/** Summary of the DICOM files in a directory, scanned once and then read from the index */
+	static bool summary(const std::string& directory, Summary& summary, const TaskThread::Cancelled& cancelled);
+
+private:
+	std::mutex mutex_;
+	unsigned listing_;
+	std::vector<Entry> entries_;
+	std::vector<std::pair<std::string, Summary>> summaries_;
+	std::string prefetched_;
+
+	// declared last so the threads stop before what they publish to is destroyed
+	TaskThread lister_;
+	TaskThread prefetcher_;
+
+	void publish(unsigned listing, const Entry& entry);
+	void publish(unsigned listing, const std::string& path, const Summary& summary);
+};
+
+#endif // __medleap_DirectoryScanner__
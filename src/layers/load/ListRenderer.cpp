@@ -8,20 +8,50 @@ ListRenderer::ListRenderer() :
 	horizontal_pad_(40.0f),
 	vertical_pad_(10.0f),
 	item_height_(120.0f),
+	content_height_(0.0f),
 	index_count_(0),
-	alpha_(1.0f)
+	alpha_(1.0f),
+	highlighted_(-1),
+	use_clock_(0),
+	thumb_vertex_count_(0),
+	thumbs_dirty_(false)
 {
 	prog_ = Program::create("shaders/menu.vert", "shaders/menu.frag");
 	vbo_.generateVBO(GL_DYNAMIC_DRAW);
 	ibo_.generateIBO(GL_DYNAMIC_DRAW);
 
+	thumb_prog_ = Program::create("shaders/thumbnail.vert", "shaders/thumbnail.frag");
+	thumb_vbo_.generateVBO(GL_DYNAMIC_DRAW);
+	atlas_.generate(GL_TEXTURE_2D);
+	atlas_.bind();
+	atlas_.setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	atlas_.setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	atlas_.setParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	atlas_.setParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	atlas_.setData2D(GL_R8, atlas_size_, atlas_size_, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+
 	text_.loadFont("menlo24");
+	detail_text_.loadFont("menlo14");
 }
 
 void ListRenderer::update(const DirectoryMenu& menu, const gl::Viewport& viewport)
 {
+	viewport_ = viewport;
+
+	// items that summarize a DICOM series show its thumbnail once it is uploaded
+	item_paths_.clear();
+	for (size_t i = 0; i < menu.items().size(); i++) {
+		item_paths_.push_back(menu.detail(i).empty() ? string() : menu.path(i));
+		auto slot = slots_.find(item_paths_.back());
+		if (slot != slots_.end() && slot->second >= 0) {
+			slot_uses_[slot->second] = ++use_clock_;
+		}
+	}
+	thumbs_dirty_ = true;
+
 	if (menu.items().empty()) {
 		index_count_ = 0;
+		content_height_ = 0.0f;
 		return;
 	}
 
@@ -70,8 +100,22 @@ void ListRenderer::update(const DirectoryMenu& menu, const gl::Viewport& viewpor
 	text_.vAlign(TextRenderer::VAlign::center);
 	float x = viewport.width / 2.0f;
 	float y = viewport.height - vertical_pad_ - 0.5f * item_height_;
-	for (const MenuItem& item : menu.items()) {
-		text_.add(item.getName(), x, y);
+
+	detail_text_.clear();
+	detail_text_.color(0.6f, 0.6f, 0.6f, 1.0f);
+	detail_text_.viewport(viewport);
+	detail_text_.hAlign(TextRenderer::HAlign::center);
+	detail_text_.vAlign(TextRenderer::VAlign::center);
+
+	// items with a series summary show it on a second line
+	for (size_t i = 0; i < menu.items().size(); i++) {
+		const std::string& detail = menu.detail(i);
+		if (detail.empty()) {
+			text_.add(menu.items()[i].getName(), x, y);
+		} else {
+			text_.add(menu.items()[i].getName(), x, y + 14.0f);
+			detail_text_.add(detail, x, y - 22.0f);
+		}
 		y -= item_height_ + vertical_pad_;
 	}
 }
@@ -83,8 +127,12 @@ void ListRenderer::draw()
 	}
 
 	drawBoxes();
+	upload();
+	drawThumbnails();
 	text_.model(model_);
 	text_.draw();
+	detail_text_.model(model_);
+	detail_text_.draw();
 }
 
 void ListRenderer::drawBoxes()
@@ -101,10 +149,125 @@ void ListRenderer::drawBoxes()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glDrawElements(GL_TRIANGLES, index_count_, GL_UNSIGNED_SHORT, 0);
 
-	if (highlighted_ >= 0) {
+	if (highlighted_ >= 0 && highlighted_ * indices_per_item_ < index_count_) {
 		prog_.uniform("color", .2f, 0.3f, .2f, alpha_);
 		GLvoid* offset = (GLvoid*)(indices_per_item_ * highlighted_ * sizeof(GLushort));
 		glDrawElements(GL_TRIANGLES, indices_per_item_, GL_UNSIGNED_SHORT, offset);
 	}
 	glDisable(GL_BLEND);
-}
\ No newline at end of file
+}
+
+void ListRenderer::addThumbnails(const vector<Thumbnailer::Thumbnail>& thumbnails)
+{
+	for (const Thumbnailer::Thumbnail& t : thumbnails) {
+		if (slots_.insert(make_pair(t.directory, -1)).second) {
+			uploads_.push_back(t);
+		}
+	}
+}
+
+void ListRenderer::upload()
+{
+	const int columns = atlas_size_ / Thumbnailer::width;
+	const int capacity = columns * (atlas_size_ / Thumbnailer::height);
+
+	if (uploads_.empty()) {
+		return;
+	}
+
+	atlas_.bind();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int n = 0; n < uploads_per_frame_ && !uploads_.empty(); n++) {
+		const Thumbnailer::Thumbnail& t = uploads_.front();
+
+		int slot;
+		if (static_cast<int>(slot_owners_.size()) < capacity) {
+			slot = static_cast<int>(slot_owners_.size());
+			slot_owners_.push_back(t.directory);
+			slot_uses_.push_back(0);
+		} else {
+			slot = static_cast<int>(min_element(slot_uses_.begin(), slot_uses_.end()) - slot_uses_.begin());
+			slots_.erase(slot_owners_[slot]);
+			slot_owners_[slot] = t.directory;
+		}
+		slots_[t.directory] = slot;
+		slot_uses_[slot] = ++use_clock_;
+
+		int x = (slot % columns) * Thumbnailer::width;
+		int y = (slot / columns) * Thumbnailer::height;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, Thumbnailer::width, Thumbnailer::height, GL_RED, GL_UNSIGNED_BYTE, &t.pixels[0]);
+
+		uploads_.pop_front();
+		thumbs_dirty_ = true;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void ListRenderer::buildThumbnails()
+{
+	const int columns = atlas_size_ / Thumbnailer::width;
+	const float thumb_height = item_height_ - 20.0f;
+	const float thumb_width = thumb_height * Thumbnailer::width / Thumbnailer::height;
+	const float texel = 1.0f / atlas_size_;
+
+	// x, y, s, t for two triangles per thumbnail; atlas row 0 is the top of each thumbnail
+	vector<GLfloat> vertices;
+	float left = horizontal_pad_ + 10.0f;
+	float top = viewport_.height - vertical_pad_ - 10.0f;
+	for (const string& path : item_paths_) {
+		auto slot = slots_.find(path);
+		if (!path.empty() && slot != slots_.end() && slot->second >= 0) {
+			float s0 = (slot->second % columns) * Thumbnailer::width * texel;
+			float t0 = (slot->second / columns) * Thumbnailer::height * texel;
+			float s1 = s0 + Thumbnailer::width * texel;
+			float t1 = t0 + Thumbnailer::height * texel;
+			float right = left + thumb_width;
+			float bottom = top - thumb_height;
+
+			GLfloat quad[] = {
+				left, top, s0, t0,
+				left, bottom, s0, t1,
+				right, bottom, s1, t1,
+				left, top, s0, t0,
+				right, bottom, s1, t1,
+				right, top, s1, t0
+			};
+			vertices.insert(vertices.end(), quad, quad + 24);
+		}
+		top -= item_height_ + vertical_pad_;
+	}
+
+	thumb_vertex_count_ = static_cast<GLsizei>(vertices.size() / 4);
+	if (thumb_vertex_count_ > 0) {
+		thumb_vbo_.bind();
+		thumb_vbo_.data(&vertices[0], vertices.size() * sizeof(GLfloat));
+	}
+	thumbs_dirty_ = false;
+}
+
+void ListRenderer::drawThumbnails()
+{
+	if (thumbs_dirty_) {
+		buildThumbnails();
+	}
+	if (thumb_vertex_count_ == 0) {
+		return;
+	}
+
+	thumb_prog_.enable();
+	thumb_prog_.uniform("modelViewProjection", projection_ * model_);
+	thumb_prog_.uniform("alpha", alpha_);
+	thumb_prog_.uniform("atlas", 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	atlas_.bind();
+	thumb_vbo_.bind();
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(0, 2, GL_FLOAT, false, 4 * sizeof(GLfloat), 0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, false, 4 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDrawArrays(GL_TRIANGLES, 0, thumb_vertex_count_);
+	glDisable(GL_BLEND);
+}
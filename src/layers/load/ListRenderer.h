@@ -3,9 +3,13 @@
 
 #include "layers/Controller.h"
 #include "DirectoryMenu.h"
+#include "Thumbnailer.h"
 #include "gl/Program.h"
 #include "gl/Buffer.h"
+#include "gl/Texture.h"
 #include "util/TextRenderer.h"
+#include <deque>
+#include <map>
 
 class ListRenderer
 {
@@ -22,7 +26,20 @@ public:
 	float verticalPad() const { return vertical_pad_; }
 	float horizontalPad() const { return horizontal_pad_; }
 
+	/** True if the thumbnail of a series directory is in the atlas or waiting to be uploaded */
+	bool hasThumbnail(const std::string& directory) const { return slots_.count(directory) > 0; }
+
+	/** Queues thumbnails for upload; a few are copied into the atlas each frame */
+	void addThumbnails(const std::vector<Thumbnailer::Thumbnail>& thumbnails);
+
+	/** True while thumbnails are waiting to be uploaded */
+	bool uploading() const { return !uploads_.empty(); }
+
 private:
+	// the atlas holds 16 x 32 thumbnails; the least recently listed one is replaced when it's full
+	static const int atlas_size_ = 2048;
+	static const int uploads_per_frame_ = 4;
+
 	gl::Mat4 projection_;
 	gl::Mat4 model_;
 	gl::Program prog_;
@@ -36,9 +53,26 @@ private:
 	GLsizei index_count_;
 	GLsizei indices_per_item_;
 	TextRenderer text_;
+	TextRenderer detail_text_;
 	int highlighted_;
+	gl::Viewport viewport_;
+
+	gl::Program thumb_prog_;
+	gl::Buffer thumb_vbo_;
+	gl::Texture atlas_;
+	std::map<std::string, int> slots_;       // directory -> atlas slot; -1 while queued
+	std::vector<std::string> slot_owners_;
+	std::vector<unsigned> slot_uses_;
+	unsigned use_clock_;
+	std::deque<Thumbnailer::Thumbnail> uploads_;
+	std::vector<std::string> item_paths_;    // series directory of each item; empty if none
+	GLsizei thumb_vertex_count_;
+	bool thumbs_dirty_;
 
 	void drawBoxes();
+	void drawThumbnails();
+	void upload();
+	void buildThumbnails();
 };
 
 #endif // __medleap_ListRenderer__
@@ -8,10 +8,20 @@ using namespace gl;
 using namespace std;
 using namespace Leap;
 
+namespace
+{
+	size_t prefetchBudget()
+	{
+		MainConfig cfg;
+		return static_cast<size_t>(std::max(0, cfg.getValue<int>(MainConfig::PREFETCH_MB, 1024))) << 20;
+	}
+}
+
 LoadController::LoadController() :
+	prefetcher_(prefetchBudget()),
 	changed_dir_(true),
 	scroll_speed_(15.0f),
-	highlighted_(nullptr),
+	highlighted_(-1),
 	transition_(chrono::milliseconds(200)),
 	cd_transition_(chrono::milliseconds(200)),
 	timeout_(5000),
@@ -19,11 +29,13 @@ LoadController::LoadController() :
 {
 	MainConfig cfg;
 	menu.directory(cfg.getValue<string>(MainConfig::WORKING_DIR));
+	source_.type = VolumeLoader::Source::RAW;
 
 	transition_.state(Transition::State::empty);
 	cd_transition_.state(Transition::State::full);
 	poses_.point().enabled(true);
 	menu.onLoad(bind(&LoadController::source, this, std::placeholders::_1));
+	loader.prefetcher(&prefetcher_);
 }
 
 void LoadController::gainFocus()
@@ -62,15 +74,16 @@ void LoadController::updateCursor(float x, float y)
 	cursor_.x = x;
 	cursor_.y = y;
 	if (menu.items().empty()) {
-		highlighted_ = nullptr;
+		highlighted_ = -1;
 	} else {
 		float y_world = viewport_.height - y + y_offset_;
 		float item_step = list_renderer_.itemHeight() + list_renderer_.verticalPad();
 		int i = static_cast<int>(y_world / item_step);
 		i = clamp(i, 0, static_cast<int>(menu.items().size()) - 1);
-		highlighted_ = &menu.getItems()[i];
-		list_renderer_.highlight(i);
+		highlighted_ = i;
 	}
+	list_renderer_.highlight(highlighted_);
+	menu.highlight(highlighted_);
 }
 
 bool LoadController::leapInput(const Leap::Controller& controller, const Leap::Frame& frame)
@@ -118,16 +131,33 @@ void LoadController::upDirectory()
 {
 	cd_direction_ = 1.0f;
 	cd_transition_.state(Transition::State::decrease);
+	thumbnailer_.clear();
 	menu.upDirectory();
+	highlighted_ = -1;
 	changed_dir_ = true;
 }
 
 void LoadController::intoDirectory()
 {
-	if (highlighted_) {
+	if (highlighted_ >= 0 && highlighted_ < static_cast<int>(menu.items().size())) {
 		cd_direction_ = -1.0f;
 		cd_transition_.state(Transition::State::decrease);
-		highlighted_->trigger();
+		int i = highlighted_;
+		highlighted_ = -1;
+
+		// the series next to the chosen one are likely to be opened after it, the following ones first
+		siblings_.clear();
+		for (int j = i + 1; j < static_cast<int>(menu.items().size()); j++) {
+			if (!menu.detail(j).empty())
+				siblings_.push_back(menu.path(j));
+		}
+		for (int j = i - 1; j >= 0; j--) {
+			if (!menu.detail(j).empty())
+				siblings_.push_back(menu.path(j));
+		}
+
+		thumbnailer_.clear();
+		menu.getItems()[i].trigger();
 		changed_dir_ = true;
 	}
 }
@@ -136,6 +166,17 @@ void LoadController::update(chrono::milliseconds elapsed)
 {
 	updateTransition(elapsed);
 
+	// entries stream in while the directory is listed; the list sliding out keeps the old ones
+	if (menu.poll() && cd_transition_.state() != Transition::State::decrease) {
+		list_renderer_.update(menu, viewport_);
+		requestThumbnails();
+	}
+
+	vector<Thumbnailer::Thumbnail> thumbnails;
+	if (thumbnailer_.take(thumbnails)) {
+		list_renderer_.addThumbnails(thumbnails);
+	}
+
 	if (loader.getState() == VolumeLoader::LOADING) {
 		state_renderer_.update(loader, elapsed, viewport_);
 	}
@@ -143,6 +184,17 @@ void LoadController::update(chrono::milliseconds elapsed)
 	if (loader.getState() == VolumeLoader::FINISHED) {
 		MainController::getInstance().setVolume(loader.getVolume());
 		MainController::getInstance().volumeController().markDirty();
+
+		// a time-resolved series can be played back once its phases are found
+		if (source_.type == VolumeLoader::Source::DICOM_DIR) {
+			MainController::getInstance().cineController().open(source_.name);
+		}
+
+		// warm up the siblings only once the chosen series is done so they don't compete with it
+		if (!siblings_.empty()) {
+			prefetcher_.prefetch(siblings_);
+			siblings_.clear();
+		}
 	}
 
 	if (transition_.full()) {
@@ -157,6 +209,21 @@ void LoadController::update(chrono::milliseconds elapsed)
 	}
 }
 
+bool LoadController::animating() const
+{
+	return loader.getState() == VolumeLoader::LOADING || !transition_.idle() || !cd_transition_.idle() || menu.listing() ||
+		thumbnailer_.busy() || list_renderer_.uploading();
+}
+
+void LoadController::requestThumbnails()
+{
+	for (size_t i = 0; i < menu.items().size(); i++) {
+		if (!menu.detail(i).empty() && !list_renderer_.hasThumbnail(menu.path(i))) {
+			thumbnailer_.request(menu.path(i));
+		}
+	}
+}
+
 void LoadController::updateTransition(chrono::milliseconds elapsed)
 {
 	transition_.update(elapsed);
@@ -170,6 +237,7 @@ void LoadController::updateTransition(chrono::milliseconds elapsed)
 	case Transition::State::empty:
 		cd_transition_.state(Transition::State::increase);
 		list_renderer_.update(menu, viewport_);
+		requestThumbnails();
 		y_offset_ = 0.0f;
 		break;
 	case Transition::State::increase:
@@ -183,7 +251,8 @@ void LoadController::updateTransition(chrono::milliseconds elapsed)
 
 void LoadController::draw()
 {
-	if (loader.getState() == VolumeLoader::LOADING) {
+	// the menu stays usable while loading, so a wrong choice can be replaced by picking another item
+	if (transition_.empty() && loader.getState() == VolumeLoader::LOADING) {
 		state_renderer_.draw();
 	} else if (!transition_.empty()) {
 		list_renderer_.draw();
@@ -207,6 +276,10 @@ void LoadController::draw()
 
 void LoadController::source(const VolumeLoader::Source& source)
 {
+	// a prefetched volume is taken first; whatever is still being prefetched is abandoned, as is a
+	// load in progress
+	source_ = source;
 	loader.setSource(source);
+	prefetcher_.cancel();
 	MainController::getInstance().popFocus();
 }
\ No newline at end of file
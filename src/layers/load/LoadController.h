@@ -3,9 +3,11 @@
 
 #include "layers/Controller.h"
 #include "data/VolumeLoader.h"
+#include "data/VolumePrefetcher.h"
 #include "DirectoryMenu.h"
 #include "ListRenderer.h"
 #include "LoadStateRenderer.h"
+#include "Thumbnailer.h"
 #include "leap/PoseTracker.h"
 #include "util/Transition.h"
 
@@ -17,13 +19,16 @@ public:
 	void loseFocus() override;
 	void update(std::chrono::milliseconds elapsed) override;
 	void draw() override;
+	bool animating() const override;
 	void resize() override;
 	bool modal() const override { return true; }
 	bool leapInput(const Leap::Controller& controller, const Leap::Frame& frame) override;
 	void source(const VolumeLoader::Source& source);
 
 private:
+	VolumePrefetcher prefetcher_;
 	VolumeLoader loader;
+	VolumeLoader::Source source_;
 	DirectoryMenu menu;
 	ListRenderer list_renderer_;
 	LoadStateRenderer state_renderer_;
@@ -38,13 +43,16 @@ private:
 	float boundary_height_;
 	float boundary_bottom_;
 	float boundary_top_;
-	MenuItem* highlighted_;
+	int highlighted_;
 	Transition transition_;
 	Transition cd_transition_;
 	float cd_direction_;
 	std::chrono::milliseconds timeout_;
 	std::chrono::milliseconds timer_;
+	Thumbnailer thumbnailer_;
+	std::vector<std::string> siblings_;
 
+	void requestThumbnails();
 	void updateTransition(std::chrono::milliseconds elapsed);
 	void updateCursor(float x, float y);
 	void scroll(float amount);
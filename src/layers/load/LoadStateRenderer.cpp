@@ -1,6 +1,8 @@
 #include "LoadStateRenderer.h"
 #include "util/stb_image.h"
 #include "gl/geom/SegmentRing.h"
+#include <iomanip>
+#include <sstream>
 
 using namespace gl;
 using namespace std;
@@ -48,6 +50,18 @@ void LoadStateRenderer::update(const VolumeLoader& loader, milliseconds elapsed,
 	text_.add(loader.getStateMessage(), viewport.width / 2.0f - 1, viewport.height / 2.0f - 101);
 	text_.color(1.0f, 1.0f, 1.0f, 1.0f);
 	text_.add(loader.getStateMessage(), viewport.width/2.0f, viewport.height/2.0f - 100);
+
+	// slices done in the current phase and how fast they go
+	shared_ptr<const LoadJob> job = loader.job();
+	if (job && job->totalSlices() > 0) {
+		stringstream ss;
+		ss << job->slices() << " / " << job->totalSlices() << " slices, "
+			<< fixed << setprecision(1) << job->throughput() / (1024.0 * 1024.0) << " MB/s";
+		text_.color(0.0f, 0.0f, 0.0f, 1.0f);
+		text_.add(ss.str(), viewport.width / 2.0f - 1, viewport.height / 2.0f - 131);
+		text_.color(0.7f, 0.7f, 0.7f, 1.0f);
+		text_.add(ss.str(), viewport.width / 2.0f, viewport.height / 2.0f - 130);
+	}
 }
 
 void LoadStateRenderer::draw()
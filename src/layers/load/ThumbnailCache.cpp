@@ -0,0 +1,181 @@
+#include "ThumbnailCache.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include "util/dirent.h"
+#include <direct.h>
+#include <sys/utime.h>
+#define DELIM "\\"
+#else
+#include <dirent.h>
+#include <utime.h>
+#define DELIM "/"
+#endif
+
+using namespace std;
+
+namespace
+{
+	const char magic[4] = { 'M', 'L', 'T', 'H' };
+	const uint32_t version = 1;
+	const char* extension = ".thumb";
+
+	void makeDirectory(const string& path)
+	{
+#if defined(_WIN32)
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+
+	void touch(const string& path)
+	{
+#if defined(_WIN32)
+		_utime(path.c_str(), nullptr);
+#else
+		utime(path.c_str(), nullptr);
+#endif
+	}
+}
+
+ThumbnailCache::ThumbnailCache(const string& directory, size_t maxBytes) :
+	directory_(directory),
+	maxBytes_(maxBytes),
+	indexed_(false),
+	totalBytes_(0)
+{
+}
+
+string ThumbnailCache::key(const string& seriesDirectory)
+{
+	struct stat info;
+	int64_t modified = (stat(seriesDirectory.c_str(), &info) == 0) ? static_cast<int64_t>(info.st_mtime) : 0;
+
+	// FNV-1a of the path and modification time
+	stringstream ss;
+	ss << seriesDirectory << '|' << modified;
+	uint64_t h = 14695981039346656037ULL;
+	for (char c : ss.str()) {
+		h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+	}
+
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(h));
+	return name;
+}
+
+string ThumbnailCache::path(const string& key) const
+{
+	return directory_ + DELIM + key + extension;
+}
+
+void ThumbnailCache::index()
+{
+	if (indexed_) {
+		return;
+	}
+	indexed_ = true;
+
+	makeDirectory(directory_);
+	DIR* dir = opendir(directory_.c_str());
+	if (!dir) {
+		return;
+	}
+
+	string ext = extension;
+	for (struct dirent* entry = readdir(dir); entry; entry = readdir(dir)) {
+		string name = entry->d_name;
+		if (name.size() <= ext.size() || name.compare(name.size() - ext.size(), ext.size(), ext) != 0) {
+			continue;
+		}
+
+		struct stat info;
+		if (stat((directory_ + DELIM + name).c_str(), &info) == 0) {
+			File f = { static_cast<size_t>(info.st_size), static_cast<int64_t>(info.st_mtime) };
+			files_[name.substr(0, name.size() - ext.size())] = f;
+			totalBytes_ += f.bytes;
+		}
+	}
+	closedir(dir);
+}
+
+bool ThumbnailCache::load(const string& key, int width, int height, vector<unsigned char>& pixels)
+{
+	lock_guard<mutex> lock(mutex_);
+	index();
+
+	auto it = files_.find(key);
+	if (it == files_.end()) {
+		return false;
+	}
+
+	ifstream in(path(key).c_str(), ios::binary);
+	char m[4];
+	uint32_t v = 0, w = 0, h = 0;
+	in.read(m, 4);
+	in.read(reinterpret_cast<char*>(&v), sizeof(v));
+	in.read(reinterpret_cast<char*>(&w), sizeof(w));
+	in.read(reinterpret_cast<char*>(&h), sizeof(h));
+	if (!in || memcmp(m, magic, 4) != 0 || v != version || w != (uint32_t)width || h != (uint32_t)height) {
+		return false;
+	}
+
+	pixels.resize(width * height);
+	in.read(reinterpret_cast<char*>(&pixels[0]), pixels.size());
+	if (!in) {
+		return false;
+	}
+
+	it->second.lastUse = static_cast<int64_t>(time(nullptr));
+	touch(path(key));
+	return true;
+}
+
+void ThumbnailCache::store(const string& key, int width, int height, const vector<unsigned char>& pixels)
+{
+	lock_guard<mutex> lock(mutex_);
+	index();
+
+	{
+		ofstream out(path(key).c_str(), ios::binary);
+		uint32_t w = width, h = height;
+		out.write(magic, 4);
+		out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+		out.write(reinterpret_cast<const char*>(&w), sizeof(w));
+		out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		out.write(reinterpret_cast<const char*>(&pixels[0]), pixels.size());
+		if (!out) {
+			return;
+		}
+	}
+
+	File& f = files_[key];
+	totalBytes_ -= f.bytes;
+	f.bytes = 16 + pixels.size();
+	f.lastUse = static_cast<int64_t>(time(nullptr));
+	totalBytes_ += f.bytes;
+
+	evict();
+}
+
+void ThumbnailCache::evict()
+{
+	while (totalBytes_ > maxBytes_ && !files_.empty()) {
+		auto oldest = files_.begin();
+		for (auto it = files_.begin(); it != files_.end(); ++it) {
+			if (it->second.lastUse < oldest->second.lastUse) {
+				oldest = it;
+			}
+		}
+
+		remove(path(oldest->first).c_str());
+		totalBytes_ -= oldest->second.bytes;
+		files_.erase(oldest);
+	}
+}
@@ -0,0 +1,49 @@
+#ifndef __medleap_ThumbnailCache__
+#define __medleap_ThumbnailCache__
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Thumbnails kept as files in a cache directory across sessions. Once the files exceed the size
+ * budget, the least recently used ones are deleted; a file's modification time records its last
+ * use. Keys include the series directory's modification time, so a directory whose contents
+ * changed gets a new thumbnail. Safe to use from several threads.
+ */
+class ThumbnailCache
+{
+public:
+	ThumbnailCache(const std::string& directory, size_t maxBytes);
+
+	/** Reads a cached 8-bit thumbnail of the given size. Returns false if there is none. */
+	bool load(const std::string& key, int width, int height, std::vector<unsigned char>& pixels);
+
+	/** Writes a thumbnail, then evicts old ones if the cache is over budget */
+	void store(const std::string& key, int width, int height, const std::vector<unsigned char>& pixels);
+
+	/** Cache key for the series in a directory */
+	static std::string key(const std::string& seriesDirectory);
+
+private:
+	struct File
+	{
+		size_t bytes;
+		int64_t lastUse;
+	};
+
+	std::string directory_;
+	size_t maxBytes_;
+	std::mutex mutex_;
+	bool indexed_;
+	std::map<std::string, File> files_;
+	size_t totalBytes_;
+
+	void index();
+	void evict();
+	std::string path(const std::string& key) const;
+};
+
+#endif // __medleap_ThumbnailCache__
@@ -0,0 +1,275 @@
+#include "Thumbnailer.h"
+#include "DirectoryScanner.h"
+#include "main/MainConfig.h"
+#include "gl/math/Simd.h"
+#include "util/Parallel.h"
+#include "gdcmImageReader.h"
+#include "gdcmIPPSorter.h"
+#include "gdcmScanner.h"
+#include "gdcmTag.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace gdcm;
+
+namespace
+{
+	/** Slices combined into the projection */
+	const int mipSlices = 8;
+
+	const size_t defaultCacheMB = 64;
+
+	string cacheDirectory()
+	{
+		MainConfig cfg;
+		string home = cfg.getValue<string>(MainConfig::WORKING_DIR);
+		return cfg.getValue<string>(MainConfig::THUMBNAIL_CACHE, home + "/.medleap_thumbnails");
+	}
+
+	size_t cacheBytes()
+	{
+		MainConfig cfg;
+		return static_cast<size_t>(max(1, cfg.getValue<int>(MainConfig::THUMBNAIL_CACHE_MB, (int)defaultCacheMB))) << 20;
+	}
+
+	/** dst[i] += src[i] */
+	void accumulate(float* dst, const float* src, size_t n)
+	{
+		size_t i = 0;
+#if defined(GL_MATH_SSE)
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+#elif defined(GL_MATH_NEON)
+		for (; i + 4 <= n; i += 4)
+			vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+#endif
+		for (; i < n; i++)
+			dst[i] += src[i];
+	}
+
+	/** dst[i] = max(dst[i], src[i]) */
+	void maximum(float* dst, const float* src, size_t n)
+	{
+		size_t i = 0;
+#if defined(GL_MATH_SSE)
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_ps(dst + i, _mm_max_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+#elif defined(GL_MATH_NEON)
+		for (; i + 4 <= n; i += 4)
+			vst1q_f32(dst + i, vmaxq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+#endif
+		for (; i < n; i++)
+			dst[i] = std::max(dst[i], src[i]);
+	}
+
+	/**
+	 * Box-filters a w x h image by an integer factor so it fits in a size x size square, centered.
+	 * Whole source rows are summed first (vectorized), then each output pixel sums its columns.
+	 */
+	void downsample(const vector<float>& src, int w, int h, int size, vector<float>& dst, vector<bool>& covered)
+	{
+		int f = max(1, max((w + size - 1) / size, (h + size - 1) / size));
+		int ow = w / f;
+		int oh = h / f;
+		int x0 = (size - ow) / 2;
+		int y0 = (size - oh) / 2;
+		float scale = 1.0f / (f * f);
+
+		dst.assign(size * size, 0.0f);
+		covered.assign(size * size, false);
+		vector<float> rows(w);
+		for (int y = 0; y < oh; y++) {
+			std::fill(rows.begin(), rows.end(), 0.0f);
+			for (int r = 0; r < f; r++) {
+				accumulate(&rows[0], &src[(y * f + r) * w], w);
+			}
+
+			float* out = &dst[(y0 + y) * size + x0];
+			for (int x = 0; x < ow; x++) {
+				float sum = 0.0f;
+				for (int c = 0; c < f; c++)
+					sum += rows[x * f + c];
+				out[x] = sum * scale;
+				covered[(y0 + y) * size + x0 + x] = true;
+			}
+		}
+	}
+
+	/** Decodes one slice into modality values */
+	bool decode(const string& file, int& w, int& h, vector<float>& out)
+	{
+		ImageReader reader;
+		reader.SetFileName(file.c_str());
+		if (!reader.Read()) {
+			return false;
+		}
+
+		const Image& img = reader.GetImage();
+		w = img.GetColumns();
+		h = img.GetRows();
+		vector<char> buffer(img.GetBufferLength());
+		if (buffer.empty() || !img.GetBuffer(&buffer[0])) {
+			return false;
+		}
+
+		size_t n = static_cast<size_t>(w) * h;
+		float slope = static_cast<float>(img.GetSlope());
+		float intercept = static_cast<float>(img.GetIntercept());
+		out.resize(n);
+
+		switch (img.GetPixelFormat()) {
+		case PixelFormat::INT8:
+			for (size_t i = 0; i < n; i++) out[i] = reinterpret_cast<const int8_t*>(&buffer[0])[i] * slope + intercept;
+			break;
+		case PixelFormat::UINT8:
+			for (size_t i = 0; i < n; i++) out[i] = reinterpret_cast<const uint8_t*>(&buffer[0])[i] * slope + intercept;
+			break;
+		case PixelFormat::INT16:
+			for (size_t i = 0; i < n; i++) out[i] = reinterpret_cast<const int16_t*>(&buffer[0])[i] * slope + intercept;
+			break;
+		case PixelFormat::UINT16:
+			for (size_t i = 0; i < n; i++) out[i] = reinterpret_cast<const uint16_t*>(&buffer[0])[i] * slope + intercept;
+			break;
+		default:
+			return false;
+		}
+		return true;
+	}
+
+	/** Maps a downsampled image to 8 bits between its 1st and 99th percentiles */
+	void quantize(const vector<float>& image, const vector<bool>& covered, unsigned char* out, int stride, int size)
+	{
+		vector<float> values;
+		for (size_t i = 0; i < image.size(); i++) {
+			if (covered[i])
+				values.push_back(image[i]);
+		}
+		if (values.empty()) {
+			return;
+		}
+
+		auto lo = values.begin() + values.size() / 100;
+		auto hi = values.begin() + (values.size() * 99) / 100;
+		std::nth_element(values.begin(), lo, values.end());
+		float minValue = *lo;
+		std::nth_element(values.begin(), hi, values.end());
+		float maxValue = *hi;
+		float scale = (maxValue > minValue) ? 255.0f / (maxValue - minValue) : 0.0f;
+
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				size_t i = y * size + x;
+				float v = covered[i] ? (image[i] - minValue) * scale : 0.0f;
+				out[y * stride + x] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, v)));
+			}
+		}
+	}
+}
+
+Thumbnailer::Thumbnailer() :
+	cache_(cacheDirectory(), cacheBytes()),
+	pool_(std::max(1u, std::min(4u, workerCount() / 2)))
+{
+}
+
+void Thumbnailer::request(const string& directory)
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		if (!requested_.insert(directory).second) {
+			return;
+		}
+	}
+
+	pool_.post([this, directory] {
+		Thumbnail t;
+		t.directory = directory;
+
+		string key = ThumbnailCache::key(directory);
+		bool ok = cache_.load(key, width, height, t.pixels);
+		if (!ok && generate(directory, t.pixels)) {
+			cache_.store(key, width, height, t.pixels);
+			ok = true;
+		}
+
+		// failed series stay requested so they aren't retried until the queue is cleared
+		lock_guard<mutex> lock(mutex_);
+		if (ok) {
+			requested_.erase(directory);
+			finished_.push_back(t);
+		}
+	});
+}
+
+void Thumbnailer::clear()
+{
+	lock_guard<mutex> lock(mutex_);
+	pool_.clear();
+	requested_.clear();
+}
+
+bool Thumbnailer::take(vector<Thumbnail>& thumbnails)
+{
+	lock_guard<mutex> lock(mutex_);
+	thumbnails.clear();
+	thumbnails.swap(finished_);
+	return !thumbnails.empty();
+}
+
+bool Thumbnailer::generate(const string& directory, vector<unsigned char>& pixels)
+{
+	vector<string> files = DirectoryScanner::dicomFiles(directory, [] { return false; });
+	if (files.empty()) {
+		return false;
+	}
+
+	// the largest series, sorted along its normal when the positions allow it
+	Tag uid(0x0020, 0x000e);
+	Scanner scanner;
+	scanner.AddTag(uid);
+	scanner.Scan(files);
+	vector<string> series;
+	for (const string& seriesID : scanner.GetOrderedValues(uid)) {
+		vector<string> seriesFiles = scanner.GetAllFilenamesFromTagToValue(uid, seriesID.c_str());
+		if (seriesFiles.size() > series.size())
+			series = seriesFiles;
+	}
+	if (series.empty()) {
+		series = files;
+	}
+
+	IPPSorter sorter;
+	if (series.size() > 1 && sorter.Sort(series)) {
+		series = sorter.GetFilenames();
+	}
+
+	// central slice, then slices spread evenly for the projection
+	int n = static_cast<int>(series.size());
+	int center = n / 2;
+	int w = 0, h = 0;
+	vector<float> slice, mip;
+	if (!decode(series[center], w, h, slice)) {
+		return false;
+	}
+	mip = slice;
+
+	int count = std::min(mipSlices, n);
+	for (int i = 0; i < count; i++) {
+		int index = (count > 1) ? i * (n - 1) / (count - 1) : 0;
+		int sw, sh;
+		vector<float> other;
+		if (index != center && decode(series[index], sw, sh, other) && sw == w && sh == h) {
+			maximum(&mip[0], &other[0], mip.size());
+		}
+	}
+
+	vector<float> small;
+	vector<bool> covered;
+	pixels.assign(width * height, 0);
+	downsample(slice, w, h, size, small, covered);
+	quantize(small, covered, &pixels[0], width, size);
+	downsample(mip, w, h, size, small, covered);
+	quantize(small, covered, &pixels[size], width, size);
+	return true;
+}
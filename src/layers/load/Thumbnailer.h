@@ -0,0 +1,57 @@
+#ifndef __medleap_Thumbnailer__
+#define __medleap_Thumbnailer__
+
+#include "ThumbnailCache.h"
+#include "util/WorkerPool.h"
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Makes thumbnails of the DICOM series in the load menu on a pool of worker threads. A thumbnail
+ * shows the central slice next to a maximum intensity projection of a few slices spread through
+ * the series; only those slices are decoded. Thumbnails are saved in a ThumbnailCache, so each
+ * series is only decoded the first time it is browsed.
+ */
+class Thumbnailer
+{
+public:
+	/** Width and height of each half of a thumbnail */
+	static const int size = 64;
+	static const int width = 2 * size;
+	static const int height = size;
+
+	struct Thumbnail
+	{
+		std::string directory;
+		std::vector<unsigned char> pixels;  // width x height, 8 bits, first row at the top
+	};
+
+	Thumbnailer();
+
+	/** Queues the thumbnail of the series in a directory, unless it is already queued */
+	void request(const std::string& directory);
+
+	/** Drops queued requests */
+	void clear();
+
+	/** Moves finished thumbnails into thumbnails. Returns false if there are none. */
+	bool take(std::vector<Thumbnail>& thumbnails);
+
+	bool busy() const { return pool_.pending() > 0; }
+
+	/** Decodes and downsamples the thumbnail of the largest series in a directory */
+	static bool generate(const std::string& directory, std::vector<unsigned char>& pixels);
+
+private:
+	ThumbnailCache cache_;
+	std::mutex mutex_;
+	std::set<std::string> requested_;
+	std::vector<Thumbnail> finished_;
+
+	// declared last so the workers stop before the members they use are destroyed
+	WorkerPool pool_;
+};
+
+#endif // __medleap_Thumbnailer__
@@ -9,7 +9,7 @@ class BoxMask : public MaskVolume
 {
 public:
 	BoxMask(const gl::Box box);
-	Edit apply(const gl::Box& bounds, const gl::Texture& texture, MaskVolume::Operation operation) const;
+	Edit apply(const gl::Box& bounds, MaskData& mask, MaskVolume::Operation operation) const override;
 	gl::Geometry geometry() const override;
 	void center(const gl::Vec3& center) override;
 	gl::Vec3 center() const override;
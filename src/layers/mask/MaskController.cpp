@@ -2,15 +2,236 @@
 #include "main/MainController.h"
 #include "gl/math/Math.h"
 #include "BoxMask.h"
+#include "SphereMask.h"
 
 using namespace gl;
 using namespace std;
 using namespace Leap;
 
-MaskController::MaskController() : mask_volume_(new BoxMask(Box(0.04f, 0.04f, 0.04f)))
+MaskController::MaskController() : mask_volume_(new BoxMask(Box(0.04f, 0.04f, 0.04f))), editing_(false), stroke_(false), growKeep_(false), growStroke_(false)
 {
 	poses_.v().enabled(true);
 	poses_.palmsFace().enabled(true);
+	poses_.pinch().enabled(true);
+	poses_.pinch().closeFn([&](const Leap::Frame&) { growRegion(false); });
+}
+
+namespace
+{
+	/** Removes every edit from a history and releases the bricks it references */
+	void clearHistory(History<MaskVolume::Edit, 10>& history)
+	{
+		while (history.size() > 0) {
+			history.top() = MaskVolume::Edit();
+			history.pop();
+		}
+	}
+}
+
+void MaskController::setVolume(VolumeData* volume)
+{
+	grower_.discard();
+	clearHistory(edits_);
+	clearHistory(undone_);
+	snapshot_.reset();
+	if (volume) {
+		mask_.resize(volume->getWidth(), volume->getHeight(), volume->getDepth());
+	} else {
+		mask_.resize(0, 0, 0);
+	}
+}
+
+std::shared_ptr<const MaskData> MaskController::snapshot()
+{
+	if (!snapshot_ || snapshot_->version() != mask_.version()) {
+		snapshot_ = std::make_shared<const MaskData>(mask_);
+	}
+	return snapshot_;
+}
+
+void MaskController::undo()
+{
+	grower_.discard();
+	growStroke_ = false;
+	if (edits_.size() > 0) {
+		MaskVolume::Edit edit = edits_.top();
+		edits_.top() = MaskVolume::Edit();
+		edits_.pop();
+		edit.undo(mask_);
+		undone_.push(edit);
+		uploadMask();
+	}
+}
+
+void MaskController::redo()
+{
+	if (undone_.size() > 0) {
+		MaskVolume::Edit edit = undone_.top();
+		undone_.top() = MaskVolume::Edit();
+		undone_.pop();
+		edit.redo(mask_);
+		edits_.push(edit);
+		uploadMask();
+	}
+}
+
+void MaskController::tool(Tool tool)
+{
+	Vec3 center = mask_volume_->center();
+	if (tool == Tool::box) {
+		mask_volume_.reset(new BoxMask(Box(center, 0.04f)));
+	} else {
+		mask_volume_.reset(new SphereMask(Sphere(center, 0.02f)));
+	}
+
+	VolumeController& vc = MainController::getInstance().volumeController();
+	vc.maskGeometry = mask_volume_->geometry();
+	vc.markDirty();
+}
+
+void MaskController::growRegion(bool keep)
+{
+	VolumeData* volume = MainController::getInstance().volumeData();
+	if (!volume) {
+		return;
+	}
+
+	MainController::getInstance().leapStateController().increaseBrightness(LeapStateController::icon_pinch);
+	VolumeController& vc = MainController::getInstance().volumeController();
+
+	// seed voxel under the 3D cursor
+	const Box& bounds = volume->getBounds();
+	Vec3 n = bounds.normalize(bounds.clamp(vc.maskCenter));
+	Vec3i seed(std::min(static_cast<int>(n.x * volume->getWidth()), (int)volume->getWidth() - 1),
+		std::min(static_cast<int>(n.y * volume->getHeight()), (int)volume->getHeight() - 1),
+		std::min(static_cast<int>(n.z * volume->getDepth()), (int)volume->getDepth() - 1));
+
+	// accept values within 10% of the data range around the seed value and gradients below
+	// a quarter of the largest gradient, which stops the fill at tissue boundaries
+	int value = 0;
+	size_t i = ((size_t)seed.z * volume->getHeight() + seed.y) * volume->getWidth() + seed.x;
+	switch (volume->getType())
+	{
+	case GL_BYTE: value = reinterpret_cast<GLbyte*>(volume->getData())[i]; break;
+	case GL_UNSIGNED_BYTE: value = reinterpret_cast<GLubyte*>(volume->getData())[i]; break;
+	case GL_SHORT: value = reinterpret_cast<GLshort*>(volume->getData())[i]; break;
+	case GL_UNSIGNED_SHORT: value = reinterpret_cast<GLushort*>(volume->getData())[i]; break;
+	}
+	int tolerance = std::max(1, (volume->getMaxValue() - volume->getMinValue()) / 10);
+	RegionGrower::Params params;
+	params.lower = value - tolerance;
+	params.upper = value + tolerance;
+	params.maxGradient = 0.25f * (volume->getMaxGradient() - volume->getMinGradient()).length();
+
+	grower_.cancel();
+	growKeep_ = keep;
+	growStroke_ = false;
+	stroke_ = false;
+
+	// keeping a region starts by removing everything; the region is then cleared as it grows
+	if (keep) {
+		Vec3i size(mask_.width(), mask_.height(), mask_.depth());
+		MaskVolume::Edit edit(MaskVolume::Operation::sub, mask_.fill(Vec3i(0, 0, 0), size, true));
+		edits_.push(std::move(edit));
+		growStroke_ = true;
+		clearHistory(undone_);
+		uploadMask();
+	}
+
+	grower_.start(volume, seed, params);
+}
+
+void MaskController::applyGrownBricks()
+{
+	vector<RegionGrower::BrickBits> bricks;
+	if (!grower_.take(bricks)) {
+		return;
+	}
+
+	MaskVolume::Operation op = growKeep_ ? MaskVolume::Operation::add : MaskVolume::Operation::sub;
+	MaskVolume::Edit edit(op, mask_.combine(bricks, !growKeep_));
+	if (edit.empty()) {
+		return;
+	}
+
+	// one region is a single history entry no matter how many waves it took
+	if (growStroke_ && edits_.size() > 0) {
+		edits_.top().merge(std::move(edit));
+	} else {
+		edits_.push(std::move(edit));
+	}
+	growStroke_ = true;
+	clearHistory(undone_);
+	uploadMask();
+}
+
+void MaskController::update(std::chrono::milliseconds elapsed)
+{
+	applyGrownBricks();
+}
+
+void MaskController::uploadMask()
+{
+	VolumeController& vc = MainController::getInstance().volumeController();
+	mask_.upload(vc.maskTexture);
+	vc.markDirty();
+}
+
+bool MaskController::keyboardInput(GLFWwindow* window, int key, int action, int mods)
+{
+	if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
+		undo();
+		return false;
+	}
+
+	if (key == GLFW_KEY_Y && action == GLFW_PRESS) {
+		redo();
+		return false;
+	}
+
+	return true;
+}
+
+std::unique_ptr<Menu> MaskController::contextMenu()
+{
+	Menu* menu = new Menu("Mask");
+	MenuItem& mi_undo = menu->createItem("Undo");
+	mi_undo.setAction([&]{
+		undo();
+		MainController::getInstance().menuController().hideMenu();
+	});
+
+	MenuItem& mi_redo = menu->createItem("Redo");
+	mi_redo.setAction([&]{
+		redo();
+		MainController::getInstance().menuController().hideMenu();
+	});
+
+	MenuItem& mi_remove = menu->createItem("Remove Region");
+	mi_remove.setAction([&]{
+		growRegion(false);
+		MainController::getInstance().menuController().hideMenu();
+	});
+
+	MenuItem& mi_keep = menu->createItem("Keep Region");
+	mi_keep.setAction([&]{
+		growRegion(true);
+		MainController::getInstance().menuController().hideMenu();
+	});
+
+	MenuItem& mi_box = menu->createItem("Box Tool");
+	mi_box.setAction([&]{
+		tool(Tool::box);
+		MainController::getInstance().menuController().hideMenu();
+	});
+
+	MenuItem& mi_sphere = menu->createItem("Sphere Tool");
+	mi_sphere.setAction([&]{
+		tool(Tool::sphere);
+		MainController::getInstance().menuController().hideMenu();
+	});
+
+	return std::unique_ptr<Menu>(menu);
 }
 
 bool MaskController::modal() const
@@ -34,10 +255,15 @@ void MaskController::gainFocus()
 	lsc.add(LeapStateController::icon_l_open, "Center");
     lsc.add(LeapStateController::icon_v_open, "Mask");
     lsc.add(LeapStateController::icon_palms_face, "Scale");
+    lsc.add(LeapStateController::icon_pinch, "Remove Region");
 }
 
 void MaskController::loseFocus()
 {
+	// finish the mask with whatever region has grown so far
+	grower_.cancel();
+	applyGrownBricks();
+
 //	VolumeController& vc = MainController::getInstance().volumeController();
 //	vc.draw_bounds = false;
 //	vc.draw_cursor3D = false;
@@ -57,6 +283,8 @@ bool MaskController::leapInput(const Leap::Controller& controller, const Leap::F
 			moveCursor();
 			if (poses_.v().isClosed()) {
 				applyEdit();
+			} else {
+				stroke_ = false;
 			}
 
 			vc.maskGeometry = mask_volume_->geometry();
@@ -101,9 +329,20 @@ void MaskController::applyEdit()
 
 	vc.maskColor = { 1.0f, 0.0f, 0.0f };
 
+	grower_.discard();
+	growStroke_ = false;
+
 	const Box& bounds = MainController::getInstance().volumeData()->getBounds();
-	MaskVolume::Edit edit = mask_volume_->apply(bounds, vc.maskTexture, MaskVolume::Operation::sub);
+	MaskVolume::Edit edit = mask_volume_->apply(bounds, mask_, MaskVolume::Operation::sub);
 	if (!edit.empty()) {
-		edits_.push(std::move(edit));
+		// every edit made while the V pose stays closed is undone as a single stroke
+		if (stroke_ && edits_.size() > 0) {
+			edits_.top().merge(std::move(edit));
+		} else {
+			edits_.push(std::move(edit));
+		}
+		stroke_ = true;
+		clearHistory(undone_);
+		uploadMask();
 	}
 }
\ No newline at end of file
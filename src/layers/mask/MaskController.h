@@ -8,6 +8,9 @@
 #include "util/History.h"
 #include "leap/PoseTracker.h"
 #include "layers/volume/LeapCameraControl.h"
+#include "data/MaskData.h"
+#include "data/RegionGrower.h"
+#include "data/VolumeData.h"
 
 class MaskController : public Controller
 {
@@ -18,16 +21,54 @@ public:
 	void loseFocus() override;
 	bool modal() const override;
 	bool leapInput(const Leap::Controller& controller, const Leap::Frame& frame) override;
+	bool keyboardInput(GLFWwindow* window, int key, int action, int mods) override;
+	void update(std::chrono::milliseconds elapsed) override;
+	bool animating() const override { return grower_.running(); }
+	std::unique_ptr<Menu> contextMenu() override;
+
+	/** Clears the mask and all edits; the mask texture is recreated with the new volume */
+	void setVolume(VolumeData* volume);
+
+	/** Immutable copy of the current mask that can be read from other threads */
+	std::shared_ptr<const MaskData> snapshot();
+
+	void undo();
+	void redo();
+
+	/** Shapes used to carve the volume */
+	enum class Tool
+	{
+		box,
+		sphere
+	};
+
+	/** Switches the carving shape, keeping its current position */
+	void tool(Tool tool);
+
+	/**
+	 * Grows a region from the 3D cursor over voxels with similar intensity and low gradient.
+	 * If keep is false the region is removed; otherwise everything except the region is removed.
+	 */
+	void growRegion(bool keep);
 
 private:
 	PoseTracker poses_;
 	LeapCameraControl cam_control_;
 	std::unique_ptr<MaskVolume> mask_volume_;
+	MaskData mask_;
+	std::shared_ptr<const MaskData> snapshot_;
 	History<MaskVolume::Edit, 10> edits_;
+	History<MaskVolume::Edit, 10> undone_;
 	bool editing_;
+	bool stroke_;
+	RegionGrower grower_;
+	bool growKeep_;
+	bool growStroke_;
 
 	void moveCursor();
 	void applyEdit();
+	void uploadMask();
+	void applyGrownBricks();
 };
 
 #endif // __medleap_MaskController__
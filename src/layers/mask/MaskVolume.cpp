@@ -1,61 +1,70 @@
 #include "MaskVolume.h"
 #include "main/MainController.h"
+#include <unordered_map>
 
 using namespace gl;
 using namespace std;
 
-MaskVolume::Edit::Edit() {}
+MaskVolume::Edit::Edit() : operation_(Operation::sub) {}
 
-MaskVolume::Edit::Edit(MaskVolume::Operation operation, std::vector<gl::Vec3i>& voxels) :
+MaskVolume::Edit::Edit(MaskVolume::Operation operation, std::vector<MaskData::BrickDelta>&& deltas) :
 operation_(operation),
-voxels_(std::move(voxels)) {}
+deltas_(std::move(deltas)) {}
 
 MaskVolume::Edit::Edit(Edit&& edit)
 {
 	operation_ = edit.operation_;
-	std::swap(voxels_, edit.voxels_);
+	std::swap(deltas_, edit.deltas_);
 }
 
 MaskVolume::Edit& MaskVolume::Edit::operator=(Edit&& edit)
 {
     operation_ = edit.operation_;
-	std::swap(voxels_, edit.voxels_);
+	std::swap(deltas_, edit.deltas_);
     return *this;
 }
 
 MaskVolume::Edit::Edit(const Edit& edit)
 {
     operation_ = edit.operation_;
-    voxels_ = edit.voxels_;
+    deltas_ = edit.deltas_;
 }
 
 MaskVolume::Edit& MaskVolume::Edit::operator=(const Edit& edit)
 {
     operation_ = edit.operation_;
-    voxels_ = edit.voxels_;
+    deltas_ = edit.deltas_;
     return *this;
 }
 
-void MaskVolume::Edit::redo(Texture& texture)
+void MaskVolume::Edit::merge(Edit&& edit)
 {
-	switch (operation_)
-	{
-	case MaskVolume::Operation::sub:
-		break;
-	case MaskVolume::Operation::add:
-		break;
+	// a brick changed by both edits keeps its original 'before' state
+	std::unordered_map<unsigned, size_t> positions;
+	for (size_t i = 0; i < deltas_.size(); i++) {
+		positions[deltas_[i].index] = i;
 	}
+
+	for (MaskData::BrickDelta& delta : edit.deltas_) {
+		auto it = positions.find(delta.index);
+		if (it != positions.end()) {
+			deltas_[it->second].after = delta.after;
+		} else {
+			positions[delta.index] = deltas_.size();
+			deltas_.push_back(delta);
+		}
+	}
+	edit.deltas_.clear();
 }
 
-void MaskVolume::Edit::undo(Texture& texture)
+void MaskVolume::Edit::redo(MaskData& mask)
 {
-	switch (operation_)
-	{
-	case MaskVolume::Operation::sub:
-		break;
-	case MaskVolume::Operation::add:
-		break;
-	}
+	mask.apply(deltas_, false);
+}
+
+void MaskVolume::Edit::undo(MaskData& mask)
+{
+	mask.apply(deltas_, true);
 }
 
 MaskVolume::~MaskVolume() {}
@@ -4,6 +4,7 @@
 #include "gl/math/Math.h"
 #include "gl/util/Geometry.h"
 #include "gl/geom/Box.h"
+#include "data/MaskData.h"
 
 /** 3D space that can be subtracted/added with a volume */
 class MaskVolume
@@ -15,27 +16,33 @@ public:
 		add
 	};
 
+	/** Change to the mask stored as the bricks it modified; undo and redo swap brick pointers */
 	class Edit
 	{
 	public:
 		Edit();
-		Edit(Operation operation, std::vector<gl::Vec3i>& voxels);
+		Edit(Operation operation, std::vector<MaskData::BrickDelta>&& deltas);
 		Edit(Edit&& edit);
         Edit& operator=(Edit&&);
         Edit(const Edit&);
         Edit& operator=(const Edit&);
 
-		bool empty() { return voxels_.empty(); }
-		void redo(gl::Texture& texture);
-		void undo(gl::Texture& texture);
+		bool empty() { return deltas_.empty(); }
+		Operation operation() const { return operation_; }
+
+		/** Combines a later edit into this one so both are undone together */
+		void merge(Edit&& edit);
+
+		void redo(MaskData& mask);
+		void undo(MaskData& mask);
 
 	private:
 		Operation operation_;
-		std::vector<gl::Vec3i> voxels_;
+		std::vector<MaskData::BrickDelta> deltas_;
 	};
 
 	virtual ~MaskVolume();
-	virtual Edit apply(const gl::Box& bounds, const gl::Texture& texture, Operation operation) const = 0;
+	virtual Edit apply(const gl::Box& bounds, MaskData& mask, Operation operation) const = 0;
 	virtual gl::Geometry geometry() const = 0;
 	virtual void center(const gl::Vec3& center) = 0;
 	virtual gl::Vec3 center() const = 0;
@@ -1,4 +1,5 @@
 #include "SphereMask.h"
+#include <cmath>
 
 using namespace gl;
 using namespace std;
@@ -12,6 +13,11 @@ void SphereMask::center(const Vec3& center)
 	sphere_.center(center);
 }
 
+void SphereMask::scale(float scale)
+{
+	sphere_.radius(sphere_.radius() * scale);
+}
+
 Vec3 SphereMask::center() const
 {
 	return sphere_.center();
@@ -19,13 +25,44 @@ Vec3 SphereMask::center() const
 
 Geometry SphereMask::geometry() const
 {
-	return sphere_.triangles(8);
+	// the mask cursor is drawn with GL_LINES, so convert each triangle into its edges
+	Geometry g = sphere_.triangles(8);
+	vector<int> lines;
+	for (size_t i = 0; i + 2 < g.indices.size(); i += 3) {
+		int a = g.indices[i];
+		int b = g.indices[i + 1];
+		int c = g.indices[i + 2];
+		lines.insert(lines.end(), { a, b, b, c, c, a });
+	}
+	g.indices = lines;
+	g.mode = GL_LINES;
+	return g;
 }
 
-MaskVolume::Edit SphereMask::apply(const Box& bounds, const Texture& texture, Operation operation) const
+MaskVolume::Edit SphereMask::apply(const Box& bounds, MaskData& mask, Operation operation) const
 {
-	vector<Vec3i> voxels;
+	// voxel centers in world space: origin + index * step
+	Vec3 step = bounds.size() / Vec3((float)mask.width(), (float)mask.height(), (float)mask.depth());
+	Vec3 origin = bounds.min() + step * 0.5f;
+	Vec3 c = (sphere_.center() - origin) / step;
+	Vec3 r = Vec3(sphere_.radius()) / step;
+
+	Vec3i min(static_cast<int>(std::floor(c.x - r.x)), static_cast<int>(std::floor(c.y - r.y)), static_cast<int>(std::floor(c.z - r.z)));
+	Vec3i max(static_cast<int>(std::ceil(c.x + r.x)) + 1, static_cast<int>(std::ceil(c.y + r.y)) + 1, static_cast<int>(std::ceil(c.z + r.z)) + 1);
 
+	float radius2 = sphere_.radius() * sphere_.radius();
+	auto span = [&](int y, int z, int& x0, int& x1) {
+		float dy = (y - c.y) * step.y;
+		float dz = (z - c.z) * step.z;
+		float remaining = radius2 - dy * dy - dz * dz;
+		if (remaining < 0.0f) {
+			return false;
+		}
+		float half = std::sqrt(remaining) / step.x;
+		x0 = static_cast<int>(std::ceil(c.x - half));
+		x1 = static_cast<int>(std::floor(c.x + half)) + 1;
+		return x0 < x1;
+	};
 
-	return{ operation, voxels };
+	return{ operation, mask.rasterize(min, max, operation == Operation::sub, span) };
 }
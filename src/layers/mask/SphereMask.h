@@ -9,11 +9,11 @@ class SphereMask : public MaskVolume
 {
 public:
 	SphereMask(const gl::Sphere sphere);
-	Edit apply(const gl::Box& bounds, const gl::Texture& texture, Operation operation) const;
+	Edit apply(const gl::Box& bounds, MaskData& mask, Operation operation) const override;
 	gl::Geometry geometry() const override;
 	void center(const gl::Vec3& center) override;
 	gl::Vec3 center() const override;
-	void scale(float scale) override {}
+	void scale(float scale) override;
 
 private:
 	gl::Sphere sphere_;
@@ -46,6 +46,13 @@ MainMenu::MainMenu() : Menu("Main Menu")
 		mc.menuController().hideMenu();
 	});
 
+	MenuItem& mi_cine = createItem("Cine");
+	mi_cine.setAction([]{
+		MainController& mc = MainController::getInstance();
+		mc.focusLayer(&mc.cineController());
+		mc.menuController().hideMenu();
+	});
+
 	MenuItem& mi_load = createItem("Load");
 	mi_load.setAction([]{
 		MainController& mc = MainController::getInstance();
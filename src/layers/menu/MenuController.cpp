@@ -252,7 +252,7 @@ void MenuController::draw()
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		menuShader.enable();
-		glUniformMatrix4fv(menuShader.getUniform("modelViewProjection"), 1, false, modelViewProjection * gl::scale(transition_.progress()));
+		menuShader.uniform("modelViewProjection", modelViewProjection * gl::scale(transition_.progress()));
 		menuVBO.bind();
 		menuIBO.bind();
 		setShaderState();
@@ -276,12 +276,12 @@ void MenuController::draw()
 		for (int i = 0; i < menu_->getItems().size(); i++) {
 
 			if (i == selected_) {
-				glUniformMatrix4fv(menuShader.getUniform("modelViewProjection"), 1, false, modelViewProjection * gl::scale(transition_.progress() + (0.2f * progress_)));
+				menuShader.uniform("modelViewProjection", modelViewProjection * gl::scale(transition_.progress() + (0.2f * progress_)));
 				Vec3 c = gl::lerp(menuC, Vec3(0.5f, 0.9f, 0.5f), progress_);
-				glUniform4f(menuShader.getUniform("color"), c.x, c.y, c.z, transition_.progress());
+				menuShader.uniform("color", c.x, c.y, c.z, transition_.progress());
 			} else {
-				glUniformMatrix4fv(menuShader.getUniform("modelViewProjection"), 1, false, modelViewProjection * gl::scale(transition_.progress()));
-				glUniform4f(menuShader.getUniform("color"), menuC.x, menuC.y, menuC.z, transition_.progress());
+				menuShader.uniform("modelViewProjection", modelViewProjection * gl::scale(transition_.progress()));
+				menuShader.uniform("color", menuC.x, menuC.y, menuC.z, transition_.progress());
 			}
 
 			void* offset = (void*)(indicesPerMenuItem * i * sizeof(GLuint));
@@ -316,6 +316,7 @@ void MenuController::draw()
 			d.circle(c.x, c.y, 40.0f, 32);
 			d.end();
 			d.draw();
+			Draw::flush();
 
 			text_.clear();
 			text_.hAlign(TextRenderer::HAlign::center);
@@ -22,6 +22,7 @@ public:
 	bool mouseMotion(GLFWwindow* window, double x, double y) override;
 	bool leapInput(const Leap::Controller& leapController, const Leap::Frame& currentFrame) override;
 	void update(std::chrono::milliseconds elapsed) override;
+	bool animating() const override { return !transition_.idle(); }
 	void loseFocus() override;
 	void hideMenu();
 	void showMainMenu();
@@ -0,0 +1,127 @@
+#include "ProfilerController.h"
+#include "main/MainController.h"
+#include "util/LatencyTracker.h"
+#include "util/Profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace gl;
+using namespace std;
+
+ProfilerController::ProfilerController()
+{
+	text_.loadFont("menlo14");
+}
+
+void ProfilerController::draw()
+{
+	vector<Profiler::Summary> summary = Profiler::getInstance().summary();
+
+	text_.clear();
+	text_.viewport(viewport_);
+	text_.color(MainController::getInstance().getRenderer().getInverseBGColor());
+	text_.hAlign(TextRenderer::HAlign::right);
+	text_.vAlign(TextRenderer::VAlign::top);
+
+	// start below the orientation cube in the top right corner
+	float x = viewport_.width - 10.0f;
+	float y = viewport_.height - std::min(viewport_.width, viewport_.height) * 0.15f - 10.0f;
+
+	ostringstream os;
+	os << fixed << setprecision(2);
+	os << setw(28) << "scope" << setw(10) << "cpu ms" << setw(10) << "gpu ms";
+	text_.add(os.str(), x, y);
+	y -= text_.fontHeight();
+
+	for (const Profiler::Summary& s : summary) {
+		os.str("");
+		os << setw(28) << s.name << setw(10) << s.cpuMs;
+		if (s.gpuMs >= 0.0)
+			os << setw(10) << s.gpuMs;
+		else
+			os << setw(10) << "-";
+		text_.add(os.str(), x, y);
+		y -= text_.fontHeight();
+	}
+
+	// GL calls of the last frame; without the program caches every lookup and skipped call would reach the driver
+	const Program::Counters& calls = Program::frameCounters();
+	y -= text_.fontHeight();
+	os.str("");
+	os << "glUniform: " << calls.uniformCalls << " (" << calls.skippedUniforms << " skipped)  location queries: "
+		<< calls.locationQueries << " (" << calls.cachedLookups << " cached)";
+	text_.add(os.str(), x, y);
+	y -= text_.fontHeight();
+	os.str("");
+	os << "driver calls per frame: " << calls.uniformCalls + calls.locationQueries << " (uncached "
+		<< calls.uniformCalls + calls.skippedUniforms + calls.locationQueries + calls.cachedLookups << ")";
+	text_.add(os.str(), x, y);
+	y -= text_.fontHeight();
+
+	// latency of Leap frames from capture to the end of each stage
+	LatencyTracker& latency = LatencyTracker::getInstance();
+	y -= text_.fontHeight();
+	os.str("");
+	os << setw(20) << "leap latency ms" << setw(8) << "p50" << setw(8) << "p95" << setw(8) << "p99" << setw(8) << "max" << setw(6) << "n";
+	text_.add(os.str(), x, y);
+	y -= text_.fontHeight();
+
+	for (int i = 0; i < LatencyTracker::NUM_OF_STAGES; i++) {
+		LatencyTracker::Stage stage = static_cast<LatencyTracker::Stage>(i);
+		LatencyTracker::Stats stats = latency.stats(stage);
+		os.str("");
+		os << setw(20) << LatencyTracker::name(stage) << setw(8) << stats.p50 << setw(8) << stats.p95
+			<< setw(8) << stats.p99 << setw(8) << stats.max << setw(6) << stats.count;
+		text_.add(os.str(), x, y);
+		y -= text_.fontHeight();
+	}
+
+	float histogramWidth = LatencyTracker::numBuckets * 4.0f;
+	float histogramHeight = 60.0f;
+	float histogramY = y - histogramHeight - 5.0f;
+	os.str("");
+	os << "capture to swap, 0-" << static_cast<int>(LatencyTracker::numBuckets * LatencyTracker::bucketMs) << " ms";
+	text_.add(os.str(), x, histogramY - 5.0f);
+
+	text_.draw();
+
+	drawHistogram(x - histogramWidth, histogramY, histogramWidth, histogramHeight);
+}
+
+void ProfilerController::drawHistogram(float x, float y, float width, float height)
+{
+	vector<unsigned> buckets = LatencyTracker::getInstance().histogram();
+	unsigned maxCount = *std::max_element(buckets.begin(), buckets.end());
+	if (maxCount == 0) {
+		return;
+	}
+
+	Draw& d = MainController::getInstance().draw();
+	Vec3 c = MainController::getInstance().getRenderer().getInverseBGColor();
+	d.setModelViewProj(ortho2D(0, viewport_.width, 0, viewport_.height));
+
+	// one bar per bucket of the capture-to-swap latency, with a baseline below
+	float barWidth = width / buckets.size();
+	d.begin(GL_TRIANGLES);
+	d.color(c.x, c.y, c.z);
+	for (size_t i = 0; i < buckets.size(); i++) {
+		float x0 = x + i * barWidth;
+		float x1 = x0 + barWidth * 0.8f;
+		float y1 = y + height * buckets[i] / maxCount;
+		d.vertex(x0, y);
+		d.vertex(x1, y);
+		d.vertex(x1, y1);
+		d.vertex(x0, y);
+		d.vertex(x1, y1);
+		d.vertex(x0, y1);
+	}
+	d.vertex(x, y - 2.0f);
+	d.vertex(x + width, y - 2.0f);
+	d.vertex(x + width, y - 1.0f);
+	d.vertex(x, y - 2.0f);
+	d.vertex(x + width, y - 1.0f);
+	d.vertex(x, y - 1.0f);
+	d.end();
+	d.draw();
+}
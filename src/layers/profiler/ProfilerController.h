@@ -0,0 +1,20 @@
+#ifndef __medleap__ProfilerController__
+#define __medleap__ProfilerController__
+
+#include "layers/Controller.h"
+#include "util/TextRenderer.h"
+
+/** Overlay with smoothed CPU/GPU timings of every profiled scope and the Leap input latency */
+class ProfilerController : public Controller
+{
+public:
+	ProfilerController();
+	void draw() override;
+
+private:
+	TextRenderer text_;
+
+	void drawHistogram(float x, float y, float width, float height);
+};
+
+#endif // __medleap__ProfilerController__
@@ -1,21 +1,41 @@
 #include "SliceController.h"
 #include "main/MainController.h"
+#include "main/MainConfig.h"
+#include <climits>
+#include <cstdlib>
 
 using namespace gl;
 using namespace Leap;
 using namespace std::chrono;
 
 SliceController::SliceController() :
+	volume(NULL),
+	slabEnabled_(false),
+	slabMode_(SlabProjector::MIP),
+	scrollDirection_(1),
+	currentSlice_(0),
 	leap_scroll_dst_(5.0f)
 {
     mouseLeftDrag = false;
 
+	MainConfig cfg;
+	slabThickness_ = cfg.getValue<float>(MainConfig::SLAB_THICKNESS, 10.0f);
+
 	sliceShader = Program::create("shaders/slice_clut.vert", "shaders/slice_clut.frag");
 	sliceShader.enable();
-	glUniform1i(sliceShader.getUniform("tex_slice"), 0);
-	glUniform1i(sliceShader.getUniform("tex_clut"), 1);
+	sliceShader.uniform("tex_slice", 0);
+	sliceShader.uniform("tex_clut", 1);
+
+	volumeShader = Program::create("shaders/slice_clut.vert", "shaders/slice_volume.frag");
+	volumeShader.enable();
+	volumeShader.uniform("tex_volume", 0);
+	volumeShader.uniform("tex_clut", 1);
 
-	sliceTexture.generate(GL_TEXTURE_2D);
+	sliceRing_.resize(ringSize);
+	for (Texture& texture : sliceRing_) {
+		texture.generate(GL_TEXTURE_2D);
+	}
+	ringSlices_.assign(ringSize, -1);
 
 	// geometry is simply a textured quad
 	// uniform matrix will scale to correct aspect ratio
@@ -48,30 +68,111 @@ void SliceController::gainFocus()
 	lsc.clear();
 	lsc.add(LeapStateController::icon_point_circle, "Main Menu");
 	lsc.add(LeapStateController::icon_l_open, "Scroll");
+
+	// oblique planes follow the 3D camera, which may have moved since they were computed
+	if (volume && reformat_.orientation() == Reformatter::OBLIQUE)
+		orientation(Reformatter::OBLIQUE);
+}
+
+void SliceController::orientation(Reformatter::Orientation orientation)
+{
+	// keep the same relative position in the new stack
+	float position = (currentSlice_ + 0.5f) / reformat_.numSlices();
+
+	reformat_.setOrientation(volume, orientation, MainController::getInstance().volumeController().getCamera());
+	currentSlice_ = std::min(reformat_.numSlices() - 1, (int)(position * reformat_.numSlices()));
+	ringSlices_.assign(ringSize, -1);
+	slab_.clear();
+	resize();
+}
+
+void SliceController::slab(bool enabled, SlabProjector::Mode mode)
+{
+	slabEnabled_ = enabled;
+	slabMode_ = mode;
+	ringSlices_.assign(ringSize, -1);
+}
+
+void SliceController::slabThickness(float millimeters)
+{
+	slabThickness_ = std::max(1.0f, millimeters);
+	if (slabEnabled_)
+		ringSlices_.assign(ringSize, -1);
+}
+
+int SliceController::slabSlices() const
+{
+	// world units are normalized so the volume diagonal is one unit long
+	float spacing = reformat_.sliceSpacing() * volume->getSizeMillimeters().length();
+	return std::max(1, (int)std::floor(slabThickness_ / spacing + 0.5f));
+}
+
+std::unique_ptr<Menu> SliceController::contextMenu()
+{
+	Menu* menu = new Menu("Slice Plane");
+
+	for (int i = 0; i < Reformatter::NUM_OF_ORIENTATIONS; i++) {
+		Reformatter::Orientation o = static_cast<Reformatter::Orientation>(i);
+		MenuItem& item = menu->createItem(Reformatter::name(o));
+		item.setAction([this, o]{
+			orientation(o);
+			MainController::getInstance().menuController().hideMenu();
+		});
+	}
+
+	for (int i = 0; i < SlabProjector::NUM_OF_MODES; i++) {
+		SlabProjector::Mode m = static_cast<SlabProjector::Mode>(i);
+		MenuItem& item = menu->createItem(std::string("Slab ") + SlabProjector::name(m));
+		item.setAction([this, m]{
+			slab(true, m);
+			MainController::getInstance().menuController().hideMenu();
+		});
+	}
+
+	MenuItem& single = menu->createItem("Single Plane");
+	single.setAction([&]{
+		slab(false, slabMode_);
+		MainController::getInstance().menuController().hideMenu();
+	});
+
+	return std::unique_ptr<Menu>(menu);
 }
 
 void SliceController::slice(int index)
 {
+	int count = reformat_.numSlices();
 	if (index < 0) {
-		index = volume->getDepth() - 1 - (-index - 1) % volume->getDepth();
+		index = count - 1 - (-index - 1) % count;
 	} else {
-		index = index % volume->getDepth();
+		index = index % count;
 	}
 
+	if (index != currentSlice_) {
+		scrollDirection_ = (index > currentSlice_) ? 1 : -1;
+	}
 	currentSlice_ = index;
-	updateTexture();
 }
 
 bool SliceController::keyboardInput(GLFWwindow* window, int key, int action, int mods)
 {
     if (key == GLFW_KEY_UP && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-		if (++currentSlice_ == volume->getDepth())
-			currentSlice_ = 0;
-		updateTexture();
+		slice(currentSlice_ + 1);
     } else if (key == GLFW_KEY_DOWN && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-		if (--currentSlice_ < 0)
-			currentSlice_ = volume->getDepth() - 1;
-		updateTexture();
+		slice(currentSlice_ - 1);
+    } else if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+		orientation(static_cast<Reformatter::Orientation>((reformat_.orientation() + 1) % Reformatter::NUM_OF_ORIENTATIONS));
+    } else if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+		// cycle single plane -> MIP -> MinIP -> mean -> single plane
+		if (!slabEnabled_)
+			slab(true, SlabProjector::MIP);
+		else if (slabMode_ + 1 < SlabProjector::NUM_OF_MODES)
+			slab(true, static_cast<SlabProjector::Mode>(slabMode_ + 1));
+		else
+			slab(false, SlabProjector::MIP);
+    } else if (key == GLFW_KEY_RIGHT_BRACKET && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+		slabThickness(slabThickness_ + 1.0f);
+    } else if (key == GLFW_KEY_LEFT_BRACKET && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+		slabThickness(slabThickness_ - 1.0f);
     }
     
     return true;
@@ -100,14 +201,7 @@ bool SliceController::mouseMotion(GLFWwindow* window, double x, double y)
     // move through slices by dragging left and right
     if (mouseLeftDrag) {
         double dx = x - mouseAnchorX;
-        int slice = static_cast<int>(anchorSliceIndex + dx * 0.1);
-        if (slice < 0)
-            slice = volume->getDepth() - ((-1*slice) % volume->getDepth());
-        else
-            slice = slice % volume->getDepth();
-        
-		currentSlice_ = slice;
-		updateTexture();
+        slice(static_cast<int>(anchorSliceIndex + dx * 0.1));
     }
     
     return true;
@@ -119,11 +213,37 @@ void SliceController::setCLUTTexture(gl::Texture& texture)
 	this->clutTexture = texture;
 }
 
-void SliceController::updateTexture()
+bool SliceController::volumeResident() const
+{
+	return MainController::getInstance().volumeController().volumeTextureResident();
+}
+
+int SliceController::findSlice(int index) const
 {
-	sliceTexture.bind();
-	sliceTexture.setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	sliceTexture.setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	for (int i = 0; i < ringSize; i++) {
+		if (ringSlices_[i] == index)
+			return i;
+	}
+	return -1;
+}
+
+int SliceController::uploadSlice(int index)
+{
+	// replace an unused texture or the one holding the slice farthest from the current slice
+	int slot = 0;
+	int farthest = -1;
+	for (int i = 0; i < ringSize; i++) {
+		int distance = (ringSlices_[i] < 0) ? INT_MAX : std::abs(ringSlices_[i] - currentSlice_);
+		if (distance > farthest) {
+			farthest = distance;
+			slot = i;
+		}
+	}
+
+	Texture& texture = sliceRing_[slot];
+	texture.bind();
+	texture.setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	texture.setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
 	GLenum internalFormat;
@@ -135,21 +255,53 @@ void SliceController::updateTexture()
 	default: internalFormat = GL_RED; break;
 	}
 
-	sliceTexture.setData2D(0,
+	const void* data;
+	if (slabEnabled_) {
+		int thickness = slabSlices();
+		slab_.configure(slabMode_, thickness, reformat_.numSlices(), (size_t)sliceWidth() * sliceHeight(), volume->getType());
+		slab_.project(index - thickness / 2, [this](int i) { return sliceData(i); }, projected_);
+		data = &projected_[0];
+	} else {
+		data = sliceData(index);
+	}
+
+	texture.setData2D(0,
 		internalFormat,
-		volume->getWidth(),
-		volume->getHeight(),
+		sliceWidth(),
+		sliceHeight(),
 		volume->getFormat(),
 		volume->getType(),
-		volume->getData() + currentSlice_ * volume->getSliceSizeBytes());
+		data);
+
+	ringSlices_[slot] = index;
+	return slot;
+}
+
+const void* SliceController::sliceData(int index)
+{
+	if (reformat_.voxelAligned())
+		return volume->getData() + index * volume->getSliceSizeBytes();
+
+	Reformatter::resample(volume, reformat_.plane((float)index), sliceWidth(), sliceHeight(), resampled_);
+	return &resampled_[0];
+}
+
+int SliceController::sliceWidth() const
+{
+	return reformat_.voxelAligned() ? volume->getWidth() : reformat_.pixelsWide();
+}
+
+int SliceController::sliceHeight() const
+{
+	return reformat_.voxelAligned() ? volume->getHeight() : reformat_.pixelsHigh();
 }
 
 void SliceController::setVolume(VolumeData* volume)
 {
 	this->volume = volume;
 	currentSlice_ = 0;
-	updateTexture();
-	resize();
+	scrollDirection_ = 1;
+	orientation(reformat_.orientation());
 }
 
 void SliceController::resize()
@@ -157,7 +309,7 @@ void SliceController::resize()
 	// model matrix will scale to keep the displayed image in proportion to its
 	// intended dimensions without changing the input vertices in NDC
 	float windowAspect = viewport_.aspect();
-	float sliceAspect = (float)volume->getWidth() / volume->getHeight();
+	float sliceAspect = reformat_.width() / reformat_.height();
 
 	modelMatrix = (sliceAspect <= 1.0f) ?
 		scale(sliceAspect / windowAspect, 1.0f, 1.0f) :
@@ -166,28 +318,45 @@ void SliceController::resize()
 
 void SliceController::draw()
 {
-	sliceShader.enable();
+	bool resident = volumeResident();
+	Program& shader = resident ? volumeShader : sliceShader;
+	shader.enable();
 
 	glActiveTexture(GL_TEXTURE1);
 	clutTexture.bind();
 	glActiveTexture(GL_TEXTURE0);
-	sliceTexture.bind();
+
+	if (resident) {
+		MainController::getInstance().volumeController().getVolumeTexture().bind();
+		Reformatter::Plane plane = reformat_.plane((float)currentSlice_);
+		shader.uniform("plane_origin", plane.origin);
+		shader.uniform("plane_u", plane.u);
+		shader.uniform("plane_v", plane.v);
+		shader.uniform("plane_n", plane.n);
+		shader.uniform("slab_mode", slabEnabled_ ? slabMode_ + 1 : 0);
+		shader.uniform("slab_samples", slabSlices());
+	} else {
+		int slot = findSlice(currentSlice_);
+		if (slot < 0)
+			slot = uploadSlice(currentSlice_);
+		sliceRing_[slot].bind();
+	}
 
 	// set the uniforms
-	glUniform1i(sliceShader.getUniform("signed_normalized"), volume->isSigned());
-	glUniform1f(sliceShader.getUniform("window_min"), volume->visible().left());
-	glUniform1f(sliceShader.getUniform("window_multiplier"), 1.0f / volume->visible().width());
-	glUniformMatrix4fv(sliceShader.getUniform("model"), 1, false, modelMatrix);
+	shader.uniform("signed_normalized", volume->isSigned());
+	shader.uniform("window_min", volume->visible().left());
+	shader.uniform("window_multiplier", 1.0f / volume->visible().width());
+	shader.uniform("model", modelMatrix);
 
 	// set state and shader for drawing medical stuff
 	GLsizei stride = 4 * sizeof(GLfloat);
 	sliceVBO.bind();
 
-	int loc = sliceShader.getAttribute("vs_position");
+	int loc = shader.getAttribute("vs_position");
 	glEnableVertexAttribArray(loc);
 	glVertexAttribPointer(loc, 2, GL_FLOAT, false, stride, 0);
 
-	loc = sliceShader.getAttribute("vs_texcoord");
+	loc = shader.getAttribute("vs_texcoord");
 	glEnableVertexAttribArray(loc);
 	glVertexAttribPointer(loc, 2, GL_FLOAT, false, stride, (GLvoid*)(2 * sizeof(GLfloat)));
 
@@ -197,6 +366,31 @@ void SliceController::draw()
 void SliceController::update(std::chrono::milliseconds elapsed)
 {
 	elapsed_ = elapsed;
+
+	if (!volume || volumeResident())
+		return;
+
+	// upload at most one slice per frame ahead of the scroll direction
+	int index = nextPrefetch();
+	if (index >= 0)
+		uploadSlice(index);
+}
+
+int SliceController::nextPrefetch() const
+{
+	int depth = reformat_.numSlices();
+	for (int i = 1; i <= prefetchDistance; i++) {
+		int index = ((currentSlice_ + i * scrollDirection_) % depth + depth) % depth;
+		if (findSlice(index) < 0)
+			return index;
+	}
+	return -1;
+}
+
+bool SliceController::animating() const
+{
+	// keep frames coming until the slices ahead of the scroll direction are uploaded
+	return volume && !volumeResident() && nextPrefetch() >= 0;
 }
 
 bool SliceController::leapInput(const Leap::Controller& leapController, const Leap::Frame& frame)
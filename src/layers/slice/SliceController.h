@@ -7,10 +7,19 @@
 #include "gl/Texture.h"
 #include "gl/Buffer.h"
 #include "data/VolumeData.h"
+#include "data/Reformatter.h"
+#include "data/SlabProjector.h"
 #include "gl/math/Math.h"
 #include "leap/PoseTracker.h"
+#include <vector>
 
-/** Controls slice rendering layer */
+/**
+ * Controls slice rendering layer. Axial, coronal, sagittal, or oblique planes are sampled
+ * directly from the volume renderer's 3D texture when the whole volume is resident on the GPU,
+ * so scrolling only changes uniforms. Otherwise a small ring of 2D slice textures (resampled on
+ * the CPU unless the plane is a Z slice) is kept and refilled ahead of the scroll direction.
+ * A thick slab around the current plane can be projected instead of a single plane.
+ */
 class SliceController : public Controller
 {
 public:
@@ -25,9 +34,20 @@ public:
 	void update(std::chrono::milliseconds elapsed) override;
 	int slice() const { return currentSlice_; }
 	void slice(int index);
+	int numSlices() const { return reformat_.numSlices(); }
+	Reformatter::Orientation orientation() const { return reformat_.orientation(); }
+	void orientation(Reformatter::Orientation orientation);
+	bool slabEnabled() const { return slabEnabled_; }
+	SlabProjector::Mode slabMode() const { return slabMode_; }
+	void slab(bool enabled, SlabProjector::Mode mode);
+	float slabThickness() const { return slabThickness_; }
+	void slabThickness(float millimeters);
+	int slabSlices() const;
+	std::unique_ptr<Menu> contextMenu() override;
 	void gainFocus() override;
 	void loseFocus() override;
 	void draw() override;
+	bool animating() const override;
     
 private:
     VolumeData* volume;
@@ -37,9 +57,22 @@ private:
     double mouseAnchorY;
     int anchorSliceIndex;
 
+	static const int ringSize = 8;
+	static const int prefetchDistance = 3;
+
 	gl::Program sliceShader;
+	gl::Program volumeShader;
 	gl::Texture clutTexture;
-	gl::Texture sliceTexture;
+	std::vector<gl::Texture> sliceRing_;
+	std::vector<int> ringSlices_;
+	std::vector<char> resampled_;
+	std::vector<char> projected_;
+	Reformatter reformat_;
+	SlabProjector slab_;
+	bool slabEnabled_;
+	SlabProjector::Mode slabMode_;
+	float slabThickness_;
+	int scrollDirection_;
 	gl::Buffer sliceVBO;
 	int currentSlice_;
 	gl::Mat4 modelMatrix;
@@ -49,7 +82,13 @@ private:
 	float leap_scroll_dst_;
 
 	void resize() override;
-	void updateTexture();
+	bool volumeResident() const;
+	int findSlice(int index) const;
+	int nextPrefetch() const;
+	int uploadSlice(int index);
+	const void* sliceData(int index);
+	int sliceWidth() const;
+	int sliceHeight() const;
 
 	void leapScroll(const Leap::Frame& controller);
 };
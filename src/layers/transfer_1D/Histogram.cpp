@@ -1,17 +1,19 @@
 #include "Histogram.h"
 #include <algorithm>
 #include <iostream>
+#include <cmath>
 
 Histogram::Histogram(int min, int max, int numBins)
 {
-    numBins = std::min(max - min + 1, numBins);
-    
+    numBins = std::max(1, std::min(max - min + 1, numBins));
+
     this->min = min;
     this->max = max;
     this->range = max - min;
     this->numBins = numBins;
     this->binWidth = (double)(max - min + 1) / numBins;
     bins = new unsigned int[numBins];
+    cumulative.resize(numBins);
     clearBins();
 }
 
@@ -23,7 +25,33 @@ Histogram::~Histogram()
 void Histogram::clearBins()
 {
     std::fill(bins, bins+numBins, 0);
+    std::fill(cumulative.begin(), cumulative.end(), 0);
+    maxFrequency = 0;
+}
+
+int Histogram::binIndex(int value) const
+{
+    // equivalent to (value - min) / binWidth without floating point
+    return (int)((int64_t)(value - min) * numBins / (range + 1));
+}
+
+void Histogram::merge(const std::vector<std::vector<unsigned int>>& partials)
+{
+    parallelFor(0, numBins, [&](unsigned, size_t begin, size_t end) {
+        for (const std::vector<unsigned int>& counts : partials) {
+            for (size_t i = begin; i < end; i++) {
+                bins[i] += counts[i];
+            }
+        }
+    });
+
+    uint64_t sum = 0;
     maxFrequency = 0;
+    for (int i = 0; i < numBins; i++) {
+        sum += bins[i];
+        cumulative[i] = sum;
+        maxFrequency = std::max(maxFrequency, (int)bins[i]);
+    }
 }
 
 unsigned int* Histogram::getBins()
@@ -61,6 +89,43 @@ int Histogram::getNumBins()
     return numBins;
 }
 
+uint64_t Histogram::getTotal()
+{
+    return cumulative.back();
+}
+
+uint64_t Histogram::getCumulative(int binIndex)
+{
+    return cumulative[binIndex];
+}
+
+double Histogram::getCDF(int binIndex)
+{
+    uint64_t total = getTotal();
+    return total == 0 ? 0.0 : (double)cumulative[binIndex] / total;
+}
+
+double Histogram::getPercentile(double fraction)
+{
+    uint64_t total = getTotal();
+    if (total == 0) {
+        return min;
+    }
+
+    fraction = std::max(0.0, std::min(1.0, fraction));
+    double rank = fraction * total;
+
+    // first bin whose cumulative count reaches the rank
+    std::vector<uint64_t>::iterator it = std::lower_bound(cumulative.begin(), cumulative.end(), (uint64_t)std::ceil(rank));
+    int bin = std::min((int)(it - cumulative.begin()), numBins - 1);
+
+    uint64_t below = bin > 0 ? cumulative[bin - 1] : 0;
+    double t = bins[bin] > 0 ? (rank - below) / bins[bin] : 0.0;
+    t = std::max(0.0, std::min(1.0, t));
+
+    return getBinLower(bin) + t * binWidth;
+}
+
 double Histogram::getBinLower(int binIndex)
 {
     return min + binIndex * binWidth;
@@ -2,49 +2,72 @@
 #define __MEDLEAP_HISTOGRAM__
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "util/Parallel.h"
 
 class Histogram
 {
 public:
     Histogram(int min, int max, int numBins);
     ~Histogram();
-    
-    /** Updates the histogram with data values */
+
+    /**
+     * Updates the histogram with data values. The data is split across worker threads that each
+     * count into a private sub-histogram; the sub-histograms are then merged in parallel.
+     */
     template <typename T> void readData(T* data, int numElements);
-    
+
     /** Sets all bins to 0 and resets the max frequency */
     void clearBins();
-    
+
     /** Returns the lower bound of a bin */
     double getBinLower(int binIndex);
-    
+
     /** Returns the upper bound of a bin */
     double getBinUpper(int binIndex);
-    
+
     /** Pointer to the raw data */
     unsigned int* getBins();
-    
+
     /** Returns the number of values (frequency) in a given bin */
     unsigned int getSize(int binIndex);
-    
+
     /** Returns the smallest value accepted by the histogram */
     int getMin();
-    
+
     /** Returns the largest value accepted by the histogram */
     int getMax();
-    
+
     /** Returns getMax() - getMin() */
     int getRange();
-    
+
     /** Returns the size of the largest bin */
     int getMaxFrequency();
-    
+
     /** Returns number of bins in the histogram */
     int getNumBins();
-    
+
+    /** Returns the number of values that fell inside [min, max] */
+    uint64_t getTotal();
+
+    /** Returns the number of values in bins 0 through binIndex (inclusive) */
+    uint64_t getCumulative(int binIndex);
+
+    /** Returns the fraction of values in bins 0 through binIndex (inclusive) */
+    double getCDF(int binIndex);
+
+    /**
+     * Returns the value below which the given fraction [0,1] of the data lies. The result is
+     * linearly interpolated inside the bin that contains the requested rank.
+     */
+    double getPercentile(double fraction);
+
     /** Prints a visual representation of histogram to stdout */
     void print();
-    
+
 private:
     int min;
     int max;
@@ -53,23 +76,51 @@ private:
     int numBins;
     double binWidth;
     unsigned int* bins;
+    std::vector<uint64_t> cumulative;
+
+    /** Maps a value in [min, max] to its bin using integer arithmetic only */
+    int binIndex(int value) const;
+
+    /** Adds per-thread counts into bins and recomputes the max frequency and cumulative counts */
+    void merge(const std::vector<std::vector<unsigned int>>& partials);
 };
 
 template <typename T>
 void Histogram::readData(T* data, int numElements)
 {
-    for (int i = 0; i < numElements; i++) {
-        T value = *data++;
-        if (value >= min && value <= max) {
-            // determine which bin the value belongs to, increment the bin size, and check if it
-            // is the largest size in the data set
-            int binIndex = (int)((value - min) / binWidth);
-            if (++bins[binIndex] > maxFrequency) {
-                maxFrequency = bins[binIndex];
-            }
-        }
+    // volumes are 8 or 16 bit, so every possible value can be mapped to its bin with a table
+    // lookup; the extra slot at numBins collects values outside [min, max]
+    static_assert(std::is_integral<T>::value && sizeof(T) <= 2, "Histogram supports 8 and 16 bit data");
+    const int typeMin = std::numeric_limits<T>::min();
+    const int typeMax = std::numeric_limits<T>::max();
+    std::vector<unsigned int> lut(typeMax - typeMin + 1);
+    for (int v = typeMin; v <= typeMax; v++) {
+        lut[v - typeMin] = (v >= min && v <= max) ? binIndex(v) : numBins;
     }
+
+    unsigned numThreads = workerCount();
+    std::vector<std::vector<unsigned int>> partials(numThreads, std::vector<unsigned int>(numBins + 1, 0));
+
+    parallelFor(0, numElements, numThreads, [&](unsigned thread, size_t begin, size_t end) {
+        unsigned int* counts = &partials[thread][0];
+        const unsigned int* table = &lut[0] - typeMin;
+        const T* p = data + begin;
+        const T* last = data + end;
+
+        // unrolled so the four increments are independent of each other
+        while (last - p >= 4) {
+            counts[table[p[0]]]++;
+            counts[table[p[1]]]++;
+            counts[table[p[2]]]++;
+            counts[table[p[3]]]++;
+            p += 4;
+        }
+        while (p < last) {
+            counts[table[*p++]]++;
+        }
+    });
+
+    merge(partials);
 }
 
 #endif // __MEDLEAP_HISTOGRAM__
-
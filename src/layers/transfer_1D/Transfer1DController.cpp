@@ -1,7 +1,7 @@
 #include "Transfer1DController.h"
 #include "main/MainController.h"
+#include "main/MainConfig.h"
 #include "util/Util.h"
-#include "Histogram.h"
 
 using namespace gl;
 using namespace std;
@@ -15,6 +15,7 @@ Transfer1DController::Transfer1DController()
 	leap_drag_performed_ = false;
 	selected_ = nullptr;
 	dirty_textures_ = true;
+	histogram_rate_ = 0.0;
     
 	volumeRenderer = NULL;
 
@@ -147,6 +148,12 @@ std::unique_ptr<Menu> Transfer1DController::contextMenu()
 		MainController::getInstance().menuController().hideMenu();
 	});
 
+	MenuItem& mi_contrast = menu->createItem("Auto Contrast");
+	mi_contrast.setAction([&]{
+		autoContrast();
+		MainController::getInstance().menuController().hideMenu();
+	});
+
 	return std::unique_ptr<Menu>(menu);
 }
 
@@ -155,11 +162,12 @@ void Transfer1DController::setVolume(VolumeData* volume)
     this->volume = volume;
     
 	// create histogram geometry
+    MainConfig cfg;
+    int numBins = cfg.getValue<int>(MainConfig::HISTOGRAM_BINS, 512);
+    histogram_.reset(new Histogram(volume->getMinValue(), volume->getMaxValue(), numBins));
+    Histogram& histogram = *histogram_;
     
-    // 512 bins is somewhat arbitrary; consider adding customization later
-    int numBins = 512;
-    Histogram histogram(volume->getMinValue(), volume->getMaxValue(), numBins);
-    
+    auto start = high_resolution_clock::now();
     switch (volume->getType())
     {
         case GL_BYTE:
@@ -175,6 +183,8 @@ void Transfer1DController::setVolume(VolumeData* volume)
 			histogram.readData((GLushort*)volume->getData(), volume->getNumVoxels());
             break;
     }
+    double seconds = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+    histogram_rate_ = volume->getNumVoxels() / std::max(seconds, 1e-9);
     
 	double logMaxFreq = std::log(histogram.getMaxFrequency() + 1);
 
@@ -431,14 +441,15 @@ void Transfer1DController::drawMarkerBar()
 	}
 	d.end();
 	d.draw();
+	Draw::flush();
 }
 
 void Transfer1DController::drawBackground()
 {
 	bgBuffer.bind();
 	bgShader.enable();
-	glUniform4f(bgShader.getUniform("color"), 0.0f, 0.0f, 0.0f, 1.0f);
-	glUniformMatrix4fv(bgShader.getUniform("modelViewProjection"), 1, false, Mat4());
+	bgShader.uniform("color", 0.0f, 0.0f, 0.0f, 1.0f);
+	bgShader.uniform("modelViewProjection", Mat4());
 
 	GLint loc = bgShader.getAttribute("vs_position");
 	glEnableVertexAttribArray(loc);
@@ -639,4 +650,35 @@ void Transfer1DController::toggleGradient()
 		transfer().gradient(!transfer().gradient());
 		markDirty();
 	}
+}
+
+void Transfer1DController::autoContrast()
+{
+	if (!histogram_ || histogram_->getRange() == 0) {
+		return;
+	}
+
+	// fit the markers to the 1st-99th percentile of the data
+	float range = static_cast<float>(histogram_->getRange());
+	float c = static_cast<float>((histogram_->getPercentile(0.01) - histogram_->getMin()) / range);
+	float d = static_cast<float>((histogram_->getPercentile(0.99) - histogram_->getMin()) / range);
+
+	vector<float> centers;
+	for (const Transfer1D::Marker& m : transfer().markers()) {
+		centers.push_back(m.center());
+	}
+
+	if (centers.size() == 1) {
+		centers[0] = (c + d) * 0.5f;
+	} else {
+		float a = centers.front();
+		float b = centers.back();
+		float s = (b > a) ? (d - c) / (b - a) : 0.0f;
+		for (float& p : centers) {
+			p = (p - a) * s + c;
+		}
+	}
+
+	transfer().move(centers);
+	markDirty();
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "gl/Buffer.h"
 #include "gl/math/Math.h"
 #include "Transfer1D.h"
+#include "Histogram.h"
 #include "leap/PoseTracker.h"
 #include "util/TextRenderer.h"
 #include "gl/util/Draw.h"
@@ -33,6 +34,9 @@ public:
 	void draw() override;
     void setVolumeRenderer(VolumeController* volumeRenderer);
 	void setSliceRenderer(SliceController* sliceRenderer);
+
+	/** Voxels per second of the last histogram build */
+	double histogramRate() const { return histogram_rate_; }
     
 private:
     bool lMouseDrag, rMouseDrag;
@@ -50,6 +54,8 @@ private:
 	bool scaling_markers_;
 	Interval saved_interval_;
 	std::vector<float> saved_centers_;
+	std::unique_ptr<Histogram> histogram_;
+	double histogram_rate_;
 
 	// rendering
 	TextRenderer text;
@@ -88,6 +94,7 @@ private:
 	void createFunction();
 	void deleteFunction();
 	void toggleGradient();
+	void autoContrast();
 };
 
 #endif /* defined(__medleap__Transfer1DController__) */
@@ -22,15 +22,70 @@ void LeapCameraControl::update(const Leap::Controller& controller, const Leap::F
 {
     tracking_ = false;
 	poses_.update(frame);
+
+	// the camera leads the hand by the render latency; the lead is removed when the motion ends
+	float lookahead = PalmPredictor::lookahead();
+	Vector rotate_lead = Vector::zero();
+	Vector translate_lead = Vector::zero();
+
+	bool rotating = false;
+	bool translating = false;
+
 	if (poses_.fist().tracking() && poses_.fist().state() == FistPose::State::closed) {
 		tracking_ = true;
         leapRotate();
+		rotating = true;
+		rotate_predictor_.update(poses_.fist().hand().stabilizedPalmPosition(), frame.timestamp());
+		rotate_lead = rotate_predictor_.lead(lookahead);
 	} else if (poses_.l().tracking()) {
         tracking_ = true;
         auto& lsc = MainController::getInstance().leapStateController();
         lsc.increaseBrightness(LeapStateController::icon_l_open);
 		leapTranslate();
+		if (poses_.l().isClosed()) {
+			translating = true;
+			translate_predictor_.update(poses_.l().handPosition(), frame.timestamp());
+			translate_lead = translate_predictor_.lead(lookahead);
+		}
+	}
+
+	if (!rotating) {
+		rotate_predictor_.reset();
+	}
+	if (!translating) {
+		translate_predictor_.reset();
 	}
+	leadRotation(rotate_lead);
+	leadTranslation(translate_lead);
+}
+
+void LeapCameraControl::leadRotation(const Vector& lead)
+{
+	if (lead == rotate_lead_) {
+		return;
+	}
+
+	// same mapping as leapRotate, applied to the change in lead only
+	Vector v = (lead - rotate_lead_) / 200.0f;
+	rotate_lead_ = lead;
+
+	camera().yaw(camera().yaw() + v.x * pi);
+	camera().pitch(camera().pitch() - v.y);
+	MainController::getInstance().volumeController().markDirty();
+}
+
+void LeapCameraControl::leadTranslation(const Vector& lead)
+{
+	if (lead == translate_lead_) {
+		return;
+	}
+
+	// same mapping as leapTranslate, applied to the change in lead only
+	Vector t = (lead - translate_lead_) / 300.0f;
+	translate_lead_ = lead;
+
+	Mat4 eye2world = camera().view().rotScale().transpose();
+	move(eye2world * -Vec4(t.x, t.y, t.z, 0));
 }
 
 void LeapCameraControl::leapTranslate()
@@ -3,6 +3,7 @@
 
 #include "Leap.h"
 #include "leap/PoseTracker.h"
+#include "leap/PalmPredictor.h"
 #include "gl/math/Math.h"
 #include "util/Camera.h"
 
@@ -18,6 +19,10 @@ public:
 
 private:
 	PoseTracker poses_;
+	PalmPredictor rotate_predictor_;
+	PalmPredictor translate_predictor_;
+	Leap::Vector rotate_lead_;
+	Leap::Vector translate_lead_;
 	bool tracking_;
 	bool mouse_drag_l_;
 	bool mouse_drag_r_;
@@ -30,6 +35,8 @@ private:
 
 	void leapRotate();
 	void leapTranslate();
+	void leadRotation(const Leap::Vector& lead);
+	void leadTranslation(const Leap::Vector& lead);
 
 	void rotate(float delta_yaw, float delta_pitch);
 	void move(const gl::Vec3& delta);
@@ -4,6 +4,7 @@
 #include "main/MainConfig.h"
 #include "main/MainController.h"
 #include "gl/geom/Plane.h"
+#include <cstring>
 
 using namespace gl;
 using namespace std;
@@ -16,6 +17,9 @@ VolumeController::VolumeController()
 	draw_cursor3D = false;
 
 	dirty = true;
+	volumeResident_ = false;
+	uploadIndex_ = 0;
+	uploadSize_ = 0;
 	opacityScale = 1.0f;
 	renderMode = VR;
 	shading = true;
@@ -28,6 +32,8 @@ VolumeController::VolumeController()
 	volumeTexture.generate(GL_TEXTURE_3D);
 	gradientTexture.generate(GL_TEXTURE_3D);
 	maskTexture.generate(GL_TEXTURE_3D);
+	uploadBuffers_[0].generate(GL_PIXEL_UNPACK_BUFFER, GL_STREAM_DRAW);
+	uploadBuffers_[1].generate(GL_PIXEL_UNPACK_BUFFER, GL_STREAM_DRAW);
 
 	proxyVertices.generateVBO(GL_DYNAMIC_DRAW);
 	proxyIndices.generateIBO(GL_DYNAMIC_DRAW);
@@ -36,12 +42,12 @@ VolumeController::VolumeController()
 	//camera.setView(lookAt(0, 0, 1.5f, 0, 0, 0, 0, 1, 0));
 	boxShader = Program::create("shaders/volume_clut.vert", "shaders/volume_clut.frag");
 	boxShader.enable();
-	glUniform1i(boxShader.getUniform("tex_volume"), 0);
-	glUniform1i(boxShader.getUniform("tex_gradients"), 1);
-	glUniform1i(boxShader.getUniform("tex_clut"), 2);
-	glUniform1i(boxShader.getUniform("tex_jitter"), 3);
-	glUniform1i(boxShader.getUniform("tex_mask"), 4);
-	glUniform1i(boxShader.getUniform("tex_context"), 5);
+	boxShader.uniform("tex_volume", 0);
+	boxShader.uniform("tex_gradients", 1);
+	boxShader.uniform("tex_clut", 2);
+	boxShader.uniform("tex_jitter", 3);
+	boxShader.uniform("tex_mask", 4);
+	boxShader.uniform("tex_context", 5);
 
 	fullResRT.setInternalColorFormat(GL_RGB16F);
 	fullResRT.generate(viewport_.width, viewport_.height, true);
@@ -97,6 +103,23 @@ void VolumeController::setVolume(VolumeData* volume)
 {
 	this->volume = volume;
 
+	// the pixel buffers of the previous volume's phases are no longer needed
+	if (uploadSize_ != 0) {
+		for (Buffer& b : uploadBuffers_) {
+			b.bind();
+			b.data(NULL, 0);
+			b.unbind();
+		}
+		uploadSize_ = 0;
+	}
+
+	Draw bounds;
+	bounds.begin(GL_LINES);
+	bounds.color(0.5f, 0.5f, 0.5f);
+	bounds.geometry(volume->getBounds().lines());
+	bounds.end();
+	bounds_mesh_ = bounds.mesh();
+
 	GLenum internalFormat;
 	switch (volume->getType()) {
 	case GL_UNSIGNED_BYTE: internalFormat = GL_R8; break;
@@ -113,6 +136,15 @@ void VolumeController::setVolume(VolumeData* volume)
 	volumeTexture.setParameter(GL_TEXTURE_WRAP_R, GL_CLAMP);
 	volumeTexture.setParameter(GL_TEXTURE_WRAP_T, GL_CLAMP);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// the volume is resident only if the driver accepts the full texture
+	GLint max3DSize = 0;
+	glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &max3DSize);
+	volumeResident_ = (GLint)volume->getWidth() <= max3DSize &&
+		(GLint)volume->getHeight() <= max3DSize &&
+		(GLint)volume->getDepth() <= max3DSize;
+
+	while (glGetError() != GL_NO_ERROR);
 	volumeTexture.setData3D(
 		internalFormat,
 		volume->getWidth(),
@@ -121,6 +153,9 @@ void VolumeController::setVolume(VolumeData* volume)
 		volume->getFormat(),
 		volume->getType(),
 		volume->getData());
+	if (glGetError() != GL_NO_ERROR) {
+		volumeResident_ = false;
+	}
 
 	// gradient texture will be 8-bits per channel (RGB format)
 	{
@@ -178,6 +213,54 @@ void VolumeController::setVolume(VolumeData* volume)
 	}
 }
 
+bool VolumeController::streamVolume(VolumeData* phase)
+{
+	if (!volume || !volumeResident_ ||
+		phase->getWidth() != volume->getWidth() ||
+		phase->getHeight() != volume->getHeight() ||
+		phase->getDepth() != volume->getDepth() ||
+		phase->getType() != volume->getType()) {
+		return false;
+	}
+
+	// both buffers get their storage once; mapping one only waits if the transfer from it, two
+	// volumes ago, hasn't finished
+	GLsizeiptr size = static_cast<GLsizeiptr>(phase->getSizeBytes());
+	if (uploadSize_ != size) {
+		for (Buffer& b : uploadBuffers_) {
+			b.bind();
+			b.data(NULL, size);
+		}
+		uploadSize_ = size;
+	}
+
+	Buffer& buffer = uploadBuffers_[uploadIndex_];
+	uploadIndex_ = 1 - uploadIndex_;
+	buffer.bind();
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT);
+	if (!mapped) {
+		buffer.unbind();
+		return false;
+	}
+	memcpy(mapped, phase->getData(), size);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	// the texture is updated from the bound buffer; the call returns before the transfer is done
+	volumeTexture.bind();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0,
+		phase->getWidth(),
+		phase->getHeight(),
+		phase->getDepth(),
+		phase->getFormat(),
+		phase->getType(),
+		0);
+	buffer.unbind();
+
+	markDirty();
+	return true;
+}
+
 bool VolumeController::keyboardInput(GLFWwindow* window, int key, int action, int mods)
 {
 	switch (key)
@@ -296,16 +379,11 @@ void VolumeController::draw(double samplingScale, bool limitSamples, int w, int
 
     if (draw_lines) {
 	if (draw_bounds) {
-		const Box& bb = volume->getBounds();
-		d.setModelViewProj(mvp);
-		d.begin(GL_LINES);
-		d.color(0.5f, 0.5f, 0.5f);
-		d.geometry(volume->getBounds().lines());
-		d.end();
-		d.draw();
+		bounds_mesh_.draw(mvp);
 	}
 
 	// clipping plane lines: this needs to be improved
+	d.setModelViewProj(mvp);
 	if (draw_planes && clip_planes_.size() > 0) {
 		d.color(1, 0, 1);
 		for (Plane& p : clip_planes_) {
@@ -378,6 +456,7 @@ void VolumeController::draw(double samplingScale, bool limitSamples, int w, int
 		d.end();
 		d.draw();
 	}
+	Draw::flush();
     }
 
 	//{
@@ -418,21 +497,21 @@ void VolumeController::draw(double samplingScale, bool limitSamples, int w, int
 	updateSlices(samplingScale, limitSamples);
 
 
-	glUniformMatrix4fv(boxShader.getUniform("modelViewProjection"), 1, false, mvp);
-	glUniformMatrix4fv(boxShader.getUniform("modelView"), 1, false, modelView);
+	boxShader.uniform("modelViewProjection", mvp);
+	boxShader.uniform("modelView", modelView);
 
-	glUniform3fv(boxShader.getUniform("volumeMin"), 1, volume->getBounds().min());
-	glUniform3fv(boxShader.getUniform("volumeDimensions"), 1, (volume->getBounds().max() - volume->getBounds().min()));
-	glUniform1i(boxShader.getUniform("signed_normalized"), volume->isSigned());
-	glUniform1i(boxShader.getUniform("use_shading"), (renderMode != MIP && shading));
+	boxShader.uniform("volumeMin", volume->getBounds().min());
+	boxShader.uniform("volumeDimensions", volume->getBounds().max() - volume->getBounds().min());
+	boxShader.uniform("signed_normalized", volume->isSigned());
+	boxShader.uniform("use_shading", renderMode != MIP && shading);
 
 
 	boxShader.uniform("visible_min", volume->visible().left());
 	boxShader.uniform("visible_scale", 1.0f / volume->visible().width());
 
-	glUniform1i(boxShader.getUniform("render_mode"), renderMode);
+	boxShader.uniform("render_mode", renderMode);
 
-	glUniform1i(boxShader.getUniform("use_jitter"), useJitter);
+	boxShader.uniform("use_jitter", useJitter);
 
 	boxShader.uniform("num_clip_planes", static_cast<GLint>(clip_planes_.size()));
 	std::vector<Vec4> planes;
@@ -441,14 +520,14 @@ void VolumeController::draw(double samplingScale, bool limitSamples, int w, int
 	}
 	boxShader.uniform("clip_planes", planes);
 
-	glUniform3f(boxShader.getUniform("lightDirection"), -camera.forward().x, -camera.forward().y, -camera.forward().z);
+	boxShader.uniform("lightDirection", -camera.forward().x, -camera.forward().y, -camera.forward().z);
 
-	glUniform3f(boxShader.getUniform("camera_pos"), camera.eye().x, camera.eye().y, camera.eye().z);
+	boxShader.uniform("camera_pos", camera.eye().x, camera.eye().y, camera.eye().z);
 
-	glUniform3f(boxShader.getUniform("minGradient"), volume->getMinGradient().x, volume->getMinGradient().y, volume->getMinGradient().z);
-	glUniform1f(boxShader.getUniform("opacity_scale"), opacityScale);
+	boxShader.uniform("minGradient", volume->getMinGradient().x, volume->getMinGradient().y, volume->getMinGradient().z);
+	boxShader.uniform("opacity_scale", opacityScale);
 	Vec3 r = volume->getMaxGradient() - volume->getMinGradient();
-	glUniform3f(boxShader.getUniform("rangeGradient"), r.x, r.y, r.z);
+	boxShader.uniform("rangeGradient", r.x, r.y, r.z);
 
 
 	boxShader.uniform("cursor_position", maskCenter);
@@ -462,23 +541,23 @@ void VolumeController::draw(double samplingScale, bool limitSamples, int w, int
 	cpss /= cpss.w;
 	cpss.x = (cpss.x + 1.0) * (w / 2.0);
 	cpss.y = (cpss.y + 1.0) * (h / 2.0);
-	glUniform3f(boxShader.getUniform("cursor_position_ss"), cpss.x, cpss.y, cpss.z);
+	boxShader.uniform("cursor_position_ss", cpss.x, cpss.y, cpss.z);
 
 
 
 
 	Vec4 cpee = camera.view() * Vec4(maskCenter, 1.0f);
-	glUniform3f(boxShader.getUniform("cursor_position_es"), cpee.x, cpee.y, cpee.z);
+	boxShader.uniform("cursor_position_es", cpee.x, cpee.y, cpee.z);
 
 
-	glUniform1f(boxShader.getUniform("cursor_radius_ws"), cursorRadius);
+	boxShader.uniform("cursor_radius_ws", cursorRadius);
 	float cursorRadiusSS = gl::projectedRadius(0.8726388, (maskCenter - camera.eye()).length(), cursorRadius) * h / 2.0f;
-	glUniform1f(boxShader.getUniform("cursor_radius_ss"), cursorRadiusSS);
+	boxShader.uniform("cursor_radius_ss", cursorRadiusSS);
 
-	glUniform2f(boxShader.getUniform("window_size"), w, h);
+	boxShader.uniform("window_size", static_cast<GLfloat>(w), static_cast<GLfloat>(h));
 
 
-	glUniform1i(boxShader.getUniform("cursor_on"), use_context);
+	boxShader.uniform("cursor_on", use_context);
 
 	int loc = boxShader.getAttribute("vs_position");
 	glEnableVertexAttribArray(loc);
@@ -500,7 +579,7 @@ void VolumeController::draw(double samplingScale, bool limitSamples, int w, int
 		break;
 	case ISOSURFACE:
 		glDisable(GL_BLEND);
-		glUniform1f(boxShader.getUniform("isoValue"), isovalue);
+		boxShader.uniform("isoValue", isovalue);
 		break;
 	default:
 		break;
@@ -560,9 +639,9 @@ void VolumeController::updateSlices(double samplingScale, bool limitSamples)
 	float actualSamplingLength = slicer.samplingLength();
 	float slRatio = actualSamplingLength / refSampleLength;
 
-	glUniform1f(boxShader.getUniform("opacity_correction"), slRatio);
-	glUniform1f(boxShader.getUniform("sampling_length"), actualSamplingLength);
-	glUniform1f(boxShader.getUniform("jitter_size"), 32.0f);
+	boxShader.uniform("opacity_correction", slRatio);
+	boxShader.uniform("sampling_length", actualSamplingLength);
+	boxShader.uniform("jitter_size", 32.0f);
 }
 
 
@@ -11,6 +11,7 @@
 #include "util/Camera.h"
 #include "gl/Renderbuffer.h"
 #include "gl/util/RenderTarget.h"
+#include "gl/util/Draw.h"
 #include "gl/util/FullScreenQuad.h"
 #include "gl/geom/Plane.h"
 #include "LeapCameraControl.h"
@@ -47,7 +48,23 @@ public:
 	float getOpacityScale();
 	unsigned getCurrentNumSlices();
 
+	/** 3D texture with the volume data; only valid if volumeTextureResident() */
+	const gl::Texture& getVolumeTexture() const { return volumeTexture; }
+
+	/** True if the entire volume was uploaded to the 3D texture */
+	bool volumeTextureResident() const { return volumeResident_; }
+
+	/**
+	 * Replaces the voxels in the 3D texture with those of another volume of the same size and type
+	 * (ex. a cine phase); gradients and the rest of the state are kept. The voxels are copied into one
+	 * of two pixel buffers that are used in turn, so copying the next volume doesn't wait for the
+	 * transfer of the previous one, only for the one before it. Returns false if the texture isn't
+	 * resident or the volume differs.
+	 */
+	bool streamVolume(VolumeData* phase);
+
 	void draw() override;
+	bool animating() const override { return dirty || !drawnHighRes; }
 
 	// TODO: cleanup
 	float cursorRadius;
@@ -81,6 +98,10 @@ private:
 	bool dirty;
 	bool drawnHighRes;
 	gl::Texture volumeTexture;
+	bool volumeResident_;
+	gl::Buffer uploadBuffers_[2];
+	int uploadIndex_;
+	GLsizeiptr uploadSize_;
 	gl::Texture gradientTexture;
 	gl::Texture jitterTexture;
 	Camera camera;
@@ -97,6 +118,9 @@ private:
 	gl::Buffer proxyVertices;
 	gl::Buffer proxyIndices;
 
+	// bounding box lines; rebuilt only when the volume changes
+	gl::Mesh bounds_mesh_;
+
 	// render to texture 
 	gl::RenderTarget fullResRT;
 	gl::RenderTarget lowResRT;
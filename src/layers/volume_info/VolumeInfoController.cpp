@@ -6,7 +6,7 @@
 using namespace std;
 using namespace gl;
 
-VolumeInfoController::VolumeInfoController()
+VolumeInfoController::VolumeInfoController() : volume(nullptr)
 {
 	text_.loadFont("menlo14");
 }
@@ -14,6 +14,7 @@ VolumeInfoController::VolumeInfoController()
 void VolumeInfoController::setVolume(VolumeData* volume)
 {
 	this->volume = volume;
+	roi_.setVolume(volume);
 }
 
 void VolumeInfoController::setVolumeRenderer(VolumeController* volumeRenderer)
@@ -127,12 +128,61 @@ void VolumeInfoController::draw()
 	os << "min, max = " << min << ", " << max;
 	drawText(os.str(), textRow++);
 
+	// histogram build rate of the loaded volume
+	os.str("");
+	os << "Histogram: " << setprecision(1) << MainController::getInstance().transfer1DController().histogramRate() / 1e6 << " Mvoxels/s";
+	drawText(os.str(), textRow++);
+
 	// Slice Index (2D)
 	if (MainController::getInstance().getMode() == MainController::MODE_2D) {
 		os.str("");
-		os << "Slice: " << (sliceRenderer->slice() + 1) << "/" << volume->getDepth();
+		os << Reformatter::name(sliceRenderer->orientation()) << " slice: " << (sliceRenderer->slice() + 1) << "/" << sliceRenderer->numSlices();
+		drawText(os.str(), textRow++);
+
+		if (sliceRenderer->slabEnabled()) {
+			os.str("");
+			os << "Slab: " << SlabProjector::name(sliceRenderer->slabMode()) << " " << sliceRenderer->slabThickness() << " mm (" << sliceRenderer->slabSlices() << " slices)";
+			drawText(os.str(), textRow++);
+		}
+	}
+
+	// Region of interest statistics (computed in the background)
+	updateRoi();
+	textRow++;
+	if (volumeRenderer->use_context) {
+		// world space is the volume scaled to unit diagonal
+		os.str("");
+		os << "ROI: within " << setprecision(1) << volumeRenderer->cursorRadius * volume->getSizeMillimeters().length() << " mm of the cursor";
+		drawText(os.str(), textRow++);
+	}
+	if (roi_.hasResult()) {
+		os.str("");
+		os << "ROI: " << roiResult_.count << " voxels, " << setprecision(2) << roiResult_.volumeMl << " ml";
+		drawText(os.str(), textRow++);
+
+		os.str("");
+		os << setprecision(1) << "ROI mean, sd = " << roiResult_.mean << ", " << roiResult_.stdDev;
 		drawText(os.str(), textRow++);
+
+		os.str("");
+		os << "ROI min, max = " << roiResult_.min << ", " << roiResult_.max;
+		drawText(os.str(), textRow++);
+	}
+	if (roi_.busy() || !roi_.hasResult()) {
+		drawText(string("ROI: computing..."), textRow++);
 	}
 
 	text_.draw();
+}
+
+void VolumeInfoController::updateRoi()
+{
+	RoiStatistics::Region region;
+	region.clipPlanes = volumeRenderer->clipPlanes();
+	region.useSphere = volumeRenderer->use_context;
+	region.sphereCenter = volumeRenderer->maskCenter;
+	region.sphereRadius = volumeRenderer->cursorRadius;
+	region.mask = MainController::getInstance().maskController().snapshot();
+	roi_.update(region);
+	roi_.result(roiResult_);
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "gl/glew.h"
 #include "layers/Controller.h"
 #include "data/VolumeData.h"
+#include "data/RoiStatistics.h"
 #include "layers/volume/VolumeController.h"
 #include "layers/slice/SliceController.h"
 #include "util/TextRenderer.h"
@@ -19,14 +20,18 @@ public:
 	void setSliceRenderer(SliceController* renderer);
 
 	void draw() override;
+	bool animating() const override { return roi_.pending(); }
     
 private:
 	VolumeData* volume;
 	VolumeController* volumeRenderer;
 	SliceController* sliceRenderer;
 	TextRenderer text_;
+	RoiStatistics roi_;
+	RoiStatistics::Result roiResult_;
 
 	void drawText(const std::string& str, int row);
+	void updateRoi();
 };
 
 #endif /* defined(__medleap__VolumeInfoController__) */
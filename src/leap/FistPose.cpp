@@ -3,7 +3,7 @@
 using namespace Leap;
 using namespace std::chrono;
 
-FistPose::FistPose() : state_(State::open)
+FistPose::FistPose() : state_(State::open), last_change_(0), time_since_change_(0)
 {
 	maxHandEngageSpeed(175.0f);
 }
@@ -56,9 +56,9 @@ void FistPose::track(const Frame& frame)
 	}
 
 	if (prev != state_) {
-		last_change_ = high_resolution_clock::now();
+		last_change_ = frame.timestamp();
 		time_since_change_ = milliseconds::zero();
 	} else {
-		time_since_change_ = duration_cast<milliseconds>(high_resolution_clock::now() - last_change_);
+		time_since_change_ = duration_cast<milliseconds>(microseconds(frame.timestamp() - last_change_));
 	}
 }
\ No newline at end of file
@@ -34,7 +34,7 @@ protected:
 
 private:
 	State state_;
-	std::chrono::high_resolution_clock::time_point last_change_;
+	int64_t last_change_;
 	std::chrono::milliseconds time_since_change_;
 };
 
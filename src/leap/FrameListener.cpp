@@ -0,0 +1,27 @@
+#include "FrameListener.h"
+
+using namespace Leap;
+
+FrameListener::FrameListener() : dropped_(0), last_id_(-1), hands_(false), wake_function_(nullptr)
+{
+}
+
+void FrameListener::onFrame(const Controller& controller)
+{
+	Frame frame = controller.frame();
+	if (frame.id() == last_id_) {
+		return;
+	}
+	last_id_ = frame.id();
+
+	if (!queue_.push(frame)) {
+		dropped_++;
+		return;
+	}
+
+	bool hands = !frame.hands().isEmpty();
+	if ((hands || hands_) && wake_function_) {
+		wake_function_();
+	}
+	hands_ = hands;
+}
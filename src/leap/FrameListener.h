@@ -0,0 +1,40 @@
+#ifndef __LEAP_POSES_FRAME_LISTENER_H__
+#define __LEAP_POSES_FRAME_LISTENER_H__
+
+#include "Leap.h"
+#include "util/SpscQueue.h"
+#include <atomic>
+#include <functional>
+
+/**
+Receives every frame on the Leap service thread at device rate and queues it for the render thread.
+The render thread drains the queue once per loop, so poses and controllers see every frame in order
+(including its gestures and timestamp) no matter how long a frame takes to render.
+*/
+class FrameListener : public Leap::Listener
+{
+public:
+	static const size_t capacity = 256;
+
+	FrameListener();
+
+	void onFrame(const Leap::Controller& controller) override;
+
+	/** Render thread: removes the oldest queued frame; returns false if there is none */
+	bool pop(Leap::Frame& frame) { return queue_.pop(frame); }
+
+	/** Frames dropped because the render thread fell more than 'capacity' frames behind */
+	size_t dropped() const { return dropped_.load(); }
+
+	/** Called on the Leap thread after queuing a frame with hands (or the first frame after they leave) */
+	void wakeFunction(std::function<void()> f) { wake_function_ = f; }
+
+private:
+	SpscQueue<Leap::Frame, capacity> queue_;
+	std::atomic<size_t> dropped_;
+	int64_t last_id_;
+	bool hands_;
+	std::function<void()> wake_function_;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "FrameLog.h"
+
+using namespace Leap;
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+	const char magic[4] = { 'M', 'L', 'F', 'R' };
+	const uint32_t version = 1;
+}
+
+FrameRecorder::FrameRecorder() : last_id_(-1), frames_(0)
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+	stop();
+}
+
+bool FrameRecorder::start(const string& fileName)
+{
+	stop();
+	out_.open(fileName.c_str(), ios::binary | ios::trunc);
+	if (!out_) {
+		return false;
+	}
+
+	out_.write(magic, sizeof(magic));
+	out_.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	last_id_ = -1;
+	frames_ = 0;
+	return out_.good();
+}
+
+void FrameRecorder::stop()
+{
+	if (out_.is_open()) {
+		out_.close();
+	}
+}
+
+void FrameRecorder::record(const Frame& frame)
+{
+	if (!out_.is_open() || !frame.isValid() || frame.id() == last_id_) {
+		return;
+	}
+	last_id_ = frame.id();
+
+	string data = frame.serialize();
+	int64_t timestamp = frame.timestamp();
+	uint32_t size = static_cast<uint32_t>(data.size());
+	out_.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+	out_.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	out_.write(data.data(), size);
+	frames_++;
+}
+
+FramePlayer::FramePlayer() : position_(0), decoded_(0), playing_(false), realtime_(true)
+{
+}
+
+bool FramePlayer::open(const string& fileName)
+{
+	stop();
+	records_.clear();
+
+	ifstream in(fileName.c_str(), ios::binary);
+	if (!in) {
+		return false;
+	}
+
+	char header[sizeof(magic)];
+	uint32_t fileVersion = 0;
+	in.read(header, sizeof(header));
+	in.read(reinterpret_cast<char*>(&fileVersion), sizeof(fileVersion));
+	if (!in || !equal(magic, magic + sizeof(magic), header) || fileVersion != version) {
+		return false;
+	}
+
+	// a truncated last record (ex. the application was closed while recording) is dropped
+	while (true) {
+		Record r;
+		uint32_t size = 0;
+		in.read(reinterpret_cast<char*>(&r.timestamp), sizeof(r.timestamp));
+		in.read(reinterpret_cast<char*>(&size), sizeof(size));
+		if (!in) {
+			break;
+		}
+		r.data.resize(size);
+		if (size > 0) {
+			in.read(&r.data[0], size);
+		}
+		if (!in) {
+			break;
+		}
+		records_.push_back(std::move(r));
+	}
+
+	return !records_.empty();
+}
+
+void FramePlayer::start(bool realtime)
+{
+	if (records_.empty()) {
+		return;
+	}
+	realtime_ = realtime;
+	playing_ = true;
+	position_ = 0;
+	decoded_ = records_.size(); // nothing decoded yet
+	start_ = high_resolution_clock::now();
+}
+
+void FramePlayer::stop()
+{
+	playing_ = false;
+}
+
+double FramePlayer::elapsedSeconds() const
+{
+	return duration_cast<duration<double>>(high_resolution_clock::now() - start_).count();
+}
+
+bool FramePlayer::next(Frame& frame)
+{
+	if (!playing_) {
+		return false;
+	}
+
+	if (realtime_) {
+		// latest frame that was captured no later than the time since playback started
+		int64_t elapsed = static_cast<int64_t>(elapsedSeconds() * 1000000.0);
+		int64_t first = records_[0].timestamp;
+		while (position_ + 1 < records_.size() && records_[position_ + 1].timestamp - first <= elapsed) {
+			position_++;
+		}
+		if (position_ + 1 == records_.size() && records_[position_].timestamp - first < elapsed && decoded_ == position_) {
+			playing_ = false;
+			return false;
+		}
+	} else if (decoded_ != records_.size()) {
+		if (position_ + 1 == records_.size()) {
+			playing_ = false;
+			return false;
+		}
+		position_++;
+	}
+
+	// the same frame is returned until playback moves on, so it's only deserialized once
+	if (decoded_ != position_) {
+		frame_.deserialize(records_[position_].data);
+		decoded_ = position_;
+	}
+
+	frame = frame_;
+	return true;
+}
@@ -0,0 +1,89 @@
+#ifndef __LEAP_POSES_FRAME_LOG_H__
+#define __LEAP_POSES_FRAME_LOG_H__
+
+#include "Leap.h"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+Binary log of Leap frames. Each record is the frame's device timestamp (microseconds), the size of the
+serialized frame, and the bytes from Leap::Frame::serialize(). Serialized frames keep everything the poses
+read (hands, fingers, stabilized positions, interaction box and gestures), so a replayed frame can be passed
+to Pose::update and the controllers' leapInput in place of a live one.
+*/
+class FrameRecorder
+{
+public:
+	FrameRecorder();
+	~FrameRecorder();
+
+	/** Starts a new log; returns false if the file can't be created */
+	bool start(const std::string& fileName);
+
+	/** Closes the log */
+	void stop();
+
+	bool recording() const { return out_.is_open(); }
+
+	/** Appends a frame; frames already recorded (same id) are skipped */
+	void record(const Leap::Frame& frame);
+
+	/** Number of frames written since start() */
+	size_t frames() const { return frames_; }
+
+private:
+	std::ofstream out_;
+	int64_t last_id_;
+	size_t frames_;
+};
+
+/** Plays back a log written by FrameRecorder, either at the recorded rate or one frame per call */
+class FramePlayer
+{
+public:
+	FramePlayer();
+
+	/** Reads a whole log into memory; returns false if the file is missing or malformed */
+	bool open(const std::string& fileName);
+
+	/** Starts playback from the first frame. Realtime playback follows the recorded timestamps. */
+	void start(bool realtime);
+
+	void stop();
+
+	bool playing() const { return playing_; }
+
+	bool realtime() const { return realtime_; }
+
+	/** Frame for the current time (realtime) or the next frame; returns false once the log is finished */
+	bool next(Leap::Frame& frame);
+
+	/** Frames in the log */
+	size_t size() const { return records_.size(); }
+
+	/** Index of the current frame */
+	size_t position() const { return position_; }
+
+	/** Wall time since start() */
+	double elapsedSeconds() const;
+
+private:
+	struct Record
+	{
+		int64_t timestamp;
+		std::string data;
+	};
+
+	std::vector<Record> records_;
+	size_t position_;
+	size_t decoded_;
+	bool playing_;
+	bool realtime_;
+	Leap::Frame frame_;
+	std::chrono::high_resolution_clock::time_point start_;
+};
+
+#endif
@@ -1,11 +1,12 @@
 #include "LPose.h"
+#include <limits>
 
 using namespace Leap;
 using namespace std::chrono;
 
 LPose::LPose() :
 	closed_(false),
-	last_close_(high_resolution_clock::now()),
+	last_close_(std::numeric_limits<int64_t>::min() / 2),
 	open_fn_(nullptr),
 	close_fn_(nullptr),
     close_separation_(35.0f)
@@ -77,7 +78,7 @@ void LPose::track(const Frame& frame)
 			open_fn_(frame);
 		}
 		if (click_fn_) {
-			auto elapsed = duration_cast<milliseconds>(high_resolution_clock::now() - last_close_);
+			auto elapsed = duration_cast<milliseconds>(microseconds(frame.timestamp() - last_close_));
 			if (elapsed.count() < 200.0f) {
 				click_fn_(frame);
 			}
@@ -87,7 +88,7 @@ void LPose::track(const Frame& frame)
 			close_fn_(frame);
 		}
         hand_closed_ = hand();
-		last_close_ = high_resolution_clock::now();
+		last_close_ = frame.timestamp();
 	}
 }
 
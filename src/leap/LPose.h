@@ -41,7 +41,7 @@ protected:
 private:
 	bool closed_;
     Leap::Hand hand_closed_;
-	std::chrono::high_resolution_clock::time_point last_close_;
+	int64_t last_close_;
 	std::function<void(const Leap::Frame&)> open_fn_;
 	std::function<void(const Leap::Frame&)> close_fn_;
 	std::function<void(const Leap::Frame&)> click_fn_;
@@ -0,0 +1,68 @@
+#include "PalmPredictor.h"
+#include "main/MainConfig.h"
+#include "util/LatencyTracker.h"
+#include <algorithm>
+
+using namespace Leap;
+
+PalmPredictor::PalmPredictor(float alpha, float beta) : alpha_(alpha), beta_(beta)
+{
+	reset();
+}
+
+void PalmPredictor::reset()
+{
+	initialized_ = false;
+	timestamp_ = 0;
+	measured_ = Vector::zero();
+	position_ = Vector::zero();
+	velocity_ = Vector::zero();
+}
+
+void PalmPredictor::update(const Vector& position, int64_t timestamp)
+{
+	measured_ = position;
+
+	if (!initialized_) {
+		initialized_ = true;
+		timestamp_ = timestamp;
+		position_ = position;
+		velocity_ = Vector::zero();
+		return;
+	}
+
+	float dt = (timestamp - timestamp_) / 1000000.0f;
+	if (dt <= 0.0f) {
+		return;
+	}
+	timestamp_ = timestamp;
+
+	// predict with constant velocity, then correct position and velocity by the residual
+	Vector predicted = position_ + velocity_ * dt;
+	Vector residual = position - predicted;
+	position_ = predicted + residual * alpha_;
+	velocity_ += residual * (beta_ / dt);
+}
+
+Vector PalmPredictor::lead(float seconds) const
+{
+	if (!initialized_ || seconds <= 0.0f) {
+		return Vector::zero();
+	}
+	return position_ + velocity_ * seconds - measured_;
+}
+
+float PalmPredictor::lookahead()
+{
+	static float maxSeconds = -1.0f;
+	if (maxSeconds < 0.0f) {
+		MainConfig cfg;
+		maxSeconds = std::max(0.0f, cfg.getValue<float>(MainConfig::LEAP_PREDICTION, 50.0f)) / 1000.0f;
+	}
+
+	double measured = LatencyTracker::getInstance().expectedLatency();
+	if (measured <= 0.0) {
+		return maxSeconds;
+	}
+	return std::min(maxSeconds, static_cast<float>(measured / 1000.0));
+}
@@ -0,0 +1,42 @@
+#ifndef __LEAP_POSES_PALM_PREDICTOR_H__
+#define __LEAP_POSES_PALM_PREDICTOR_H__
+
+#include "Leap.h"
+
+/**
+Alpha-beta filter on a palm position. Estimates the hand's velocity from the frame timestamps and
+extrapolates the position to the time the frame will be displayed, so controls that follow the hand
+can lead it by the render latency. Controls apply lead() on top of the measured motion and remove the
+previous lead, so the prediction never accumulates into the controlled state.
+*/
+class PalmPredictor
+{
+public:
+	PalmPredictor(float alpha = 0.5f, float beta = 0.1f);
+
+	/** Forgets the motion history (call when tracking engages) */
+	void reset();
+
+	/** Adds a measurement; the timestamp is the frame's device time in microseconds */
+	void update(const Leap::Vector& position, int64_t timestamp);
+
+	/** Estimated velocity in mm/s */
+	const Leap::Vector& velocity() const { return velocity_; }
+
+	/** Offset from the last measurement to the position predicted 'seconds' later */
+	Leap::Vector lead(float seconds) const;
+
+	/** Seconds to predict ahead: the measured capture-to-swap latency, limited by the config */
+	static float lookahead();
+
+private:
+	float alpha_;
+	float beta_;
+	bool initialized_;
+	int64_t timestamp_;
+	Leap::Vector measured_;
+	Leap::Vector position_;
+	Leap::Vector velocity_;
+};
+
+#endif
@@ -12,7 +12,7 @@ Pose::Pose() :
 	engage_delay_(0),
 	disengage_delay_(0),
 	total_elapsed_(0),
-    last_update_(std::chrono::high_resolution_clock::now()),
+	last_timestamp_(-1),
 	track_function_(nullptr),
 	engage_function_(nullptr),
 	disengage_function_(nullptr)
@@ -29,9 +29,13 @@ void Pose::update(const Frame& frame)
 		return;
 	}
 
-	auto time = std::chrono::high_resolution_clock::now();
-	milliseconds elapsed = duration_cast<milliseconds>(time - last_update_);
-	last_update_ = time;
+	// no earlier frame (or the timestamps restarted when switching between a device and a replay):
+	// there is nothing to wait for
+	milliseconds elapsed = engage_delay_ + disengage_delay_;
+	if (last_timestamp_ >= 0 && frame.timestamp() >= last_timestamp_) {
+		elapsed = duration_cast<milliseconds>(microseconds(frame.timestamp() - last_timestamp_));
+	}
+	last_timestamp_ = frame.timestamp();
 
 	if (tracking_) {
 		if (total_elapsed_ < disengage_delay_) {
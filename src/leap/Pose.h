@@ -17,7 +17,7 @@ public:
 
 	virtual ~Pose();
 
-	/** Call each frame to update tracking status */
+	/** Call each frame to update tracking status. Delays are measured with the frames' device timestamps, so a replayed log behaves the same at any playback speed. */
 	void update(const Leap::Frame& frame);
 
 	/** Tracking is active */
@@ -78,7 +78,7 @@ private:
 	std::chrono::milliseconds engage_delay_;
 	std::chrono::milliseconds disengage_delay_;
 	std::chrono::milliseconds total_elapsed_;
-	std::chrono::high_resolution_clock::time_point last_update_;
+	int64_t last_timestamp_;
 	std::function<void(const Leap::Frame&)> track_function_;
 	std::function<void(const Leap::Frame&)> engage_function_;
 	std::function<void(const Leap::Frame&)> disengage_function_;
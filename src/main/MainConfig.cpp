@@ -9,6 +9,14 @@ const std::string MainConfig::MULTISAMPLING = "multisampling";
 const std::string MainConfig::SAMPLES = "samples";
 const std::string MainConfig::MIN_SLICES = "min_slices";
 const std::string MainConfig::MAX_SLICES = "max_slices";
+const std::string MainConfig::HISTOGRAM_BINS = "histogram_bins";
+const std::string MainConfig::SLAB_THICKNESS = "slab_thickness";
+const std::string MainConfig::LEAP_PREDICTION = "leap_prediction";
+const std::string MainConfig::THUMBNAIL_CACHE = "thumbnail_cache";
+const std::string MainConfig::THUMBNAIL_CACHE_MB = "thumbnail_cache_mb";
+const std::string MainConfig::PREFETCH_MB = "prefetch_mb";
+const std::string MainConfig::CINE_CACHE_PHASES = "cine_cache_phases";
+const std::string MainConfig::CINE_FPS = "cine_fps";
 MainConfig::MainConfig()
 {
 #if defined(_WIN32)
@@ -28,6 +36,14 @@ MainConfig::MainConfig()
         putValue(SAMPLES, 8);
 		putValue(MIN_SLICES, 128);
 		putValue(MAX_SLICES, 1024);
+		putValue(HISTOGRAM_BINS, 512);
+		putValue(SLAB_THICKNESS, 10.0f);
+		putValue(LEAP_PREDICTION, 50.0f);
+		putValue(THUMBNAIL_CACHE, homeDir + "/.medleap_thumbnails");
+		putValue(THUMBNAIL_CACHE_MB, 64);
+		putValue(PREFETCH_MB, 1024);
+		putValue(CINE_CACHE_PHASES, 8);
+		putValue(CINE_FPS, 15.0f);
         
         save(fileName);
     }
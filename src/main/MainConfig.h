@@ -16,6 +16,14 @@ public:
     static const std::string SAMPLES;
 	static const std::string MIN_SLICES;
 	static const std::string MAX_SLICES;
+	static const std::string HISTOGRAM_BINS;
+	static const std::string SLAB_THICKNESS;
+	static const std::string LEAP_PREDICTION;
+	static const std::string THUMBNAIL_CACHE;
+	static const std::string THUMBNAIL_CACHE_MB;
+	static const std::string PREFETCH_MB;
+	static const std::string CINE_CACHE_PHASES;
+	static const std::string CINE_FPS;
 };
 
 #endif /* defined(__medleap__MainConfig__) */
@@ -1,11 +1,26 @@
 #include "MainController.h"
 #include "data/VolumeLoader.h"
+#include "util/LatencyTracker.h"
+#include "util/Profiler.h"
+#include "main/MainConfig.h"
 #include <chrono>
+#include <algorithm>
+#include <thread>
+#include <iostream>
+#include <typeinfo>
 #include "gl/math/Math.h"
 
 using namespace gl;
 using namespace std;
 
+// how long the loop may block while idle; the Leap thread can only wake it with GLFW 3.1+, so it
+// wakes up more often when a device is connected to notice hands entering the view
+static const double idleTimeout = 0.25;
+static const double leapIdleTimeout = 0.03;
+
+// longest wait for the last frame's fence; a GPU still busy after that shouldn't delay input
+static const double swapTimeout = 0.005;
+
 void keyboardCB(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     MainController::getInstance().keyboardInput(window, key, action, mods);
@@ -38,14 +53,19 @@ MainController& MainController::getInstance()
 }
 
 MainController::MainController() :
-    volume(NULL)
+    volume(NULL),
+    damaged_(true),
+    leapHands_(false),
+    leapFrameId_(-1)
 {
     mode = MODE_3D;
     showHistogram = false;
+	showProfiler_ = false;
 }
 
 MainController::~MainController()
 {
+	leapController.removeListener(leapListener_);
 }
 
 void MainController::init(GLFWwindow* window)
@@ -69,6 +89,12 @@ void MainController::init(GLFWwindow* window)
 	leapController.config().setFloat("Gesture.Circle.MinRadius", 50.0f);
 	leapController.config().save();
 
+	// frames are queued on the Leap thread; a frame with hands wakes the loop if it's waiting for events
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 1)
+	leapListener_.wakeFunction([] { glfwPostEmptyEvent(); });
+#endif
+	leapController.addListener(leapListener_);
+
 
 	setMode(MODE_3D);
 }
@@ -76,6 +102,7 @@ void MainController::init(GLFWwindow* window)
 void MainController::setMode(MainController::Mode mode)
 {
     this->mode = mode;
+    damaged_ = true;
     switch (mode) {
         case MODE_2D:
             renderer.clearLayers();
@@ -85,8 +112,11 @@ void MainController::setMode(MainController::Mode mode)
             if (showHistogram)
                 pushController(&histogramController, Docking(Docking::BOTTOM, 0.14));
 			pushController(&orientationController);
+			pushController(&cine_controller_);
 			pushController(&load_controller_);
 			pushController(&leap_state_controller_, Docking(Docking::LEFT, .07, 96));
+			if (showProfiler_)
+				pushController(&profiler_controller_);
 			pushController(&menuController_);
 			break;
         case MODE_3D:
@@ -100,8 +130,11 @@ void MainController::setMode(MainController::Mode mode)
 			pushController(&clip_controller_);
 			pushController(&focus_controller_);
 			pushController(&mask_controller_);
+			pushController(&cine_controller_);
 			pushController(&load_controller_);
 			pushController(&leap_state_controller_, Docking(Docking::LEFT, .07, 96));
+			if (showProfiler_)
+				pushController(&profiler_controller_);
 			pushController(&menuController_);
             break;
     }
@@ -122,10 +155,16 @@ void MainController::setVolume(VolumeData* volume)
     if (this->volume == volume)
         return;
     
+    // stop background work that reads the old volume before deleting it
+    volumeInfoController.setVolume(NULL);
+    mask_controller_.setVolume(volume);
+    cine_controller_.setVolume(volume);
+    
     if (this->volume != NULL)
         delete this->volume;        
     
     this->volume = volume;
+    damaged_ = true;
 	sliceController_.setVolume(volume);
 	volumeController_.setVolume(volume);
     volumeInfoController.setVolume(volume);
@@ -140,13 +179,67 @@ void MainController::setVolume(VolumeData* volume)
 void MainController::startLoop()
 {
     while (!glfwWindowShouldClose(window)) {
+		Profiler::getInstance().beginFrame();
+		LatencyTracker::getInstance().collect();
 		update();
-		renderer.draw(width, height);
-		glfwSwapBuffers(window);
+
+		// only compose a new frame when something changed; otherwise block until input arrives
+		if (needsRedraw()) {
+			Profiler::Scope frameScope("Frame", true);
+			damaged_ = false;
+			renderer.draw(width, height);
+			LatencyTracker::getInstance().mark(LatencyTracker::SUBMIT);
+			{
+				Profiler::Scope swapScope("SwapBuffers");
+				glfwSwapBuffers(window);
+			}
+			LatencyTracker::getInstance().swapped();
+			Program::endFrame();
+		} else {
+			waitForEvents();
+		}
     }
     glfwTerminate();
 }
 
+bool MainController::needsRedraw() const
+{
+	if (damaged_) {
+		return true;
+	}
+
+	for (Controller* c : activeControllers) {
+		if (c->animating()) {
+			return true;
+		}
+	}
+
+	// the focus layer may be hidden but still running (ex. region growing in the mask layer)
+	return !focus_stack_.empty() && focus_stack_.top()->animating();
+}
+
+void MainController::waitForEvents()
+{
+	double timeout = (leapController.isConnected() || leapPlayer_.playing()) ? leapIdleTimeout : idleTimeout;
+
+	// wait briefly for the last frame to finish on the GPU first so its latency sample is stamped on time
+	auto start = chrono::steady_clock::now();
+	if (LatencyTracker::getInstance().waitForSwap(std::min(timeout, swapTimeout))) {
+		return;
+	}
+	timeout -= chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	if (timeout <= 0.0) {
+		return;
+	}
+
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 2)
+	glfwWaitEventsTimeout(timeout);
+#else
+	// no timed wait before GLFW 3.2; sleep briefly and let the next update() poll the events
+	this_thread::sleep_for(chrono::milliseconds(static_cast<int>(std::min(timeout, 0.01) * 1000)));
+#endif
+}
+
 Controller* MainController::focusLayer()
 {
 	if (focus_stack_.empty()) {
@@ -163,6 +256,7 @@ void MainController::focusLayer(Controller* controller)
 	}
 	focus_stack_.push(controller);
 	controller->gainFocus();
+	damaged_ = true;
 }
 
 void MainController::pushFocus(Controller* controller)
@@ -172,6 +266,7 @@ void MainController::pushFocus(Controller* controller)
 	}
 	focus_stack_.push(controller);
 	controller->gainFocus();
+	damaged_ = true;
 }
 
 void MainController::popFocus()
@@ -183,6 +278,7 @@ void MainController::popFocus()
 			focus_stack_.top()->gainFocus();
 		}
 	}
+	damaged_ = true;
 }
 
 void MainController::pickColor(const Color& initialColor, std::function<void(const Color&)> callback)
@@ -206,22 +302,70 @@ void MainController::update()
 	glfwPollEvents();
 
 	for (int i = 0; i < activeControllers.size(); i++) {
+		Profiler::Scope scope(Profiler::scopeName(typeid(*activeControllers[i]), "::update"));
 		activeControllers[i]->update(elapsed);
 	}
 
-	// leap input
-	if (leapController.isConnected()) {
+	// the focus layer may only handle input (ex. masking) without being a visible layer
+	Controller* focus = focusLayer();
+	if (focus && std::find(activeControllers.begin(), activeControllers.end(), focus) == activeControllers.end()) {
+		Profiler::Scope scope(Profiler::scopeName(typeid(*focus), "::update"));
+		focus->update(elapsed);
+	}
+
+	// leap input, either from a recorded log or every frame the device delivered since the last loop
+	leapFrames_.clear();
+	Leap::Frame frame;
+	if (leapPlayer_.playing()) {
+		// live frames are discarded during a replay so the queue doesn't fill up
+		while (leapListener_.pop(frame)) {}
+
+		if (leapPlayer_.next(frame)) {
+			leapFrames_.push_back(frame);
+			if (!leapPlayer_.realtime()) {
+				// run the full pipeline for every frame when replaying at maximum speed
+				damaged_ = true;
+			}
+		} else {
+			cout << "Leap replay finished: " << leapPlayer_.size() << " frames in " << leapPlayer_.elapsedSeconds() << " s" << endl;
+		}
+	} else {
+		while (leapListener_.pop(frame)) {
+			leapRecorder_.record(frame);
+			leapFrames_.push_back(frame);
+		}
+	}
+
+	if (leapFrames_.empty()) {
+		return;
+	}
+
+	Profiler::Scope scope("Leap input");
+	for (const Leap::Frame& frame : leapFrames_) {
+		// redraw while hands are tracked and once more after they leave
+		bool hands = !frame.hands().isEmpty();
+		if (frame.id() != leapFrameId_ && (hands || leapHands_)) {
+			damaged_ = true;
+			// replayed frames have no device clock; their latency starts at the poll
+			int64_t now = leapPlayer_.playing() ? frame.timestamp() : leapController.now();
+			LatencyTracker::getInstance().polled(frame.timestamp(), now);
+		}
+		leapFrameId_ = frame.id();
+		leapHands_ = hands;
+
 		Controller* focus = focusLayer();
 
 		bool menuPassThrough = true;
 		if (!focus || !focus->modal()) {
-			menuPassThrough = menuController_.leapInput(leapController, leapController.frame());
+			menuPassThrough = menuController_.leapInput(leapController, frame);
 		}
 
 		if (focus && menuPassThrough) {
-			focus->leapInput(leapController, leapController.frame());
+			focus->leapInput(leapController, frame);
 		}
 	}
+
+	LatencyTracker::getInstance().mark(LatencyTracker::INPUT);
 }
 
 void MainController::showTransfer1D(bool show)
@@ -236,8 +380,64 @@ void MainController::toggleHistogram()
     setMode(mode);
 }
 
+void MainController::toggleProfiler()
+{
+	showProfiler_ = !showProfiler_;
+	Profiler::getInstance().enabled(showProfiler_);
+	setMode(mode);
+}
+
+void MainController::exportTrace()
+{
+	MainConfig cfg;
+	string fileName = cfg.getValue<string>(MainConfig::WORKING_DIR) + "/medleap_trace.json";
+	if (Profiler::getInstance().exportChromeTrace(fileName)) {
+		cout << "Profiler trace written to " << fileName << endl;
+	} else {
+		cout << "Could not write profiler trace to " << fileName << endl;
+	}
+}
+
+void MainController::toggleLeapRecording()
+{
+	if (leapRecorder_.recording()) {
+		leapRecorder_.stop();
+		cout << "Leap recording stopped: " << leapRecorder_.frames() << " frames" << endl;
+		return;
+	}
+
+	MainConfig cfg;
+	string fileName = cfg.getValue<string>(MainConfig::WORKING_DIR) + "/medleap_leap.rec";
+	if (leapRecorder_.start(fileName)) {
+		cout << "Recording Leap frames to " << fileName << endl;
+	} else {
+		cout << "Could not write Leap recording to " << fileName << endl;
+	}
+}
+
+void MainController::toggleLeapReplay(bool realtime)
+{
+	if (leapPlayer_.playing()) {
+		leapPlayer_.stop();
+		cout << "Leap replay stopped" << endl;
+		return;
+	}
+
+	MainConfig cfg;
+	string fileName = cfg.getValue<string>(MainConfig::WORKING_DIR) + "/medleap_leap.rec";
+	if (leapPlayer_.open(fileName)) {
+		leapRecorder_.stop();
+		leapPlayer_.start(realtime);
+		cout << "Replaying " << leapPlayer_.size() << " Leap frames from " << fileName << (realtime ? "" : " at maximum speed") << endl;
+	} else {
+		cout << "Could not read Leap recording " << fileName << endl;
+	}
+}
+
 void MainController::keyboardInput(GLFWwindow *window, int key, int action, int mods)
 {
+	damaged_ = true;
+
 	if (key == GLFW_KEY_M && action == GLFW_PRESS) {
 		setMode((mode == MODE_2D) ? MODE_3D : MODE_2D);
 	}
@@ -249,7 +449,25 @@ void MainController::keyboardInput(GLFWwindow *window, int key, int action, int
 
 	if (key == GLFW_KEY_H && action == GLFW_PRESS)
 		toggleHistogram();
+
+	if (key == GLFW_KEY_F2 && action == GLFW_PRESS)
+		toggleProfiler();
+
+	if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+		exportTrace();
+
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS)
+		toggleLeapRecording();
+
+	if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+		toggleLeapReplay(!(mods & GLFW_MOD_SHIFT));
 	
+	Controller* focus = focusLayer();
+	if (focus && std::find(activeControllers.begin(), activeControllers.end(), focus) == activeControllers.end()) {
+		if (!focus->keyboardInput(window, key, action, mods)) {
+			return;
+		}
+	}
     
 	for (Controller* c : activeControllers) {
 		bool passThrough = c->keyboardInput(window, key, action, mods);
@@ -263,10 +481,13 @@ void MainController::resize(int width, int height)
 {
 	this->width = width;
 	this->height = height;
+	damaged_ = true;
 }
 
 void MainController::mouseButton(GLFWwindow *window, int button, int action, int mods)
 {
+	damaged_ = true;
+
 	// pushing color picker while iterating causes foreach to break
 	for (Controller* c : activeControllers) {
 		bool passThrough = c->mouseButton(window, button, action, mods, mMouseX, mMouseY);
@@ -277,6 +498,8 @@ void MainController::mouseButton(GLFWwindow *window, int button, int action, int
 
 void MainController::mouseMotion(GLFWwindow *window, double x, double y)
 {
+    damaged_ = true;
+
     // convert y to bottom up
     y = height - y - 1;
 	mMouseX = x;
@@ -290,6 +513,8 @@ void MainController::mouseMotion(GLFWwindow *window, double x, double y)
 
 void MainController::scroll(GLFWwindow *window, double dx, double dy)
 {
+	damaged_ = true;
+
 	for (Controller* c : activeControllers) {
 		bool passThrough = c->scroll(window, dx, dy);
 		if (!passThrough)
@@ -301,6 +526,7 @@ void MainController::popController()
 {
 	Controller* c = activeControllers.front();
 	renderer.popLayer();
+	damaged_ = true;
 	activeControllers.erase(activeControllers.begin());
 
 	chooseTrackedGestures();
@@ -315,6 +541,7 @@ void MainController::pushController(Controller* controller)
 void MainController::pushController(Controller* controller, MainController::Docking docking)
 {
     activeControllers.insert(activeControllers.begin(), controller);
+    damaged_ = true;
         
     switch (docking.position)
     {
@@ -14,8 +14,12 @@
 #include "layers/mask/MaskController.h"
 #include "layers/leap_state/LeapStateController.h"
 #include "layers/load/LoadController.h"
+#include "layers/profiler/ProfilerController.h"
+#include "layers/cine/CineController.h"
 #include "util/TextRenderer.h"
 #include "gl/util/Draw.h"
+#include "leap/FrameListener.h"
+#include "leap/FrameLog.h"
 #include "Leap.h"
 #include <list>
 #include <stack>
@@ -64,6 +68,7 @@ public:
 	FocusController& focusController() { return focus_controller_; }
 	MaskController& maskController() { return mask_controller_; }
 	LoadController& loadController() { return load_controller_; }
+	CineController& cineController() { return cine_controller_; }
 	LeapStateController& leapStateController() { return leap_state_controller_; }
 	gl::Draw& draw() { return draw_; }
 	void pickColor(const Color& initialColor, std::function<void(const Color&)> callback);
@@ -80,6 +85,9 @@ public:
 	void pushFocus(Controller* focus);
 	void popFocus();
 
+	/** Requests a redraw at the next loop iteration (state changed without input) */
+	void invalidate() { damaged_ = true; }
+
 private:    
     MainController();
 
@@ -88,13 +96,22 @@ private:
     MainController& operator=(const MainController& copy) = delete;
 	
 	void update();
+	bool needsRedraw() const;
+	void waitForEvents();
 
     void toggleHistogram();
+	void toggleProfiler();
+	void exportTrace();
+	void toggleLeapRecording();
+	void toggleLeapReplay(bool realtime);
 	void chooseTrackedGestures();
 
 	std::stack<Controller*> focus_stack_;
 	GLFWwindow* window;
+	FrameListener leapListener_;
 	Leap::Controller leapController;
+	FrameRecorder leapRecorder_;
+	FramePlayer leapPlayer_;
     MainRenderer renderer;
 	SliceController sliceController_;
 	VolumeController volumeController_;
@@ -108,16 +125,23 @@ private:
 	MaskController mask_controller_;
 	LeapStateController leap_state_controller_;
 	LoadController load_controller_;
+	CineController cine_controller_;
+	ProfilerController profiler_controller_;
 	gl::Draw draw_;
 
     std::vector<Controller*> activeControllers;
     Mode mode;
     VolumeData* volume;
     bool showHistogram;
+	bool showProfiler_;
 	int width;
 	int height;
 	double mMouseX;
 	double mMouseY;
+	bool damaged_;
+	bool leapHands_;
+	int64_t leapFrameId_;
+	std::vector<Leap::Frame> leapFrames_;
 
 };
 
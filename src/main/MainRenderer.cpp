@@ -1,5 +1,8 @@
 #include "MainRenderer.h"
 #include "MainConfig.h"
+#include "util/Profiler.h"
+#include "gl/util/Draw.h"
+#include <typeinfo>
 
 using namespace gl;
 
@@ -56,7 +59,9 @@ void MainRenderer::draw(int width, int height)
     int layer = 0;
 	for (Controller* r : activeLayers) {
         updateViewport(r, layer, width, height);
+        Profiler::Scope scope(Profiler::scopeName(typeid(*r), "::draw"), true);
         r->draw();
+        Draw::flush();
         layer++;
     }
 }
@@ -1,6 +1,7 @@
 #include "gl/glew.h"
 #include "MainController.h"
 #include "main/MainConfig.h"
+#include "data/VolumeFile.h"
 #include <iostream>
 
 GLFWwindow* initGL(int width, int height, const char* title)
@@ -62,6 +63,8 @@ int main(int argc, char** argv)
     
     if (argc > 1) {
 		VolumeLoader::Source src = { argv[1], VolumeLoader::Source::DICOM_DIR };
+		if (VolumeFile::format(argv[1]) != VolumeFile::Format::unknown)
+			src.type = VolumeLoader::Source::VOLUME_FILE;
 		controller.loadController().source(src);
     }
     
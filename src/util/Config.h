@@ -34,6 +34,20 @@ public:
         return result;
     }
     
+    /** Returns the stored value, or defaultValue if the key is missing */
+    template <typename T>
+    T getValue(const std::string& name, const T& defaultValue)
+    {
+        std::unordered_map<std::string, std::string>::iterator it = values.find(name);
+        if (it == values.end()) {
+            return defaultValue;
+        }
+        T result = defaultValue;
+        std::stringstream ss(it->second);
+        ss >> result;
+        return result;
+    }
+    
     void clear();
     bool load(const std::string& fileName);
     void save(const std::string& fileName);
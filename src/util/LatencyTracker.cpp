@@ -0,0 +1,171 @@
+#include "LatencyTracker.h"
+#include <algorithm>
+
+using namespace std;
+using namespace std::chrono;
+
+const double LatencyTracker::bucketMs = 2.0;
+
+namespace
+{
+	// samples needed before the latency estimate is seeded from their median
+	const size_t seedSamples = 16;
+
+	// how far each sample moves the running median, in milliseconds
+	const double medianStepMs = 0.1;
+}
+
+LatencyTracker& LatencyTracker::getInstance()
+{
+	static LatencyTracker tracker;
+	return tracker;
+}
+
+LatencyTracker::LatencyTracker() : enabled_(true), active_(false), expected_(0.0)
+{
+}
+
+const char* LatencyTracker::name(Stage stage)
+{
+	switch (stage) {
+	case POLL: return "Poll";
+	case INPUT: return "Input";
+	case SUBMIT: return "Submit";
+	case SWAP: return "Swap";
+	default: return "";
+	}
+}
+
+void LatencyTracker::enabled(bool enabled)
+{
+	enabled_ = enabled;
+	if (!enabled_) {
+		active_ = false;
+		for (Sample& s : pending_) {
+			glDeleteSync(s.fence);
+		}
+		pending_.clear();
+		samples_.clear();
+		expected_ = 0.0;
+	}
+}
+
+double LatencyTracker::since(steady_clock::time_point capture) const
+{
+	return duration_cast<duration<double, milli>>(steady_clock::now() - capture).count();
+}
+
+void LatencyTracker::polled(int64_t frameTimestamp, int64_t deviceNow)
+{
+	if (!enabled_) {
+		return;
+	}
+
+	// a sample that never reached a swap (nothing was drawn) is replaced by the newer frame
+	active_ = true;
+	current_.capture = steady_clock::now() - microseconds(max<int64_t>(0, deviceNow - frameTimestamp));
+	current_.fence = 0;
+	fill(current_.stages, current_.stages + NUM_OF_STAGES, -1.0);
+	current_.stages[POLL] = since(current_.capture);
+}
+
+void LatencyTracker::mark(Stage stage)
+{
+	if (active_) {
+		current_.stages[stage] = since(current_.capture);
+	}
+}
+
+void LatencyTracker::swapped()
+{
+	if (!active_) {
+		return;
+	}
+	active_ = false;
+
+	current_.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	pending_.push_back(current_);
+}
+
+void LatencyTracker::complete(Sample& sample)
+{
+	sample.stages[SWAP] = since(sample.capture);
+	glDeleteSync(sample.fence);
+	sample.fence = 0;
+
+	samples_.push_back(sample);
+	if (samples_.size() > maxSamples) {
+		samples_.pop_front();
+	}
+
+	// running median, so completing a sample doesn't sort the recent ones; each sample moves it one
+	// step towards itself, so a stalled frame counts no more than any other
+	if (expected_ > 0.0) {
+		expected_ = max(medianStepMs, expected_ + (sample.stages[SWAP] > expected_ ? medianStepMs : -medianStepMs));
+	} else if (samples_.size() >= seedSamples) {
+		expected_ = stats(SWAP).p50;
+	}
+}
+
+void LatencyTracker::collect()
+{
+	// fences signal in submission order
+	while (!pending_.empty()) {
+		GLenum result = glClientWaitSync(pending_.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		complete(pending_.front());
+		pending_.pop_front();
+	}
+}
+
+bool LatencyTracker::waitForSwap(double timeoutSeconds)
+{
+	if (pending_.empty()) {
+		return false;
+	}
+
+	GLuint64 timeout = static_cast<GLuint64>(timeoutSeconds * 1e9);
+	GLenum result = glClientWaitSync(pending_.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+	if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+		return false;
+	}
+
+	complete(pending_.front());
+	pending_.pop_front();
+	return true;
+}
+
+LatencyTracker::Stats LatencyTracker::stats(Stage stage) const
+{
+	vector<double> values;
+	values.reserve(samples_.size());
+	for (const Sample& s : samples_) {
+		if (s.stages[stage] >= 0.0)
+			values.push_back(s.stages[stage]);
+	}
+
+	Stats result = { 0.0, 0.0, 0.0, 0.0, values.size() };
+	if (values.empty()) {
+		return result;
+	}
+
+	sort(values.begin(), values.end());
+	auto percentile = [&](double p) { return values[min(values.size() - 1, static_cast<size_t>(p * values.size()))]; };
+	result.p50 = percentile(0.5);
+	result.p95 = percentile(0.95);
+	result.p99 = percentile(0.99);
+	result.max = values.back();
+	return result;
+}
+
+vector<unsigned> LatencyTracker::histogram() const
+{
+	vector<unsigned> buckets(numBuckets, 0);
+	for (const Sample& s : samples_) {
+		int bucket = static_cast<int>(s.stages[SWAP] / bucketMs);
+		buckets[min(max(bucket, 0), numBuckets - 1)]++;
+	}
+	return buckets;
+}
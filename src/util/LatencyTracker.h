@@ -0,0 +1,93 @@
+#ifndef __MEDLEAP_LATENCY_TRACKER__
+#define __MEDLEAP_LATENCY_TRACKER__
+
+#include "gl/glew.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/**
+ * Input-to-photon latency of Leap interactions (singleton). A sample starts when the main loop
+ * polls a new Leap frame and is stamped as it passes through input processing and draw
+ * submission; a fence inserted after the buffer swap marks when the GPU finished the frame
+ * that shows the input. All stages are measured from the frame's capture time on the device.
+ * Scanout adds up to one more refresh interval that can't be observed from GL.
+ */
+class LatencyTracker
+{
+public:
+	enum Stage { POLL, INPUT, SUBMIT, SWAP, NUM_OF_STAGES };
+
+	/** Latency distribution of one stage over the recent samples, in milliseconds */
+	struct Stats
+	{
+		double p50;
+		double p95;
+		double p99;
+		double max;
+		size_t count;
+	};
+
+	static LatencyTracker& getInstance();
+
+	/** Samples are ignored while disabled (enabled by default; Leap prediction uses the measured latency) */
+	bool enabled() const { return enabled_; }
+	void enabled(bool enabled);
+
+	/**
+	 * Starts a sample for a new Leap frame. Both times are in the device clock (microseconds),
+	 * which is converted to the host clock with the poll time.
+	 */
+	void polled(int64_t frameTimestamp, int64_t deviceNow);
+
+	/** Stamps the current sample (INPUT or SUBMIT) */
+	void mark(Stage stage);
+
+	/** Inserts a fence after the buffer swap; the sample completes once the fence signals */
+	void swapped();
+
+	/** Completes samples whose fences have signaled; call once per frame on the GL thread */
+	void collect();
+
+	/** Blocks until the oldest pending fence signals or the timeout expires. Returns true only if the fence signaled. */
+	bool waitForSwap(double timeoutSeconds);
+
+	/** Sorts the recent samples; meant for the overlay, not for every frame */
+	Stats stats(Stage stage) const;
+
+	/** Running median of the capture-to-swap latency in milliseconds; 0 until enough samples were collected */
+	double expectedLatency() const { return expected_; }
+
+	/** Number of recent samples per bucket of the capture-to-swap latency */
+	std::vector<unsigned> histogram() const;
+
+	/** Width of a histogram bucket in milliseconds */
+	static const double bucketMs;
+	static const int numBuckets = 50;
+
+	static const char* name(Stage stage);
+
+private:
+	struct Sample
+	{
+		std::chrono::steady_clock::time_point capture;
+		double stages[NUM_OF_STAGES]; // milliseconds since capture; negative if not reached
+		GLsync fence;
+	};
+
+	static const size_t maxSamples = 512;
+
+	LatencyTracker();
+	void complete(Sample& sample);
+	double since(std::chrono::steady_clock::time_point capture) const;
+
+	bool enabled_;
+	bool active_;
+	double expected_;
+	Sample current_;
+	std::deque<Sample> pending_;
+	std::deque<Sample> samples_;
+};
+
+#endif // __MEDLEAP_LATENCY_TRACKER__
@@ -0,0 +1,56 @@
+#ifndef __MEDLEAP_UTIL_PARALLEL_H__
+#define __MEDLEAP_UTIL_PARALLEL_H__
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/** Number of worker threads used for data-parallel work (hardware threads, at least 1) */
+inline unsigned workerCount()
+{
+	unsigned n = std::thread::hardware_concurrency();
+	return n == 0 ? 4 : n;
+}
+
+/**
+ * Splits [begin, end) into contiguous ranges and calls fn(threadIndex, rangeBegin, rangeEnd)
+ * on each range from its own thread. Blocks until all ranges are processed. The calling thread
+ * processes the last range itself.
+ */
+template <typename Fn>
+void parallelFor(size_t begin, size_t end, unsigned numThreads, Fn fn)
+{
+	if (end <= begin) {
+		return;
+	}
+
+	size_t count = end - begin;
+	numThreads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(numThreads, count)));
+	size_t perThread = count / numThreads;
+	size_t remainder = count % numThreads;
+
+	std::vector<std::thread> threads;
+	size_t start = begin;
+	for (unsigned i = 0; i < numThreads; i++) {
+		size_t stop = start + perThread + (i < remainder ? 1 : 0);
+		if (i == numThreads - 1) {
+			fn(i, start, stop);
+		} else {
+			threads.push_back(std::thread(fn, i, start, stop));
+		}
+		start = stop;
+	}
+
+	for (std::thread& t : threads) {
+		t.join();
+	}
+}
+
+/** Same as parallelFor(begin, end, workerCount(), fn) */
+template <typename Fn>
+void parallelFor(size_t begin, size_t end, Fn fn)
+{
+	parallelFor(begin, end, workerCount(), fn);
+}
+
+#endif // __MEDLEAP_UTIL_PARALLEL_H__
@@ -0,0 +1,251 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+	// weight of the newest sample in the smoothed timings
+	const double smoothing = 0.1;
+
+	string escape(const string& s)
+	{
+		string result;
+		for (char c : s) {
+			if (c == '"' || c == '\\')
+				result += '\\';
+			result += c;
+		}
+		return result;
+	}
+}
+
+Profiler::Scope::Scope(const string& name, bool gpu) : active_(false), gpu_(false)
+{
+	Profiler& profiler = Profiler::getInstance();
+	if (!profiler.enabled()) {
+		return;
+	}
+
+	name_ = name;
+	active_ = true;
+	gpu_ = gpu;
+	if (gpu_) {
+		queries_[0] = profiler.query();
+		queries_[1] = profiler.query();
+		glQueryCounter(queries_[0], GL_TIMESTAMP);
+	}
+	start_ = high_resolution_clock::now();
+}
+
+Profiler::Scope::~Scope()
+{
+	if (!active_) {
+		return;
+	}
+
+	Profiler& profiler = Profiler::getInstance();
+	if (gpu_) {
+		glQueryCounter(queries_[1], GL_TIMESTAMP);
+	}
+	double cpuTime = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start_).count();
+	uint64_t serial = profiler.record(name_, start_, cpuTime);
+	if (gpu_) {
+		profiler.recordGpu(serial, queries_[0], queries_[1]);
+	}
+}
+
+Profiler& Profiler::getInstance()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler() : enabled_(false), epoch_(high_resolution_clock::now()), firstSerial_(0)
+{
+}
+
+void Profiler::enabled(bool enabled)
+{
+	enabled_ = enabled;
+}
+
+GLuint Profiler::query()
+{
+	if (freeQueries_.empty()) {
+		GLuint ids[32];
+		glGenQueries(32, ids);
+		freeQueries_.insert(freeQueries_.end(), ids, ids + 32);
+	}
+	GLuint id = freeQueries_.back();
+	freeQueries_.pop_back();
+	return id;
+}
+
+uint64_t Profiler::record(const string& name, high_resolution_clock::time_point start, double cpuTime)
+{
+	lock_guard<mutex> lock(mutex_);
+
+	auto thread = threads_.find(this_thread::get_id());
+	if (thread == threads_.end()) {
+		thread = threads_.insert(make_pair(this_thread::get_id(), (unsigned)threads_.size())).first;
+	}
+
+	Event e;
+	e.name = name;
+	e.thread = thread->second;
+	e.start = duration_cast<duration<double, micro>>(start - epoch_).count();
+	e.cpuTime = cpuTime;
+	e.gpuTime = -1.0;
+	events_.push_back(e);
+	if (events_.size() > maxEvents) {
+		events_.pop_front();
+		firstSerial_++;
+	}
+
+	smooth(name, cpuTime / 1000.0, -1.0);
+	return firstSerial_ + events_.size() - 1;
+}
+
+void Profiler::recordGpu(uint64_t serial, GLuint begin, GLuint end)
+{
+	PendingQuery q = { begin, end, serial };
+	pending_.push_back(q);
+}
+
+void Profiler::beginFrame()
+{
+	// collect only the queries that already finished; the rest are checked next frame
+	auto it = pending_.begin();
+	while (it != pending_.end()) {
+		GLint available = 0;
+		glGetQueryObjectiv(it->end, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			++it;
+			continue;
+		}
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(it->begin, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(it->end, GL_QUERY_RESULT, &end);
+		double gpuTime = (end - begin) / 1000.0;
+
+		{
+			lock_guard<mutex> lock(mutex_);
+			if (it->serial >= firstSerial_) {
+				Event& e = events_[(size_t)(it->serial - firstSerial_)];
+				e.gpuTime = gpuTime;
+				smooth(e.name, -1.0, gpuTime / 1000.0);
+			}
+		}
+
+		freeQueries_.push_back(it->begin);
+		freeQueries_.push_back(it->end);
+		it = pending_.erase(it);
+	}
+}
+
+void Profiler::smooth(const string& name, double cpuMs, double gpuMs)
+{
+	auto it = summaries_.find(name);
+	if (it == summaries_.end()) {
+		Summary s = { name, max(cpuMs, 0.0), gpuMs };
+		summaries_[name] = s;
+		return;
+	}
+
+	Summary& s = it->second;
+	if (cpuMs >= 0.0)
+		s.cpuMs += (cpuMs - s.cpuMs) * smoothing;
+	if (gpuMs >= 0.0)
+		s.gpuMs = (s.gpuMs < 0.0) ? gpuMs : s.gpuMs + (gpuMs - s.gpuMs) * smoothing;
+}
+
+vector<Profiler::Summary> Profiler::summary() const
+{
+	vector<Summary> result;
+	{
+		lock_guard<mutex> lock(mutex_);
+		for (auto& entry : summaries_)
+			result.push_back(entry.second);
+	}
+
+	sort(result.begin(), result.end(), [](const Summary& a, const Summary& b) {
+		return a.cpuMs > b.cpuMs;
+	});
+	return result;
+}
+
+bool Profiler::exportChromeTrace(const string& fileName) const
+{
+	ofstream out(fileName.c_str());
+	if (!out) {
+		return false;
+	}
+
+	// GPU timings are shown on their own track, aligned with the start of the CPU scope
+	const unsigned gpuTrack = 1000;
+
+	lock_guard<mutex> lock(mutex_);
+	out << "{\"traceEvents\":[" << endl;
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << gpuTrack << ",\"args\":{\"name\":\"GPU\"}}";
+	for (const Event& e : events_) {
+		string name = escape(e.name);
+		out << "," << endl << "{\"name\":\"" << name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+			<< ",\"ts\":" << e.start << ",\"dur\":" << e.cpuTime << "}";
+		if (e.gpuTime >= 0.0) {
+			out << "," << endl << "{\"name\":\"" << name << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << gpuTrack
+				<< ",\"ts\":" << e.start << ",\"dur\":" << e.gpuTime << "}";
+		}
+	}
+	out << endl << "]}" << endl;
+
+	return out.good();
+}
+
+string Profiler::typeName(const type_info& type)
+{
+	// names are requested every frame, so demangle each type only once
+	static mutex cacheMutex;
+	static map<string, string> cache;
+	lock_guard<mutex> lock(cacheMutex);
+
+	string& cached = cache[type.name()];
+	if (!cached.empty()) {
+		return cached;
+	}
+
+	string name = type.name();
+
+#ifdef __GNUC__
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+	if (status == 0 && demangled) {
+		name = demangled;
+	}
+	free(demangled);
+#else
+	// MSVC names look like "class VolumeController"
+	size_t space = name.find(' ');
+	if (space != string::npos) {
+		name = name.substr(space + 1);
+	}
+#endif
+
+	cached = name;
+	return name;
+}
+
+string Profiler::scopeName(const type_info& type, const char* suffix)
+{
+	if (!getInstance().enabled()) {
+		return string();
+	}
+	return typeName(type) + suffix;
+}
@@ -0,0 +1,106 @@
+#ifndef __MEDLEAP_PROFILER__
+#define __MEDLEAP_PROFILER__
+
+#include "gl/glew.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+/**
+ * Frame profiler (singleton). Scopes record their CPU time and, on the GL thread, their GPU
+ * time from a pair of timestamp queries. Query results are collected frames later, only when
+ * they are available, so profiling never stalls the pipeline. Recent events are kept in a ring
+ * buffer that can be exported as a Chrome trace (chrome://tracing).
+ */
+class Profiler
+{
+public:
+	/** One completed scope */
+	struct Event
+	{
+		std::string name;
+		unsigned thread;  // 0 = first thread to record an event (the GL thread)
+		double start;     // microseconds since the profiler was created
+		double cpuTime;   // microseconds
+		double gpuTime;   // microseconds; negative if not measured or not available yet
+	};
+
+	/** Smoothed timings of all scopes with the same name */
+	struct Summary
+	{
+		std::string name;
+		double cpuMs;
+		double gpuMs;  // negative if never measured
+	};
+
+	/** Times the enclosing block. GPU timing must only be requested on the GL thread. */
+	class Scope
+	{
+	public:
+		Scope(const std::string& name, bool gpu = false);
+		~Scope();
+
+	private:
+		std::string name_;
+		std::chrono::high_resolution_clock::time_point start_;
+		GLuint queries_[2];
+		bool active_;
+		bool gpu_;
+	};
+
+	static Profiler& getInstance();
+
+	/** Scopes are ignored while disabled */
+	bool enabled() const { return enabled_; }
+	void enabled(bool enabled);
+
+	/** Collects finished GPU queries; call once per frame on the GL thread */
+	void beginFrame();
+
+	/** Smoothed timings sorted by CPU time (largest first) */
+	std::vector<Summary> summary() const;
+
+	/** Writes the recorded events as Chrome trace JSON. Returns false if the file can't be written. */
+	bool exportChromeTrace(const std::string& fileName) const;
+
+	/** Readable class name from RTTI (ex. "VolumeController") */
+	static std::string typeName(const std::type_info& type);
+
+	/** Scope name for a type (ex. "VolumeController::update"); empty while disabled, so per-frame scopes don't build names */
+	static std::string scopeName(const std::type_info& type, const char* suffix);
+
+private:
+	struct PendingQuery
+	{
+		GLuint begin;
+		GLuint end;
+		uint64_t serial;
+	};
+
+	static const size_t maxEvents = 20000;
+
+	Profiler();
+
+	std::atomic<bool> enabled_;  // toggled on the GL thread, read by worker threads
+	std::chrono::high_resolution_clock::time_point epoch_;
+	mutable std::mutex mutex_;
+	std::deque<Event> events_;
+	uint64_t firstSerial_;
+	std::map<std::string, Summary> summaries_;
+	std::map<std::thread::id, unsigned> threads_;
+	std::vector<GLuint> freeQueries_;
+	std::vector<PendingQuery> pending_;
+
+	uint64_t record(const std::string& name, std::chrono::high_resolution_clock::time_point start, double cpuTime);
+	void recordGpu(uint64_t serial, GLuint begin, GLuint end);
+	GLuint query();
+	void smooth(const std::string& name, double cpuMs, double gpuMs);
+};
+
+#endif // __MEDLEAP_PROFILER__
@@ -0,0 +1,60 @@
+#ifndef __MEDLEAP_SPSC_QUEUE_H__
+#define __MEDLEAP_SPSC_QUEUE_H__
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread. push() fails
+ * instead of overwriting when the queue is full, so the consumer always sees elements in order.
+ */
+template <typename T, std::size_t capacity> class SpscQueue
+{
+public:
+	SpscQueue() : head_(0), tail_(0) {}
+
+	/** Producer: appends an element; returns false if the queue is full */
+	bool push(const T& t)
+	{
+		std::size_t tail = tail_.load(std::memory_order_relaxed);
+		std::size_t next = (tail + 1) % slots;
+		if (next == head_.load(std::memory_order_acquire)) {
+			return false;
+		}
+		elements_[tail] = t;
+		tail_.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/** Consumer: removes the oldest element; returns false if the queue is empty */
+	bool pop(T& t)
+	{
+		std::size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire)) {
+			return false;
+		}
+		t = elements_[head];
+		elements_[head] = T();
+		head_.store((head + 1) % slots, std::memory_order_release);
+		return true;
+	}
+
+	/** Approximate number of queued elements (exact from either thread for its own operations) */
+	std::size_t size() const
+	{
+		std::size_t head = head_.load(std::memory_order_acquire);
+		std::size_t tail = tail_.load(std::memory_order_acquire);
+		return (tail + slots - head) % slots;
+	}
+
+private:
+	// one slot stays empty to tell a full queue from an empty one
+	static const std::size_t slots = capacity + 1;
+
+	T elements_[slots];
+	std::atomic<std::size_t> head_;
+	char padding_[64]; // keeps the producer and consumer indices on separate cache lines
+	std::atomic<std::size_t> tail_;
+};
+
+#endif // __MEDLEAP_SPSC_QUEUE_H__
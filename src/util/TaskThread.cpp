@@ -0,0 +1,61 @@
+#include "TaskThread.h"
+
+using namespace std;
+
+TaskThread::TaskThread() : generation_(0), busy_(false), stop_(false)
+{
+	thread_ = thread(&TaskThread::run, this);
+}
+
+TaskThread::~TaskThread()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		stop_ = true;
+		pending_ = nullptr;
+		generation_++;
+	}
+	wake_.notify_one();
+	thread_.join();
+}
+
+void TaskThread::post(Task task)
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		pending_ = task;
+		generation_++;
+		busy_ = true;
+	}
+	wake_.notify_one();
+}
+
+void TaskThread::cancel()
+{
+	lock_guard<mutex> lock(mutex_);
+	pending_ = nullptr;
+	generation_++;
+}
+
+void TaskThread::run()
+{
+	unique_lock<mutex> lock(mutex_);
+	while (true) {
+		wake_.wait(lock, [this] { return stop_ || pending_; });
+		if (stop_) {
+			return;
+		}
+
+		Task task = pending_;
+		pending_ = nullptr;
+		unsigned generation = generation_;
+
+		lock.unlock();
+		task([this, generation] { return generation_ != generation; });
+		lock.lock();
+
+		if (!pending_) {
+			busy_ = false;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef __MEDLEAP_TASK_THREAD__
+#define __MEDLEAP_TASK_THREAD__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * A thread that runs one task at a time. Only the newest task matters: posting a task replaces
+ * one that hasn't started yet and cancels the one that is running. Tasks receive a function that
+ * returns true once they have been cancelled and should poll it between units of work.
+ */
+class TaskThread
+{
+public:
+	typedef std::function<bool()> Cancelled;
+	typedef std::function<void(const Cancelled& cancelled)> Task;
+
+	TaskThread();
+
+	/** Cancels the current task and waits for it to return */
+	~TaskThread();
+
+	/** Runs task after the current one returns; the current and any waiting task are cancelled */
+	void post(Task task);
+
+	/** Cancels the running task and drops a waiting one */
+	void cancel();
+
+	/** True while a task is waiting or running */
+	bool busy() const { return busy_; }
+
+private:
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	Task pending_;
+	std::atomic<unsigned> generation_;
+	std::atomic<bool> busy_;
+	bool stop_;
+
+	void run();
+};
+
+#endif // __MEDLEAP_TASK_THREAD__
@@ -1,6 +1,8 @@
 #include "TextRenderer.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 using namespace gl;
 using namespace std;
@@ -35,29 +37,47 @@ void main()\n\
 // texture coordinate stepping based on a 16x16 grid of glyphs
 static const float GLYPH_STEP = 0.0625f;
 
-TextRenderer::TextRenderer() : font_(nullptr), dirty_(true)
+TextRenderer::TextRenderer() : vbo_capacity_(0), font_(nullptr), dirty_(true), vertex_count_(0)
 {
 }
 
 TextRenderer::~TextRenderer()
 {
-    for (map<string, Font*>::iterator it = fonts.begin(); it != fonts.end(); it++) {
-        delete it->second;
-    }
 }
 
-bool TextRenderer::loadFont(const std::string& fontName)
+Program& TextRenderer::program()
+{
+	static Program prog = Program::createFromSrc(vSrc, fSrc);
+	return prog;
+}
+
+TextRenderer::Font* TextRenderer::cachedFont(const std::string& fontName)
 {
-	if (!prog_.id()) {
-		prog_ = Program::createFromSrc(vSrc, fSrc);
+	// fonts are loaded once and shared by all renderers for the lifetime of the application
+	static map<string, unique_ptr<Font>> cache;
+
+	auto it = cache.find(fontName);
+	if (it != cache.end()) {
+		return it->second.get();
 	}
 
 	std::string bmpFileName = std::string("fonts/" + fontName + ".bmp");
 	std::string metricsFileName = std::string("fonts/" + fontName + ".dat");
 
-	Font* font = new Font;
+	unique_ptr<Font> font(new Font);
 	if (!font->load(bmpFileName.c_str(), metricsFileName.c_str())) {
-		delete font;
+		return nullptr;
+	}
+
+	Font* result = font.get();
+	cache[fontName] = std::move(font);
+	return result;
+}
+
+bool TextRenderer::loadFont(const std::string& fontName)
+{
+	Font* font = cachedFont(fontName);
+	if (!font) {
 		return false;
 	}
 
@@ -67,7 +87,7 @@ bool TextRenderer::loadFont(const std::string& fontName)
 		dirty_ = true;
 	}
 
-	return (font != 0);
+	return true;
 }
 
 void TextRenderer::font(const std::string& fontName)
@@ -93,13 +113,13 @@ void TextRenderer::viewport(const Viewport& viewport)
 
 void TextRenderer::add(const std::string& text, float x, float y)
 {
-	labels_.push_back({ text, { x, y }, draw_state_ });
-	dirty_ = true;
+	add(text, Vec2(x, y));
 }
 
 void TextRenderer::add(const std::string& text, const Vec2& position)
 {
-	labels_.push_back({ text, position, draw_state_ });
+	Label label = { text, position, draw_state_, nullptr, 0, 0 };
+	labels_.push_back(label);
 	dirty_ = true;
 }
 
@@ -121,8 +141,9 @@ void TextRenderer::draw()
 
 	viewport_.apply();
 
-	prog_.enable();
-	prog_.uniform("model_projection", model_projection_);
+	Program& prog = program();
+	prog.enable();
+	prog.uniform("model_projection", model_projection_);
 
 	vbo_.bind();
 	font_->texture.bind();
@@ -142,70 +163,126 @@ void TextRenderer::draw()
 }
 
 void TextRenderer::buffer()
+{
+	next_vertices_.clear();
+
+	for (size_t i = 0; i < labels_.size(); i++) {
+		Label& label = labels_[i];
+		label.font = font_;
+		size_t first = next_vertices_.size();
+
+		// reuse the vertices of an identical label from the previous buffer
+		const Label* old = (i < buffered_.size()) ? &buffered_[i] : nullptr;
+		bool same = old && old->text == label.text && old->font == label.font &&
+			old->position.x == label.position.x && old->position.y == label.position.y &&
+			old->draw_state.color.x == label.draw_state.color.x && old->draw_state.color.y == label.draw_state.color.y &&
+			old->draw_state.color.z == label.draw_state.color.z && old->draw_state.color.w == label.draw_state.color.w &&
+			old->draw_state.h_align == label.draw_state.h_align && old->draw_state.v_align == label.draw_state.v_align;
+
+		if (same) {
+			next_vertices_.insert(next_vertices_.end(), vertices_.begin() + old->first, vertices_.begin() + old->first + old->count);
+		} else {
+			tessellate(label, next_vertices_);
+		}
+
+		label.first = first;
+		label.count = next_vertices_.size() - first;
+	}
+
+	upload();
+
+	buffered_ = labels_;
+	vertices_.swap(next_vertices_);
+	vertex_count_ = static_cast<GLsizei>(vertices_.size() / 8);
+	dirty_ = false;
+}
+
+void TextRenderer::upload()
 {
 	if (!vbo_.id()) {
 		vbo_.generateVBO(GL_DYNAMIC_DRAW);
 	}
 
-	vertex_count_ = 0;
-	vector<GLfloat> vertices;
-
-	for (const Label& label : labels_) {
-
-		auto vertex = [&](float x, float y, float u, float v) {
-			vertices.push_back(x);
-			vertices.push_back(y);
-			vertices.push_back(u);
-			vertices.push_back(v);
-			vertices.push_back(label.draw_state.color.x);
-			vertices.push_back(label.draw_state.color.y);
-			vertices.push_back(label.draw_state.color.z);
-			vertices.push_back(label.draw_state.color.w);
-			vertex_count_++;
-		};
-
-		float x = label.position.x;
-		float y = label.position.y;
-
-		if (label.draw_state.h_align == HAlign::center) {
-			x -= font_->width(label.text) / 2;
-		} else if (label.draw_state.h_align == HAlign::right) {
-			x -= font_->width(label.text);
-		}
+	const vector<GLfloat>& next = next_vertices_;
+	GLsizeiptr size = next.size() * sizeof(GLfloat);
+	if (size == 0) {
+		return;
+	}
+
+	vbo_.bind();
+
+	// grow the storage geometrically so appending labels doesn't reallocate every frame
+	if (size > vbo_capacity_) {
+		vbo_capacity_ = std::max(size, vbo_capacity_ * 2);
+		vbo_.data(nullptr, vbo_capacity_);
+		vbo_.subData(&next[0], size, 0);
+		return;
+	}
 
-		if (label.draw_state.v_align == VAlign::center) {
-			y -= font_->glyphHeight / 2;
-		} else if (label.draw_state.v_align == VAlign::top) {
-			y -= font_->glyphHeight;
+	// only the range that differs from what the buffer already holds is uploaded
+	size_t common = std::min(next.size(), vertices_.size());
+	size_t begin = 0;
+	while (begin < common && next[begin] == vertices_[begin]) {
+		begin++;
+	}
+	size_t end = next.size();
+	if (next.size() == vertices_.size()) {
+		while (end > begin && next[end - 1] == vertices_[end - 1]) {
+			end--;
 		}
+	}
 
-		for (const char& c : label.text) {
-			int glyphWidth = font_->glyphWidths[static_cast<unsigned>(c)];
-			int glyphHeight = font_->glyphHeight;
+	if (end > begin) {
+		vbo_.subData(&next[begin], (end - begin) * sizeof(GLfloat), begin * sizeof(GLfloat));
+	}
+}
 
-			GLfloat u = GLYPH_STEP * (c % 16);
-			GLfloat v = 1.0f - GLYPH_STEP * (c / 16 + 1);
-			float uStep = (float)glyphWidth / font_->texture.width();
+void TextRenderer::tessellate(const Label& label, vector<GLfloat>& vertices) const
+{
+	const Font* font = label.font;
+	if (!font) {
+		return;
+	}
 
-			vertex(x, y, u, v);
-			vertex(x + glyphWidth, y, u + uStep, v);
-			vertex(x + glyphWidth, y + glyphHeight, u + uStep, v + GLYPH_STEP);
+	auto vertex = [&](float x, float y, float u, float v) {
+		const Vec4& c = label.draw_state.color;
+		GLfloat values[] = { x, y, u, v, c.x, c.y, c.z, c.w };
+		vertices.insert(vertices.end(), values, values + 8);
+	};
 
-			vertex(x, y, u, v);
-			vertex(x + glyphWidth, y + glyphHeight, u + uStep, v + GLYPH_STEP);
-			vertex(x, y + glyphHeight, u, v + GLYPH_STEP);
+	float x = label.position.x;
+	float y = label.position.y;
 
-			x += glyphWidth;
-		}
+	if (label.draw_state.h_align == HAlign::center) {
+		x -= label.font->width(label.text) / 2;
+	} else if (label.draw_state.h_align == HAlign::right) {
+		x -= label.font->width(label.text);
 	}
 
-	vbo_.bind();
-
-	if (!vertices.empty()) {
-		vbo_.data(&vertices[0], vertices.size() * sizeof(GLfloat));
+	if (label.draw_state.v_align == VAlign::center) {
+		y -= font->glyphHeight / 2;
+	} else if (label.draw_state.v_align == VAlign::top) {
+		y -= font->glyphHeight;
 	}
 
-	dirty_ = false;
+	for (const char& c : label.text) {
+		int glyphWidth = font->glyphWidths[static_cast<unsigned>(c)];
+		int glyphHeight = font->glyphHeight;
+
+		GLfloat u = GLYPH_STEP * (c % 16);
+		GLfloat v = 1.0f - GLYPH_STEP * (c / 16 + 1);
+		float uStep = (float)glyphWidth / font->texture.width();
+
+		vertex(x, y, u, v);
+		vertex(x + glyphWidth, y, u + uStep, v);
+		vertex(x + glyphWidth, y + glyphHeight, u + uStep, v + GLYPH_STEP);
+
+		vertex(x, y, u, v);
+		vertex(x + glyphWidth, y + glyphHeight, u + uStep, v + GLYPH_STEP);
+		vertex(x, y + glyphHeight, u, v + GLYPH_STEP);
+
+		x += glyphWidth;
+	}
 }
 
 int TextRenderer::fontHeight()
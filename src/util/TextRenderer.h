@@ -10,6 +10,13 @@
 #include <vector>
 #include <map>
 
+/**
+ * Draws strings with bitmap fonts. Labels are retained between frames: callers may clear and
+ * re-add the same labels every frame, and only labels whose string, font, color, alignment or
+ * position changed are tessellated again. The vertex buffer keeps its storage and receives only
+ * the byte range that differs from the previous frame. The shader program and font textures are
+ * shared by all renderers.
+ */
 class TextRenderer
 {
 public:
@@ -85,11 +92,16 @@ private:
 		VAlign v_align;
 	};
     
+	class Font;
+
 	struct Label
 	{
 		std::string text;
 		gl::Vec2 position;
 		DrawState draw_state;
+		Font* font;    // font the label was tessellated with
+		size_t first;  // first float in the vertex array
+		size_t count;  // number of floats
 	};
 
     class Font
@@ -107,16 +119,23 @@ private:
 	gl::Mat4 model_projection_;
 	gl::Viewport viewport_;
 	std::vector<Label> labels_;
+	std::vector<Label> buffered_;
+	std::vector<GLfloat> vertices_;
+	std::vector<GLfloat> next_vertices_;
 	DrawState draw_state_;
-    gl::Program prog_;
 	gl::Buffer vbo_;
+	GLsizeiptr vbo_capacity_;
     std::map<std::string, Font*> fonts;
     Font* font_;
-    int windowWidth, windowHeight;
 	bool dirty_;
 	GLsizei vertex_count_;
     
 	void buffer();
+	void tessellate(const Label& label, std::vector<GLfloat>& vertices) const;
+	void upload();
+
+	static gl::Program& program();
+	static Font* cachedFont(const std::string& fontName);
 };
 
 #endif // __MEDLEAP_TEXT_RENDERER__
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "WorkerPool.h"
+
+using namespace std;
+
+WorkerPool::WorkerPool(unsigned numThreads) : running_(0), stop_(false)
+{
+	for (unsigned i = 0; i < numThreads; i++) {
+		threads_.push_back(thread(&WorkerPool::run, this));
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		stop_ = true;
+		jobs_.clear();
+	}
+	wake_.notify_all();
+	for (thread& t : threads_) {
+		t.join();
+	}
+}
+
+void WorkerPool::post(Job job)
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		jobs_.push_back(job);
+	}
+	wake_.notify_one();
+}
+
+void WorkerPool::clear()
+{
+	lock_guard<mutex> lock(mutex_);
+	jobs_.clear();
+}
+
+size_t WorkerPool::pending() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return jobs_.size() + running_;
+}
+
+void WorkerPool::run()
+{
+	unique_lock<mutex> lock(mutex_);
+	while (true) {
+		wake_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+		if (stop_) {
+			return;
+		}
+
+		Job job = jobs_.front();
+		jobs_.pop_front();
+		running_++;
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		running_--;
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef __MEDLEAP_WORKER_POOL__
+#define __MEDLEAP_WORKER_POOL__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of threads that run queued jobs in the order they were posted. Jobs that haven't
+ * started can be dropped with clear() when their results are no longer wanted.
+ */
+class WorkerPool
+{
+public:
+	typedef std::function<void()> Job;
+
+	explicit WorkerPool(unsigned numThreads);
+
+	/** Drops queued jobs and waits for the running ones */
+	~WorkerPool();
+
+	void post(Job job);
+
+	/** Drops all jobs that haven't started */
+	void clear();
+
+	/** Number of jobs queued or running */
+	size_t pending() const;
+
+private:
+	std::vector<std::thread> threads_;
+	mutable std::mutex mutex_;
+	std::condition_variable wake_;
+	std::deque<Job> jobs_;
+	size_t running_;
+	bool stop_;
+
+	void run();
+};
+
+#endif // __MEDLEAP_WORKER_POOL__